@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Native extension used by JsBridgeTest.testNativeExtension(), registering the JS object
+// "testNative" via the C API of jsbridge_native_extension.h
+
+#include "extensions/jsbridge_native_extension.h"
+#include <stdio.h>
+
+static void add(JsBridgeNativeCall *call, void *userData) {
+  const JsBridgeNativeApi *api = (const JsBridgeNativeApi *) userData;
+  api->returnDouble(call, api->getDouble(call, 0) + api->getDouble(call, 1));
+}
+
+static void greet(JsBridgeNativeCall *call, void *userData) {
+  const JsBridgeNativeApi *api = (const JsBridgeNativeApi *) userData;
+
+  size_t length = 0;
+  const char *name = api->getString(call, 0, &length);
+  if (name == NULL) {
+    api->throwError(call, "Expected a string");
+    return;
+  }
+
+  char greeting[128];
+  const int greetingLength = snprintf(greeting, sizeof(greeting), "Hello %.*s!", (int) length, name);
+  api->returnString(call, greeting, greetingLength < (int) sizeof(greeting) ? (size_t) greetingLength : sizeof(greeting) - 1);
+}
+
+static void sumBytes(JsBridgeNativeCall *call, void *userData) {
+  const JsBridgeNativeApi *api = (const JsBridgeNativeApi *) userData;
+
+  size_t byteLength = 0;
+  const uint8_t *bytes = (const uint8_t *) api->getBuffer(call, 0, &byteLength);
+  if (bytes == NULL) {
+    api->throwError(call, "Expected an ArrayBuffer or a typed array");
+    return;
+  }
+
+  int32_t sum = 0;
+  for (size_t i = 0; i < byteLength; ++i) {
+    sum += bytes[i];
+  }
+  api->returnInt32(call, sum);
+}
+
+static void fail(JsBridgeNativeCall *call, void *userData) {
+  const JsBridgeNativeApi *api = (const JsBridgeNativeApi *) userData;
+  api->throwError(call, "Native failure");
+}
+
+JSBRIDGE_NATIVE_EXPORT int JsBridge_initNativeExtension(const JsBridgeNativeApi *api, JsBridgeNativeContext *ctx) {
+  if (api->version < JSBRIDGE_NATIVE_API_VERSION) {
+    return -1;
+  }
+
+  if (api->registerFunction(ctx, "testNative", "add", add, 2, (void *) api, NULL) != 0
+      || api->registerFunction(ctx, "testNative", "greet", greet, 1, (void *) api, NULL) != 0
+      || api->registerFunction(ctx, "testNative", "sumBytes", sumBytes, 1, (void *) api, NULL) != 0
+      || api->registerFunction(ctx, "testNative", "fail", fail, 0, (void *) api, NULL) != 0) {
+    return -1;
+  }
+  return 0;
+}
@@ -15,6 +15,7 @@
  */
 package de.prosiebensat1digital.oasisjsbridge
 
+import android.content.ComponentCallbacks2
 import android.content.Context
 import android.util.Log
 import androidx.test.platform.app.InstrumentationRegistry
@@ -22,6 +23,7 @@ import io.mockk.Ordering
 import io.mockk.every
 import io.mockk.mockk
 import io.mockk.verify
+import java.util.Collections
 import kotlinx.coroutines.*
 import okhttp3.OkHttpClient
 import org.junit.After
@@ -396,6 +398,45 @@ class JsBridgeTest {
         }
     }
 
+    @Test
+    fun testSourceMap() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val sourceMap = """
+            |{
+            |  "version": 3,
+            |  "sourceRoot": "src",
+            |  "sources": ["original.js"],
+            |  "names": ["throwError"],
+            |  "mappings": ";AAKAA;AAAA,IACA"
+            |}
+            """.trimMargin()
+
+        // WHEN
+        val (jsException, ambiguousJsException) = runBlocking {
+            subject.registerSourceMap("bundle.min.js", sourceMap)
+            subject.evaluateFileContent("\nfunction f() { throw new Error('minified'); }\nfunction g() { throw new Error('merged'); }", "bundle.min.js")
+            Pair<JsException, JsException>(
+                assertFailsWith { subject.evaluate<Unit>("f()") },
+                assertFailsWith { subject.evaluate<Unit>("g()") }
+            )
+        }
+
+        // THEN
+        jsException.stackTrace[0].let { e ->
+            assertEquals("src/original.js", e.fileName)
+            assertEquals(6, e.lineNumber)
+            assertEquals("throwError", e.methodName)
+        }
+        // Line 3 maps to 2 original lines: without column in the stack trace, it is not resolved
+        ambiguousJsException.stackTrace[0].let { e ->
+            assertEquals("bundle.min.js", e.fileName)
+            assertEquals(3, e.lineNumber)
+        }
+        assertFailsWith<IllegalArgumentException> { runBlocking { subject.registerSourceMap("invalid.js", "{}") } }
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testEvaluateFileContent() {
         // GIVEN
@@ -596,6 +637,51 @@ class JsBridgeTest {
         assertEquals("non-existing.js", rootCause.fileName)
     }
 
+    @Test
+    fun testSetJsModuleLoaderWithPrefetch() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // ES6 modules are not supported on Duktape
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val modules = mapOf(
+            "app/a.js" to """import { c } from "./lib/c.js"; export const a = "A" + c;""",
+            "app/b.js" to """export * from "../shared/b.js";""",
+            "app/lib/c.js" to """export const c = "C";""",
+            "shared/b.js" to """export const b = "B";""",
+            "lazy.js" to """export const value = "LAZY";"""
+        )
+        val loadedModuleNames = Collections.synchronizedList(mutableListOf<String>())
+
+        // WHEN
+        subject.setJsModuleLoader(prefetch = true) { moduleName ->
+            loadedModuleNames.add(moduleName)
+            Thread.sleep(50)  // e.g. network
+            modules[moduleName] ?: throw JsBridgeError.JsFileEvaluationError(moduleName)
+        }
+
+        val (ret, lazyRet) = runBlocking {
+            subject.evaluateFileContent("""
+                    import { a } from "./a.js";
+                    import { b } from './b.js';
+                    globalThis.entryPoint = function() { return a + b; };
+                    const lazyValue = import("lazy.js").then(m => m.value);  // imported before the evaluation is over
+                    globalThis.loadLazy = function() { return lazyValue; };
+                """.trimIndent(), "app/main.js", JsBridge.JsFileEvaluationType.Module)
+
+            subject.evaluate<String>("globalThis.entryPoint()") to subject.evaluate<String>("globalThis.loadLazy()")
+        }
+
+        // THEN
+        assertEquals("ACB", ret)
+        assertEquals("LAZY", lazyRet)
+        assertEquals(modules.keys, loadedModuleNames.toSet())
+        assertEquals(modules.size, loadedModuleNames.size)  // each module is only loaded once
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testJsValue() {
         // GIVEN
@@ -991,6 +1077,9 @@ class JsBridgeTest {
             val jsArrayNullableByte = JsValue.fromJavaValue(subject, arrayOf(1.toByte(), null, 3.toByte()))
             assertArrayEquals(byteArrayOf(1, 2, 3), jsArrayByte.evaluate())
             assertArrayEquals(arrayOf(1.toByte(), null, 3.toByte()), jsArrayNullableByte.evaluate<Array<Byte?>>())
+            val jsUint8Array = JsValue.fromJavaValue(subject, byteArrayOf(1, -1))
+            assertEquals("[object Uint8Array]:255", subject.evaluate<String>("Object.prototype.toString.call($jsUint8Array) + ':' + $jsUint8Array[1]"))
+            assertArrayEquals(byteArrayOf(1, -1), jsUint8Array.evaluate())
 
             val jsArrayInt = JsValue.fromJavaValue(subject, intArrayOf(1, 2, 3))
             val jsArrayNullableInt = JsValue.fromJavaValue(subject, arrayOf(1, null, 3))
@@ -2728,6 +2817,77 @@ class JsBridgeTest {
         assertTrue(errors.isEmpty())
     }
 
+    @Test
+    fun testXmlHttpRequest_deduplicationAndCache() {
+        // GIVEN
+        val server = TestHttpServer("cached content", mapOf("Cache-Control" to "max-age=60", "ETag" to "\"v1\""), 300L)
+        val cacheDirectory = java.io.File(context.cacheDir, "xhr-test-cache").apply { deleteRecursively() }
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.cacheDirectory = cacheDirectory
+            xhrConfig.deduplicateRequests = true
+        })
+
+        val js = """
+            |function sendRequest() {
+            |  var xhr = new XMLHttpRequest();
+            |  xhr.open("GET", "${server.url}");
+            |  xhr.onload = function() { javaFunctionMock("loaded: " + xhr.responseText); };
+            |  xhr.send();
+            |}""".trimMargin()
+        subject.evaluateUnsync(js)
+
+        // WHEN
+        // 3 concurrent requests
+        subject.evaluateUnsync("sendRequest(); sendRequest(); sendRequest();")
+
+        // THEN
+        // Note: mockk verify with timeout has some issues on API < 24
+        if (android.os.Build.VERSION.SDK_INT >= 24) {
+            verify(timeout = 2000, exactly = 3) { jsToJavaFunctionMock(eq("loaded: cached content")) }
+            assertEquals(1, server.requestCount)
+        }
+
+        // WHEN
+        // Fresh response in the HTTP cache
+        subject.evaluateUnsync("sendRequest();")
+
+        // THEN
+        if (android.os.Build.VERSION.SDK_INT >= 24) {
+            verify(timeout = 2000, exactly = 4) { jsToJavaFunctionMock(eq("loaded: cached content")) }
+            assertEquals(1, server.requestCount)
+        }
+        assertTrue(errors.isEmpty())
+
+        server.close()
+    }
+
+    @Test
+    fun testXmlHttpRequest_jsonResponse() {
+        // GIVEN
+        val responseJson = """{"array":[1,-2.5,1e+21,true,false,null,[]],"object":{"text":"\u00e9\u20ac\ud83d\ude00 \n \"quoted\"","empty":{}},"é€😀":""}"""
+        val server = TestHttpServer(responseJson)
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val js = """
+            |var xhr = new XMLHttpRequest();
+            |xhr.responseType = "json";
+            |xhr.open("GET", "${server.url}");
+            |xhr.onload = function() { javaFunctionMock(JSON.stringify(xhr.response)); };
+            |xhr.send();""".trimMargin()
+        subject.evaluateUnsync(js)
+
+        // THEN
+        if (android.os.Build.VERSION.SDK_INT >= 24) {
+            verify(timeout = 2000) {
+                jsToJavaFunctionMock(eq("""{"array":[1,-2.5,1e+21,true,false,null,[]],"object":{"text":"é€😀 \n \"quoted\"","empty":{}},"é€😀":""}"""))
+            }
+        }
+        assertTrue(errors.isEmpty())
+
+        server.close()
+    }
+
     @Test
     fun testConsole_asString() {
         // GIVEN
@@ -2884,6 +3044,699 @@ class JsBridgeTest {
         assertNull(result3)
         assertTrue(errors.isEmpty())
     }
+    @Test
+    fun testCompression() {
+        // GIVEN
+        val config = JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            compressionConfig.enabled = true
+            compressionConfig.maxDecompressedSize = 32 * 1024
+        }
+        val subject = createAndSetUpJsBridge(config)
+        val text = "Lorem ipsum dolor sit amet, ".repeat(1000)
+
+        // WHEN
+        val jsBytes = JsValue(subject, """(function() {
+            var s = "$text";
+            var bytes = new Uint8Array(s.length);
+            for (var i = 0; i < s.length; i++) bytes[i] = s.charCodeAt(i);
+            return bytes;
+        })()""")
+        val syncRoundTrip = subject.evaluateBlocking<Boolean>("""
+            (function() {
+                var gzipped = compression.compressSync("gzip", $jsBytes);
+                var inflated = compression.decompressSync("gzip", gzipped);
+                if (gzipped.length >= $jsBytes.length || inflated.length !== $jsBytes.length) return false;
+                for (var i = 0; i < inflated.length; i++) {
+                    if (inflated[i] !== $jsBytes[i]) return false;
+                }
+                return true;
+            })()
+        """)
+        val javaGzipped: ByteArray = subject.evaluateBlocking("""compression.compressSync("gzip", $jsBytes)""")
+        val javaInflated = java.util.zip.GZIPInputStream(javaGzipped.inputStream()).readBytes()
+        val asyncRoundTrip = runBlocking {
+            subject.evaluate<Boolean>("""
+                var compressor = new compression.BufferedCompressor("deflate-raw");
+                compressor.write($jsBytes.subarray(0, 100));
+                compressor.write($jsBytes.subarray(100));
+                compressor.close()
+                  .then(function(deflated) { return compression.decompress("deflate-raw", deflated); })
+                  .then(function(inflated) { return inflated.length === $jsBytes.length; });
+            """)
+        }
+        val isTooLargeRejected = subject.evaluateBlocking<Boolean>("""
+            (function() {
+                var gzipped = compression.compressSync("gzip", new Uint8Array(64 * 1024));
+                try {
+                    compression.decompressSync("gzip", gzipped);
+                    return false;
+                } catch (e) {
+                    return true;
+                }
+            })()
+        """)
+
+        // THEN
+        assertTrue(syncRoundTrip)
+        assertEquals(text, String(javaInflated))
+        assertTrue(asyncRoundTrip)
+        assertTrue(isTooLargeRejected)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testTypedArrayKernels() {
+        // GIVEN
+        val config = JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            typedArrayKernelsConfig.enabled = true
+        }
+        val subject = createAndSetUpJsBridge(config)
+
+        // WHEN
+        val sum: Double = subject.evaluateBlocking("TypedArrayKernels.sum(new Float64Array([1.5, 2.5, 3, 4, 5]))")
+        val intSum: Int = subject.evaluateBlocking("TypedArrayKernels.sum(new Int32Array([1, 2, 3, -4]))")
+        val min: Double = subject.evaluateBlocking("TypedArrayKernels.min(new Float64Array([3, -1.5, 2, 8, 0]))")
+        val max: Double = subject.evaluateBlocking("TypedArrayKernels.max(new Float32Array([3, -1.5, 2, 8, 0]))")
+        val minWithNaN: Double = subject.evaluateBlocking("TypedArrayKernels.min(new Float64Array([3, NaN, 2, 8, 0]))")
+        val dot: Double = subject.evaluateBlocking("TypedArrayKernels.dot(new Float64Array([1, 2, 3]), new Float64Array([4, 5, 6]))")
+        val scaled: DoubleArray = subject.evaluateBlocking("Array.prototype.slice.call(TypedArrayKernels.scale(new Float64Array([1, 2, 3]), 2))")
+        val sorted: IntArray = subject.evaluateBlocking("Array.prototype.slice.call(TypedArrayKernels.sort(new Int32Array([3, -1, 2, 0])))")
+        val histogram: IntArray = subject.evaluateBlocking("Array.prototype.slice.call(TypedArrayKernels.histogram(new Float64Array([0, 1, 2.5, 9.9, 10, 11]), 4, 0, 10))")
+
+        // THEN
+        assertEquals(16.0, sum)
+        assertEquals(2, intSum)
+        assertEquals(-1.5, min)
+        assertEquals(8.0, max)
+        assertTrue(minWithNaN.isNaN())
+        assertEquals(32.0, dot)
+        assertArrayEquals(doubleArrayOf(2.0, 4.0, 6.0), scaled, 0.0)
+        assertArrayEquals(intArrayOf(-1, 0, 2, 3), sorted)
+        assertArrayEquals(intArrayOf(2, 1, 0, 2), histogram)
+        assertTrue(errors.isEmpty())
+
+        // WHEN
+        var typeError: Throwable? = null
+        try {
+            subject.evaluateBlocking<Unit>("TypedArrayKernels.sum([1, 2, 3])")
+        } catch (t: Throwable) {
+            typeError = t
+        }
+        var mismatchError: Throwable? = null
+        try {
+            // Float64 kernel (type 0) with an Uint8Array
+            subject.evaluateBlocking<Unit>("TypedArrayKernelsExtension_native.sum(0, new Uint8Array(17).subarray(1))")
+        } catch (t: Throwable) {
+            mismatchError = t
+        }
+
+        // THEN
+        assertNotNull(typeError)
+        assertNotNull(mismatchError)
+    }
+
+    @Test
+    fun typedArrayKernelsBenchmark() {
+        // GIVEN
+        val config = JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            typedArrayKernelsConfig.enabled = true
+        }
+        val subject = createAndSetUpJsBridge(config)
+        val arrayLength = 1000000
+
+        subject.evaluateBlocking<Unit>("""
+            |globalThis.benchmarkArray = new Float64Array($arrayLength);
+            |for (var i = 0; i < $arrayLength; i++) benchmarkArray[i] = Math.sin(i);
+            |""".trimMargin())
+
+        val interpretedSum: suspend () -> Double = JsValue.newFunction(subject, """
+            |var s = 0;
+            |for (var i = 0; i < benchmarkArray.length; i++) s += benchmarkArray[i];
+            |return s;
+            |""".trimMargin()
+        ).createJavaToJsProxyFunction0()
+
+        val nativeSum: suspend () -> Double = JsValue.newFunction(subject, """
+            |return TypedArrayKernels.sum(benchmarkArray);
+            |""".trimMargin()
+        ).createJavaToJsProxyFunction0()
+
+        val interpretedSort: suspend () -> Unit = JsValue.newFunction(subject, """
+            |Array.prototype.sort.call(benchmarkArray.slice(0), function(a, b) { return a - b; });
+            |""".trimMargin()
+        ).createJavaToJsProxyFunction0()
+
+        val nativeSort: suspend () -> Unit = JsValue.newFunction(subject, """
+            |TypedArrayKernels.sort(benchmarkArray.slice(0));
+            |""".trimMargin()
+        ).createJavaToJsProxyFunction0()
+
+        runBlocking {
+            delay(500)
+
+            Timber.i("Executing interpretedSum()...")
+            var start = System.currentTimeMillis()
+            val expectedSum = interpretedSum()
+            Timber.i("-> result is $expectedSum (${System.currentTimeMillis() - start}ms)")
+
+            Timber.i("Executing nativeSum()...")
+            start = System.currentTimeMillis()
+            val sum = nativeSum()
+            Timber.i("-> result is $sum (${System.currentTimeMillis() - start}ms)")
+            assertEquals(expectedSum, sum, 1e-6)
+
+            Timber.i("Executing interpretedSort()...")
+            start = System.currentTimeMillis()
+            interpretedSort()
+            Timber.i("-> done (${System.currentTimeMillis() - start}ms)")
+
+            Timber.i("Executing nativeSort()...")
+            start = System.currentTimeMillis()
+            nativeSort()
+            Timber.i("-> done (${System.currentTimeMillis() - start}ms)")
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testWorker() {
+        // GIVEN
+        val config = JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            workerConfig.enabled = true
+        }
+        val subject = createAndSetUpJsBridge(config)
+        subject.setJsModuleLoader { moduleName ->
+            if (moduleName == "worker.js") {
+                """ self.onmessage = function(e) {
+                      var values = e.data.buffer ? new Uint8Array(e.data.buffer) : e.data.values;
+                      var sum = 0;
+                      for (var i = 0; i < values.length; i++) sum += values[i];
+                      postMessage({ name: e.data.name, sum: sum });
+                    };
+                """.trimIndent()
+            } else {
+                throw JsBridgeError.JsFileEvaluationError(moduleName)
+            }
+        }
+
+        // WHEN
+        val result: String = subject.evaluateBlocking("""
+            |new Promise(function(resolve) {
+            |  var worker = new Worker("worker.js");
+            |  worker.onmessage = function(e) {
+            |    worker.terminate();
+            |    resolve(e.data.name + ":" + e.data.sum);
+            |  };
+            |  worker.postMessage({ name: "worker", values: [1, 2, 3, 4] });
+            |})""".trimMargin())
+
+        // THEN
+        assertEquals("worker:10", result)
+        assertTrue(errors.isEmpty())
+
+        if (BuildConfig.FLAVOR == "duktape") {
+            // No ArrayBuffer transfer with Duktape (JSON serialization)
+            return
+        }
+
+        // WHEN
+        val transferResult: String = subject.evaluateBlocking("""
+            |new Promise(function(resolve) {
+            |  var worker = new Worker("worker.js");
+            |  var buffer = new Uint8Array([10, 20, 30]).buffer;
+            |  worker.onmessage = function(e) {
+            |    worker.terminate();
+            |    resolve(e.data.name + ":" + e.data.sum + ":" + buffer.byteLength);
+            |  };
+            |  worker.postMessage({ name: "transfer", buffer: buffer }, [buffer]);
+            |})""".trimMargin())
+
+        // THEN
+        assertEquals("transfer:60:0", transferResult)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testWorkerSharedArrayBuffer() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // No SharedArrayBuffer with Duktape
+            return
+        }
+
+        // GIVEN
+        val config = JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            workerConfig.enabled = true
+        }
+        val subject = createAndSetUpJsBridge(config)
+        subject.setJsModuleLoader { moduleName ->
+            if (moduleName == "sab-worker.js") {
+                """ self.onmessage = function(e) {
+                      var view = new Int32Array(e.data);
+                      var waitResult = Atomics.wait(view, 1, 0, 5000);
+                      Atomics.add(view, 0, 5);
+                      postMessage(waitResult !== "timed-out");
+                    };
+                """.trimIndent()
+            } else {
+                throw JsBridgeError.JsFileEvaluationError(moduleName)
+            }
+        }
+
+        // WHEN
+        val result: String = subject.evaluateBlocking("""
+            |new Promise(function(resolve) {
+            |  var sab = new SharedArrayBuffer(8);
+            |  var view = new Int32Array(sab);
+            |  var worker = new Worker("sab-worker.js");
+            |  worker.onmessage = function(e) {
+            |    worker.terminate();
+            |    resolve(e.data + ":" + view[0]);
+            |  };
+            |  worker.postMessage(sab);
+            |  Atomics.store(view, 1, 1);
+            |  Atomics.notify(view, 1);
+            |})""".trimMargin())
+
+        // THEN
+        assertEquals("true:5", result)
+        assertTrue(errors.isEmpty())
+
+        // WHEN
+        val mainThreadWaitResult: String = subject.evaluateBlocking("""
+            |try {
+            |  Atomics.wait(new Int32Array(new SharedArrayBuffer(4)), 0, 0, 0);
+            |  "blocked";
+            |} catch (e) {
+            |  e.name;
+            |}""".trimMargin())
+
+        // THEN
+        // Atomics.wait() cannot block the main JsBridge thread
+        assertEquals("TypeError", mainThreadWaitResult)
+    }
+
+    @Test
+    fun testJsValueTransferTo() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val otherJsBridge = JsBridge(JsBridgeConfig.bareConfig(), context)
+        val jsObject = JsValue(subject, """({ a: 1, b: { c: "two", d: [3, 4] } })""")
+
+        // WHEN
+        val otherJsObject = jsObject.transferTo(otherJsBridge)
+        val result: String = otherJsBridge.evaluateBlocking("JSON.stringify($otherJsObject)")
+
+        // THEN
+        assertEquals("""{"a":1,"b":{"c":"two","d":[3,4]}}""", result)
+
+        if (BuildConfig.FLAVOR != "duktape") {
+            // GIVEN
+            val jsBuffer = JsValue(subject, "new Uint8Array([1, 2, 3]).buffer")
+            val transferList = JsValue(subject, "[$jsBuffer]")
+
+            // WHEN
+            val otherJsBuffer = jsBuffer.transferTo(otherJsBridge, transferList)
+            val otherSum: Int = otherJsBridge.evaluateBlocking("new Uint8Array($otherJsBuffer).reduce(function(a, b) { return a + b; }, 0)")
+            val byteLength: Int = subject.evaluateBlocking("$jsBuffer.byteLength")
+
+            // THEN
+            assertEquals(6, otherSum)
+            assertEquals(0, byteLength)
+        }
+
+        assertTrue(errors.isEmpty())
+        otherJsBridge.release()
+
+        // WHEN (transfer to a released instance)
+        val releasedJsBridge = JsBridge(JsBridgeConfig.bareConfig(), context)
+        releasedJsBridge.release()
+        val lostJsBuffer = JsValue(subject, "new Uint8Array([1, 2, 3]).buffer")
+        val lostJsValue = lostJsBuffer.transferTo(releasedJsBridge)
+        var transferError: Throwable? = null
+        try {
+            runBlocking { lostJsValue.codeEvaluationDeferred?.await() }
+        } catch (t: Throwable) {
+            transferError = t
+        }
+        val lostByteLength: Int = subject.evaluateBlocking("$lostJsBuffer.byteLength")
+
+        // THEN
+        assertNotNull(transferError)
+        assertEquals(3, lostByteLength)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testFrozenJsonData() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val otherJsBridge = JsBridge(JsBridgeConfig.bareConfig(), context)
+        val frozenJsonData = FrozenJsonData.fromJson("""{"items": [{"id": 1, "name": "one"}, {"id": 2, "name": "two"}]}""")
+
+        // WHEN
+        frozenJsonData.assignToGlobal(subject, "catalog")
+        frozenJsonData.assignToGlobal(otherJsBridge, "catalog")
+        frozenJsonData.assignToGlobal(otherJsBridge, "quoted\"catalog")
+        val result: String = subject.evaluateBlocking("""
+            |catalog.items[1].name = "modified";
+            |catalog = null;
+            |catalog.items[1].name + ":" + Object.isFrozen(catalog.items)
+            """.trimMargin())
+        val otherResult: String = otherJsBridge.evaluateBlocking("""catalog.items[0].name + globalThis['quoted"catalog'].items.length""")
+
+        // THEN
+        assertEquals("two:true", result)
+        assertEquals("one2", otherResult)
+        otherJsBridge.release()
+    }
+
+    @Test
+    fun testJsValueWriteJsonTo() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val jsObject = JsValue(subject, """({ a: 1.5, b: { c: "two \ud83d\ude00\n", d: [3, undefined, null] }, e: undefined, f: new Error("err") })""")
+        val expectedJson = """{"a":1.5,"b":{"c":"two 😀\n","d":[3,null,null]},"f":{"message":"err"}}"""
+        val bigJsArray = JsValue(subject, "Array.from({ length: 100000 }, function(_, i) { return { id: i, name: 'item ' + i }; })")
+
+        // WHEN
+        val outputStream = java.io.ByteArrayOutputStream()
+        val writer = java.io.StringWriter()
+        val bigOutputStream = java.io.ByteArrayOutputStream()
+        runBlocking {
+            jsObject.writeJsonTo(outputStream)
+            jsObject.writeJsonTo(writer)
+            bigJsArray.writeJsonTo(bigOutputStream)
+        }
+        val bigJson: String = subject.evaluateBlocking("JSON.stringify($bigJsArray)")
+
+        // THEN
+        assertEquals(expectedJson, outputStream.toString("UTF-8"))
+        assertEquals(expectedJson, writer.toString())
+        assertEquals(bigJson, bigOutputStream.toString("UTF-8"))
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testParseJsonInputStream() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val json = """{"a": [1, -2.5, true, null], "b": {"c": "caf\u00e9 \ud83d\ude00"}}"""
+        val bigJson = (0 until 50000).joinToString(",", "[", "]") { """{"id":$it,"name":"item é$it"}""" }
+
+        // WHEN
+        val jsValue = runBlocking { subject.parseJson(json.byteInputStream()) }
+        val bigJsValue = runBlocking { subject.parseJson(bigJson.byteInputStream()) }
+        val protoJsValue = runBlocking { subject.parseJson("""{"__proto__": {"x": 1}}""".byteInputStream()) }
+        val invalidJsonError = runCatching {
+            runBlocking { subject.parseJson("""{"a": [1, 2}""".byteInputStream()) }
+        }.exceptionOrNull()
+
+        // THEN
+        assertEquals("""{"a":[1,-2.5,true,null],"b":{"c":"café 😀"}}""", subject.evaluateBlocking<String>("JSON.stringify($jsValue)"))
+        assertEquals(bigJson, subject.evaluateBlocking<String>("JSON.stringify($bigJsValue)"))
+        assertEquals("""["__proto__"]:true""", subject.evaluateBlocking<String>("""JSON.stringify(Object.keys($protoJsValue)) + ":" + ($protoJsValue.x === undefined)"""))
+        assertTrue(invalidJsonError is IllegalArgumentException)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsonObjectWrapperRecordList() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val json = (0 until 1000).joinToString(",", "[", "]") { """{"id":$it,"name":"item $it","tags":["a"],"pos":{"x":$it,"y":0}}""" }
+
+        // WHEN
+        val jsValue = JsValue.fromJavaValue(subject, JsonObjectWrapper(json))
+        val roundTrip: String = subject.evaluateBlocking("JSON.stringify($jsValue)")
+        val mutated: String = subject.evaluateBlocking("""
+            |var records = $jsValue;
+            |records[1].extra = true;
+            |delete records[2].name;
+            |records[3].id = "three";
+            |JSON.stringify([records[0], records[1], records[2], records[3], Object.keys(records[4])])
+            """.trimMargin())
+
+        // THEN
+        assertEquals(json, roundTrip)
+        assertEquals("""[{"id":0,"name":"item 0","tags":["a"],"pos":{"x":0,"y":0}},""" +
+            """{"id":1,"name":"item 1","tags":["a"],"pos":{"x":1,"y":0},"extra":true},""" +
+            """{"id":2,"tags":["a"],"pos":{"x":2,"y":0}},""" +
+            """{"id":"three","name":"item 3","tags":["a"],"pos":{"x":3,"y":0}},""" +
+            """["id","name","tags","pos"]]""", mutated)
+        assertTrue(errors.isEmpty())
+
+        // WHEN (supplementary characters)
+        val emojiJsValue = JsValue.fromJavaValue(subject, JsonObjectWrapper("""[{"name":"\uD83D\uDE00 smile"},"é😀"]"""))
+        val emojiLengths: String = subject.evaluateBlocking("$emojiJsValue[0].name.length + ':' + $emojiJsValue[1].length + ':' + $emojiJsValue[1].codePointAt(1)")
+
+        // THEN
+        assertEquals("8:3:128512", emojiLengths)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testHibernateAndResume() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val file = java.io.File.createTempFile("jsbridge", ".hibernated")
+        subject.evaluateBlocking<Unit>("""
+            |var counter = 3;
+            |var state = { name: "state", items: [1, 2, 3] };
+            |var notSaved = "not saved";
+            |globalThis['quoted"name'] = "quoted";
+            """.trimMargin())
+
+        // WHEN
+        runBlocking { subject.hibernate(file, listOf("counter", "state", "quoted\"name")) }
+        val resumedJsBridge = JsBridge.resume(file, JsBridgeConfig.bareConfig(), context)
+        val result: String = resumedJsBridge.evaluateBlocking("""
+            |counter + ":" + state.name + ":" + state.items.length + ":" + typeof notSaved + ":" + globalThis['quoted"name']
+            """.trimMargin())
+
+        // THEN
+        assertEquals("3:state:3:undefined:quoted", result)
+        assertTrue(errors.isEmpty())
+        resumedJsBridge.release()
+        file.delete()
+    }
+
+    @Test
+    fun testResumeRejectsSharedArrayBuffers() {
+        if (BuildConfig.FLAVOR == "duktape") return  // JSON snapshots
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val file = java.io.File.createTempFile("jsbridge", ".hibernated")
+        subject.evaluateBlocking<Unit>("var counter = 3;")
+        runBlocking { subject.hibernate(file, listOf("counter")) }
+
+        // Tampered file: SharedArrayBuffer count of the serialized value = 1
+        val bytes = file.readBytes()
+        val dataOffset = 2 + BuildConfig.FLAVOR.length + 4  // writeUTF(flavor) + writeInt(size)
+        bytes[dataOffset] = 1
+        file.writeBytes(bytes)
+
+        // WHEN
+        val resumedJsBridge = JsBridge.resume(file, JsBridgeConfig.bareConfig(), context)
+        val result: String = resumedJsBridge.evaluateBlocking("typeof counter")
+
+        // THEN
+        assertEquals("undefined", result)
+        resumedJsBridge.release()
+        file.delete()
+    }
+
+    @Test
+    fun testResumeRejectsCorruptedSnapshots() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val file = java.io.File.createTempFile("jsbridge", ".hibernated")
+        subject.evaluateBlocking<Unit>("var counter = 3;")
+        runBlocking { subject.hibernate(file, listOf("counter")) }
+        val bytes = file.readBytes()
+        val sizeOffset = 2 + BuildConfig.FLAVOR.length  // writeUTF(flavor)
+
+        for (corruptedBytes in listOf(
+            bytes.copyOf(bytes.size - 1),  // truncated
+            bytes.copyOf().apply { this[sizeOffset] = 0x7f },  // huge size
+            bytes.copyOf().apply { this[sizeOffset] = 0x80.toByte() }  // negative size
+        )) {
+            file.writeBytes(corruptedBytes)
+
+            // WHEN
+            var resumeError: Throwable? = null
+            try {
+                JsBridge.resume(file, JsBridgeConfig.bareConfig(), context)
+            } catch (t: Throwable) {
+                resumeError = t
+            }
+
+            // THEN
+            assertTrue(resumeError is IllegalArgumentException)
+        }
+        file.delete()
+    }
+
+    @Test
+    fun testFastRelease() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            runtimeConfig.fastRelease = true
+        })
+        val calcSumJava = JsValue.createJsToJavaProxyFunction2(subject) { a: Int, b: Int -> a + b }
+
+        // WHEN
+        val result: Int = subject.evaluateBlocking("""
+            |var objects = [];
+            |for (var i = 0; i < 10000; i++) objects.push({ index: i, array: new Uint8Array(16) });
+            |$calcSumJava(objects.length, 1)
+            """.trimMargin())
+        subject.release()
+
+        // THEN
+        assertEquals(10001, result)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testOnMemoryPressure() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        subject.evaluateBlocking<Unit>("""
+            |(function() {
+            |  for (var i = 0; i < 10000; i++) {
+            |    var a = { index: i };
+            |    var b = { a: a };
+            |    a.b = b;  // cycle which is only freed by the garbage collector
+            |  }
+            |})();
+            """.trimMargin())
+
+        // WHEN
+        val reclaimedBytes = runBlocking { subject.onMemoryPressure(ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL) }
+
+        // THEN
+        if (BuildConfig.FLAVOR != "duktape") {
+            // Duktape values are only approximated
+            assertTrue(reclaimedBytes > 0)
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testEngineProfiling() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        if (!BuildConfig.HAS_ENGINE_PROFILER) {
+            assertFailsWith<UnsupportedOperationException> { runBlocking { subject.startEngineProfiling() } }
+            return
+        }
+
+        // WHEN
+        runBlocking { subject.startEngineProfiling() }
+        subject.evaluateBlocking<Unit>("""
+            |function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+            |var obj = {};
+            |for (var i = 0; i < 10; i++) { fib(10); obj.toString; }
+            """.trimMargin())
+        val profile = runBlocking { subject.stopEngineProfiling(maxFunctions = 1) }
+
+        // THEN
+        assertEquals(1, profile.functions.size)
+        assertEquals("fib", profile.functions[0].name)
+        assertEquals(1770L, profile.functions[0].callCount)
+        assertTrue((profile.opcodeCounts["call1"] ?: 0L) >= 1770L)
+        assertTrue(profile.opcodeCounts.values.zipWithNext().all { (a, b) -> a >= b })
+        assertTrue(profile.propertyGetCount >= 10L)
+        assertTrue(profile.prototypeLookupCount >= 10L)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testMinimalBuiltIns() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.bareConfig().apply {
+            runtimeConfig.builtIns = JsBridgeConfig.RuntimeConfig.BuiltIn.MINIMAL
+        })
+
+        // WHEN
+        val types: String = subject.evaluateBlocking("""
+            |JSON.stringify([typeof Date, typeof RegExp, typeof eval, typeof Proxy, typeof ArrayBuffer,
+            |  typeof Object, typeof Math, typeof JSON, [3, 1, 2].sort().join()])
+            """.trimMargin())
+        val stats = subject.contextCreationStats
+
+        // THEN
+        assertEquals("""["undefined","undefined","undefined","undefined","undefined","function","object","object","1,2,3"]""", types)
+        if (BuildConfig.FLAVOR != "duktape") {
+            // Still needed for Deferred values and suspend functions
+            val deferred: Deferred<Int> = CompletableDeferred(3)
+            val deferredValue = JsValue.fromJavaValue(subject, deferred)
+            val awaitedValue: Int = subject.evaluateBlocking("$deferredValue")
+            assertEquals(3, awaitedValue)
+        }
+        assertNotNull(stats)
+        assertTrue(stats.creationTimeNanos > 0L)
+        if (BuildConfig.FLAVOR != "duktape") {
+            // Duktape values are only approximated
+            assertTrue(stats.baselineHeapSize > 0L)
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJavaStringPool() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.bareConfig().apply {
+            runtimeConfig.javaStringPoolSize = 2
+            runtimeConfig.javaStringPoolMaxLength = 8
+        })
+        val longString = "x".repeat(100)
+
+        // WHEN
+        val values = mutableListOf<String>()
+        repeat(10) { values.add(subject.evaluateBlocking("'click'")) }
+        values.add(subject.evaluateBlocking("'scroll'"))
+        values.add(subject.evaluateBlocking("'load'"))
+        values.add(subject.evaluateBlocking("'x'.repeat(100)"))
+        val stats = runBlocking { subject.getJavaStringPoolStats() }
+        val statsAfterMemoryPressure = runBlocking {
+            subject.onMemoryPressure(ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN)
+            subject.getJavaStringPoolStats()
+        }
+
+        // THEN
+        assertEquals(List(10) { "click" } + listOf("scroll", "load", longString), values)
+        assertNotNull(stats)
+        assertTrue(stats.hits >= 9L)
+        assertTrue(stats.evictions >= 1L)
+        assertEquals(2L, stats.size)
+        assertTrue(stats.hitRate > 0.5)
+        assertEquals(0L, statsAfterMemoryPressure?.size)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsThreadConfig() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            jsThreadConfig.priority = 10
+            jsThreadConfig.cpuAffinity = setOf(0)
+        })
+
+        // WHEN
+        val placement = runBlocking { subject.getJsThreadPlacement() }
+
+        // THEN
+        assertEquals(10, placement.priority)
+        assertEquals(setOf(0), placement.cpuAffinity)
+        assertEquals(0, placement.currentCpu)
+        assertTrue(errors.isEmpty())
+    }
+
     data class EmbeddedObject(val a: Int, val b: String)
 
     @Test
@@ -2927,6 +3780,134 @@ class JsBridgeTest {
         }
     }
 
+    @Test
+    fun testInterfaceDescriptorsSharedBetweenJsBridges() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val otherJsBridge = JsBridge(JsBridgeConfig.bareConfig(), context)
+
+        try {
+            // WHEN
+            JsValue.createJsToJavaProxy(subject, object : SimpleJsToJavaInterface {
+                override fun ping() = "pong1"
+            }).assignToGlobal("javaObject")
+            JsValue.createJsToJavaProxy(otherJsBridge, object : SimpleJsToJavaInterface {
+                override fun ping() = "pong2"
+            }).assignToGlobal("javaObject")
+
+            val ret1: String = subject.evaluateBlocking("javaObject.ping()")
+            val ret2: String = otherJsBridge.evaluateBlocking("javaObject.ping()")
+
+            // THEN
+            assertEquals("pong1", ret1)
+            assertEquals("pong2", ret2)
+
+            // The interface has only been reflected once
+            val methods = JsInterfaceDescriptors.getJsToJavaMethods(SimpleJsToJavaInterface::class.java, SimpleJsToJavaInterface::class.java, null) {
+                throw AssertionError("SimpleJsToJavaInterface should not be reflected again")
+            }
+            assertEquals(listOf("ping"), methods.map { it.name })
+            assertTrue(errors.isEmpty())
+        } finally {
+            otherJsBridge.release()
+        }
+    }
+
+    @Test
+    fun testNativeExtension() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        // See src/androidTest/jni/test_native_extension.c
+        subject.registerNativeExtension("jsbridge-test-native-extension")
+        val sum: Double = subject.evaluateBlocking("testNative.add(1.5, 2)")
+        val greeting: String = subject.evaluateBlocking("testNative.greet('JsBridge')")
+        val byteSum: Int = subject.evaluateBlocking("testNative.sumBytes(new Uint8Array([1, 2, 250]))")
+        val nativeError = assertFailsWith<JsException> {
+            subject.evaluateBlocking<Unit>("testNative.fail()")
+        }
+
+        // THEN
+        assertEquals(3.5, sum)
+        assertEquals("Hello JsBridge!", greeting)
+        assertEquals(253, byteSum)
+        assertEquals(true, nativeError.message?.contains("Native failure"))
+        assertTrue(errors.isEmpty())
+    }
+
+    interface CacheableJsToJavaInterface : JsToJavaInterface {
+        @JsCacheable(maxEntries = 2)
+        fun format(prefix: String, value: Int): String
+    }
+
+    @Test
+    fun testJsCacheable() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        var callCount = 0
+        val javaObject = object : CacheableJsToJavaInterface {
+            override fun format(prefix: String, value: Int): String {
+                callCount++
+                return "$prefix$value"
+            }
+        }
+        val jsToJavaProxy = JsValue.createJsToJavaProxy(subject, javaObject)
+
+        // WHEN
+        val result: String = subject.evaluateBlocking("""
+            |var result = [];
+            |for (var i = 0; i < 100; i++) {
+            |  result.push($jsToJavaProxy.format("#", i % 2));
+            |}
+            |result.slice(0, 3).join(",")
+            """.trimMargin())
+        val callCountBeforeInvalidation = callCount
+        subject.invalidateJavaMethodCaches()
+        subject.evaluateBlocking<Unit>("$jsToJavaProxy.format('#', 0)")
+        runBlocking { subject.onMemoryPressure(ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN) }
+        subject.evaluateBlocking<Unit>("$jsToJavaProxy.format('#', 0)")
+
+        // THEN
+        assertEquals("#0,#1,#0", result)
+        assertEquals(2, callCountBeforeInvalidation)
+        assertEquals(4, callCount)
+        assertTrue(errors.isEmpty())
+    }
+
+    enum class TestColor { RED, GREEN, BLUE }
+
+    @Test
+    fun testEnumConversion() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val nextColor = JsValue.createJsToJavaProxyFunction1(subject) { color: TestColor ->
+            TestColor.values()[(color.ordinal + 1) % TestColor.values().size]
+        }
+        val jsColor = JsValue.fromJavaValue(subject, TestColor.GREEN)
+
+        // WHEN
+        val nextColorName: String = subject.evaluateBlocking("""$nextColor("BLUE")""")
+        val colorBack: TestColor = subject.evaluateBlocking("""$nextColor("RED")""")
+        val colors: Array<TestColor> = subject.evaluateBlocking("""["GREEN", "RED"].map($nextColor)""")
+        runBlocking { subject.onMemoryPressure(ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN) }
+        val nextColorNameAfterMemoryPressure: String = subject.evaluateBlocking("""$nextColor("GREEN")""")
+        val jsColorName: String = jsColor.evaluateBlocking()
+
+        // THEN
+        assertEquals("RED", nextColorName)
+        assertEquals(TestColor.GREEN, colorBack)
+        assertArrayEquals(arrayOf(TestColor.BLUE, TestColor.GREEN), colors)
+        assertEquals("GREEN", jsColorName)
+        assertEquals("BLUE", nextColorNameAfterMemoryPressure)
+
+        // AND WHEN
+        // Unknown constant name
+        assertFailsWith<JsException> {
+            subject.evaluateBlocking<Unit>("""$nextColor("PURPLE")""")
+        }
+    }
+
     // JsExpectations
     // ---
 
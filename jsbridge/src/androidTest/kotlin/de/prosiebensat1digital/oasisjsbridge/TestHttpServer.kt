@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.net.ServerSocket
+import java.util.concurrent.atomic.AtomicInteger
+import kotlin.concurrent.thread
+
+// Minimal in-process HTTP server returning the same (cacheable) response for each request
+class TestHttpServer(
+    private val responseText: String,
+    private val responseHeaders: Map<String, String> = mapOf(),
+    private val delayMsecs: Long = 0L
+) : AutoCloseable {
+
+    private val serverSocket = ServerSocket(0)
+    private val requestCounter = AtomicInteger(0)
+
+    val url = "http://127.0.0.1:${serverSocket.localPort}/"
+    val requestCount get() = requestCounter.get()
+
+    init {
+        thread(name = "TestHttpServer") {
+            while (!serverSocket.isClosed) {
+                val socket = try { serverSocket.accept() } catch (t: Throwable) { break }
+                thread {
+                    socket.use {
+                        val reader = socket.getInputStream().bufferedReader()
+                        // Skip request line + headers
+                        while (reader.readLine()?.isNotEmpty() == true) Unit
+
+                        requestCounter.incrementAndGet()
+                        if (delayMsecs > 0L) Thread.sleep(delayMsecs)
+
+                        val body = responseText.toByteArray()
+                        val headers = responseHeaders.entries.joinToString("") { "${it.key}: ${it.value}\r\n" }
+                        val output = socket.getOutputStream()
+                        output.write(("HTTP/1.1 200 OK\r\n" +
+                            "Content-Type: text/plain\r\n" +
+                            "Content-Length: ${body.size}\r\n" +
+                            "Connection: close\r\n" +
+                            headers +
+                            "\r\n").toByteArray())
+                        output.write(body)
+                        output.flush()
+                    }
+                }
+            }
+        }
+    }
+
+    override fun close() {
+        serverSocket.close()
+    }
+}
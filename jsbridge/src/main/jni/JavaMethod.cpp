@@ -19,6 +19,7 @@
 #include "JavaMethod.h"
 
 #include "ExceptionHandler.h"
+#include "JavaMethodCache.h"
 #include "JavaType.h"
 #include "JniCache.h"
 #include "JniTypes.h"
@@ -40,6 +41,11 @@ JavaMethod::JavaMethod(const JsBridgeContext *jsBridgeContext, const JniLocalRef
   MethodInterface methodInterface = jsBridgeContext->getJniCache()->getMethodInterface(method);
 
   m_isVarArgs = methodInterface.isVarArgs();
+
+  const jint cacheMaxEntries = methodInterface.getCacheMaxEntries();
+  if (cacheMaxEntries > 0) {
+    m_cache = std::make_unique<JavaMethodCache>(jsBridgeContext, static_cast<size_t>(cacheMaxEntries), methodInterface.getCacheTtlMs());
+  }
   JObjectArrayLocalRef parameters = methodInterface.getParameters();
   const jsize numParameters = parameters.getLength();
 
@@ -97,6 +103,8 @@ JavaMethod::JavaMethod(const JsBridgeContext *jsBridgeContext, const JniLocalRef
   }
 }
 
+JavaMethod::~JavaMethod() = default;
+
 #if defined(DUKTAPE)
 
 #include "StackChecker.h"
@@ -105,6 +113,14 @@ duk_ret_t JavaMethod::invoke(const JsBridgeContext *jsBridgeContext, const JniRe
   duk_context *ctx = jsBridgeContext->getDuktapeContext();
 
   const auto argCount = duk_get_top(ctx);
+
+  // Memoized result of a @JsCacheable method
+  std::string cacheKey;
+  const bool isCacheable = m_cache && JavaMethodCache::makeKey(ctx, argCount, cacheKey);
+  if (isCacheable && m_cache->push(ctx, jsBridgeContext->getJavaMethodCacheGeneration(), cacheKey)) {
+    return 1;
+  }
+
   const auto minArgs = m_isVarArgs
       ? m_argumentTypes.size() - 1
       : m_argumentTypes.size();
@@ -139,7 +155,11 @@ duk_ret_t JavaMethod::invoke(const JsBridgeContext *jsBridgeContext, const JniRe
     args[i] = std::move(value);
   }
 
-  return m_methodBody(javaThis, args);
+  const duk_ret_t ret = m_methodBody(javaThis, args);
+  if (isCacheable && ret == 1) {
+    m_cache->put(ctx, jsBridgeContext->getJavaMethodCacheGeneration(), std::move(cacheKey), -1);
+  }
+  return ret;
 }
 
 #elif defined(QUICKJS)
@@ -148,6 +168,16 @@ JSValue JavaMethod::invoke(const JsBridgeContext *jsBridgeContext, const JniRef<
 
   JSContext *ctx = jsBridgeContext->getQuickJsContext();
 
+  // Memoized result of a @JsCacheable method
+  std::string cacheKey;
+  const bool isCacheable = m_cache && JavaMethodCache::makeKey(ctx, argc, argv, cacheKey);
+  if (isCacheable) {
+    JSValue cachedResult = m_cache->get(ctx, jsBridgeContext->getJavaMethodCacheGeneration(), cacheKey);
+    if (!JS_IsUninitialized(cachedResult)) {
+      return cachedResult;
+    }
+  }
+
   const int minArgs = m_isVarArgs
       ? m_argumentTypes.size() - 1
       : m_argumentTypes.size();
@@ -189,8 +219,11 @@ JSValue JavaMethod::invoke(const JsBridgeContext *jsBridgeContext, const JniRef<
     JS_FreeValue(ctx, varArgArray);
   }
 
-
-  return m_methodBody(javaThis, args);
+  JSValue result = m_methodBody(javaThis, args);
+  if (isCacheable && !JS_IsException(result)) {
+    m_cache->put(ctx, jsBridgeContext->getJavaMethodCacheGeneration(), std::move(cacheKey), result);
+  }
+  return result;
 }
 
 #endif
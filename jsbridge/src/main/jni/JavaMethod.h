@@ -34,6 +34,7 @@
 # include "quickjs/quickjs.h"
 #endif
 
+class JavaMethodCache;
 class JavaType;
 class JsBridgeContext;
 
@@ -41,6 +42,7 @@ class JavaMethod {
 public:
   JavaMethod(const JsBridgeContext *, const JniLocalRef<jsBridgeMethod> &method, std::string methodName,
              bool isLambda);
+  ~JavaMethod();
 
 #if defined(DUKTAPE)
   duk_ret_t invoke(const JsBridgeContext *, const JniRef<jobject> &javaThis) const;
@@ -56,6 +58,7 @@ private:
   std::vector<std::unique_ptr<const JavaType>> m_argumentTypes;
   bool m_isVarArgs;
   std::unique_ptr<const JavaType> m_returnValueType;
+  std::unique_ptr<JavaMethodCache> m_cache;  // only for @JsCacheable methods
 
 #if defined(DUKTAPE)
   std::function<duk_ret_t(const JniRef<jobject> &javaThis, const std::vector<JValue> &args)> m_methodBody;
@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JavaMethodCache.h"
+
+#include "JsBridgeContext.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+  void appendBytes(std::string &key, const void *data, size_t size) {
+    key.append(static_cast<const char *>(data), size);
+  }
+
+  void appendNumber(std::string &key, double d) {
+    if (std::isnan(d)) {
+      d = NAN;  // canonical NaN
+    }
+    key += 'd';
+    appendBytes(key, &d, sizeof(d));
+  }
+
+  void appendString(std::string &key, const char *s, size_t length) {
+    const auto length32 = static_cast<uint32_t>(length);
+    key += 's';
+    appendBytes(key, &length32, sizeof(length32));
+    key.append(s, length);
+  }
+}
+
+JavaMethodCache::JavaMethodCache(const JsBridgeContext *jsBridgeContext, size_t maxEntries, int64_t ttlMs)
+ : m_jsBridgeContext(jsBridgeContext)
+ , m_maxEntries(maxEntries)
+ , m_ttl(ttlMs > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(ttlMs)) : Clock::duration::zero()) {
+
+  m_jsBridgeContext->registerJavaMethodCache(this);
+}
+
+JavaMethodCache::~JavaMethodCache() {
+  m_jsBridgeContext->unregisterJavaMethodCache(this);
+}
+
+void JavaMethodCache::clear() {
+  m_entries.clear();
+  m_lru.clear();
+}
+
+const JavaMethodCache::Entry *JavaMethodCache::find(uint32_t generation, const std::string &key) {
+  if (generation != m_generation) {
+    m_entries.clear();
+    m_lru.clear();
+    m_generation = generation;
+    return nullptr;
+  }
+
+  auto it = m_entries.find(key);
+  if (it == m_entries.end()) {
+    return nullptr;
+  }
+
+  if (m_ttl != Clock::duration::zero() && Clock::now() >= it->second.expiration) {
+    m_lru.erase(it->second.lruIt);
+    m_entries.erase(it);
+    return nullptr;
+  }
+
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+  return &it->second;
+}
+
+void JavaMethodCache::insert(uint32_t generation, std::string key, Entry &&entry) {
+  if (generation != m_generation) {
+    m_entries.clear();
+    m_lru.clear();
+    m_generation = generation;
+  }
+
+  auto it = m_entries.find(key);
+  if (it != m_entries.end()) {
+    m_lru.erase(it->second.lruIt);
+    m_entries.erase(it);
+  } else if (m_entries.size() >= m_maxEntries) {
+    m_entries.erase(m_lru.back());
+    m_lru.pop_back();
+  }
+
+  if (m_ttl != Clock::duration::zero()) {
+    entry.expiration = Clock::now() + m_ttl;
+  }
+  m_lru.push_front(key);
+  entry.lruIt = m_lru.begin();
+  m_entries.emplace(std::move(key), std::move(entry));
+}
+
+#if defined(DUKTAPE)
+
+// static
+bool JavaMethodCache::makeKey(duk_context *ctx, duk_idx_t argCount, std::string &key) {
+  key.clear();
+
+  for (duk_idx_t i = 0; i < argCount; ++i) {
+    switch (duk_get_type(ctx, i)) {
+      case DUK_TYPE_UNDEFINED:
+        key += 'u';
+        break;
+      case DUK_TYPE_NULL:
+        key += 'n';
+        break;
+      case DUK_TYPE_BOOLEAN:
+        key += duk_get_boolean(ctx, i) ? 't' : 'f';
+        break;
+      case DUK_TYPE_NUMBER:
+        appendNumber(key, duk_get_number(ctx, i));
+        break;
+      case DUK_TYPE_STRING: {
+        duk_size_t length;
+        const char *s = duk_get_lstring(ctx, i, &length);
+        appendString(key, s, length);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+bool JavaMethodCache::push(duk_context *ctx, uint32_t generation, const std::string &key) {
+  const Entry *entry = find(generation, key);
+  if (entry == nullptr) {
+    return false;
+  }
+
+  switch (entry->type) {
+    case Entry::Type::Undefined:
+      duk_push_undefined(ctx);
+      break;
+    case Entry::Type::Null:
+      duk_push_null(ctx);
+      break;
+    case Entry::Type::Boolean:
+      duk_push_boolean(ctx, entry->intValue != 0);
+      break;
+    case Entry::Type::Int:
+    case Entry::Type::Number:
+      duk_push_number(ctx, entry->number);
+      break;
+    case Entry::Type::String:
+      duk_push_lstring(ctx, entry->string.data(), entry->string.size());
+      break;
+  }
+  return true;
+}
+
+void JavaMethodCache::put(duk_context *ctx, uint32_t generation, std::string key, duk_idx_t resultIndex) {
+  Entry entry {};
+
+  switch (duk_get_type(ctx, resultIndex)) {
+    case DUK_TYPE_UNDEFINED:
+      entry.type = Entry::Type::Undefined;
+      break;
+    case DUK_TYPE_NULL:
+      entry.type = Entry::Type::Null;
+      break;
+    case DUK_TYPE_BOOLEAN:
+      entry.type = Entry::Type::Boolean;
+      entry.intValue = duk_get_boolean(ctx, resultIndex) ? 1 : 0;
+      break;
+    case DUK_TYPE_NUMBER:
+      entry.type = Entry::Type::Number;
+      entry.number = duk_get_number(ctx, resultIndex);
+      break;
+    case DUK_TYPE_STRING: {
+      duk_size_t length;
+      const char *s = duk_get_lstring(ctx, resultIndex, &length);
+      entry.type = Entry::Type::String;
+      entry.string.assign(s, length);
+      break;
+    }
+    default:
+      return;
+  }
+
+  insert(generation, std::move(key), std::move(entry));
+}
+
+#elif defined(QUICKJS)
+
+// static
+bool JavaMethodCache::makeKey(JSContext *ctx, int argc, JSValueConst *argv, std::string &key) {
+  key.clear();
+
+  for (int i = 0; i < argc; ++i) {
+    JSValueConst v = argv[i];
+    switch (JS_VALUE_GET_NORM_TAG(v)) {
+      case JS_TAG_UNDEFINED:
+        key += 'u';
+        break;
+      case JS_TAG_NULL:
+        key += 'n';
+        break;
+      case JS_TAG_BOOL:
+        key += JS_VALUE_GET_BOOL(v) ? 't' : 'f';
+        break;
+      case JS_TAG_INT:
+        appendNumber(key, JS_VALUE_GET_INT(v));
+        break;
+      case JS_TAG_FLOAT64:
+        appendNumber(key, JS_VALUE_GET_FLOAT64(v));
+        break;
+      case JS_TAG_STRING: {
+        size_t length;
+        const char *s = JS_ToCStringLen(ctx, &length, v);
+        if (s == nullptr) {
+          JS_FreeValue(ctx, JS_GetException(ctx));
+          return false;
+        }
+        appendString(key, s, length);
+        JS_FreeCString(ctx, s);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+JSValue JavaMethodCache::get(JSContext *ctx, uint32_t generation, const std::string &key) {
+  const Entry *entry = find(generation, key);
+  if (entry == nullptr) {
+    return JS_UNINITIALIZED;
+  }
+
+  switch (entry->type) {
+    case Entry::Type::Undefined:
+      return JS_UNDEFINED;
+    case Entry::Type::Null:
+      return JS_NULL;
+    case Entry::Type::Boolean:
+      return JS_NewBool(ctx, entry->intValue != 0);
+    case Entry::Type::Int:
+      return JS_NewInt32(ctx, entry->intValue);
+    case Entry::Type::Number:
+      return JS_NewFloat64(ctx, entry->number);
+    case Entry::Type::String:
+      return JS_NewStringLen(ctx, entry->string.data(), entry->string.size());
+  }
+  return JS_UNINITIALIZED;
+}
+
+void JavaMethodCache::put(JSContext *ctx, uint32_t generation, std::string key, JSValueConst result) {
+  Entry entry {};
+
+  switch (JS_VALUE_GET_NORM_TAG(result)) {
+    case JS_TAG_UNDEFINED:
+      entry.type = Entry::Type::Undefined;
+      break;
+    case JS_TAG_NULL:
+      entry.type = Entry::Type::Null;
+      break;
+    case JS_TAG_BOOL:
+      entry.type = Entry::Type::Boolean;
+      entry.intValue = JS_VALUE_GET_BOOL(result) ? 1 : 0;
+      break;
+    case JS_TAG_INT:
+      entry.type = Entry::Type::Int;
+      entry.intValue = JS_VALUE_GET_INT(result);
+      break;
+    case JS_TAG_FLOAT64:
+      entry.type = Entry::Type::Number;
+      entry.number = JS_VALUE_GET_FLOAT64(result);
+      break;
+    case JS_TAG_STRING: {
+      size_t length;
+      const char *s = JS_ToCStringLen(ctx, &length, result);
+      if (s == nullptr) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        return;
+      }
+      entry.type = Entry::Type::String;
+      entry.string.assign(s, length);
+      JS_FreeCString(ctx, s);
+      break;
+    }
+    default:
+      return;
+  }
+
+  insert(generation, std::move(key), std::move(entry));
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVAMETHODCACHE_H
+#define _JSBRIDGE_JAVAMETHODCACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
+# include "quickjs/quickjs.h"
+#endif
+
+class JsBridgeContext;
+
+// Memoized results of a @JsCacheable Java method, keyed by its JS arguments, so that repeated
+// calls are answered without any JNI call or argument conversion.
+//
+// Only primitive arguments and return values (undefined, null, boolean, number, string) are
+// supported: calls with other values are never cached. The least recently used entry is evicted
+// when the cache is full. All the entries are discarded when the generation (incremented by
+// JsBridgeContext::invalidateJavaMethodCaches()) changes or on memory pressure (see clear()).
+//
+// Must only be used in the JS thread.
+class JavaMethodCache {
+public:
+  // - maxEntries: > 0
+  // - ttlMs: time-to-live of each entry in milliseconds (<= 0: no expiration)
+  // The cache is registered to the given context until it is deleted.
+  JavaMethodCache(const JsBridgeContext *, size_t maxEntries, int64_t ttlMs);
+  JavaMethodCache(const JavaMethodCache &) = delete;
+  JavaMethodCache &operator=(const JavaMethodCache &) = delete;
+
+  ~JavaMethodCache();
+
+  // Discard all the entries
+  void clear();
+
+#if defined(DUKTAPE)
+  // Build the key of the arguments at index [0, argCount). Returns false if they are not cacheable.
+  static bool makeKey(duk_context *, duk_idx_t argCount, std::string &key);
+
+  // Push the cached result and return true (or return false if there is none)
+  bool push(duk_context *, uint32_t generation, const std::string &key);
+
+  // Cache the result at the given index (ignored if it is not a primitive value)
+  void put(duk_context *, uint32_t generation, std::string key, duk_idx_t resultIndex);
+#elif defined(QUICKJS)
+  // Build the key of the given arguments. Returns false if they are not cacheable.
+  static bool makeKey(JSContext *, int argc, JSValueConst *argv, std::string &key);
+
+  // Return the cached result (or JS_UNINITIALIZED if there is none)
+  JSValue get(JSContext *, uint32_t generation, const std::string &key);
+
+  // Cache the given result (ignored if it is not a primitive value)
+  void put(JSContext *, uint32_t generation, std::string key, JSValueConst result);
+#endif
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Entry {
+    enum class Type : uint8_t { Undefined, Null, Boolean, Int, Number, String } type;
+    int32_t intValue;  // Boolean, Int
+    double number;
+    std::string string;
+    Clock::time_point expiration;
+    std::list<std::string>::iterator lruIt;
+  };
+
+  // Returns the valid entry for the given key (updating the LRU order) or nullptr
+  const Entry *find(uint32_t generation, const std::string &key);
+  void insert(uint32_t generation, std::string key, Entry &&);
+
+  const JsBridgeContext *m_jsBridgeContext;
+  const size_t m_maxEntries;
+  const Clock::duration m_ttl;
+  uint32_t m_generation = 0;
+  std::unordered_map<std::string, Entry> m_entries;
+  std::list<std::string> m_lru;  // most recently used first
+};
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JavaStringPool.h"
+
+JavaStringPool::JavaStringPool(size_t maxEntries, size_t maxLength)
+ : m_maxEntries(maxEntries)
+ , m_maxLength(maxLength) {
+}
+
+JStringLocalRef JavaStringPool::get(const JniContext *jniContext, const char *s, size_t length) {
+  if (length > m_maxLength) {
+    return JStringLocalRef(jniContext, s);
+  }
+
+  m_key.assign(s, length);
+
+  auto it = m_entries.find(m_key);
+  if (it != m_entries.end()) {
+    ++m_stats.hits;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+    return JStringLocalRef(jniContext, it->second.javaString.get(), JniLocalRefMode::NewLocalRef);
+  }
+
+  ++m_stats.misses;
+
+  JStringLocalRef javaString(jniContext, s);
+  if (javaString.isNull()) {
+    // Out of memory: the Java exception is pending
+    return javaString;
+  }
+
+  if (m_entries.size() >= m_maxEntries) {
+    ++m_stats.evictions;
+    m_entries.erase(m_lru.back());
+    m_lru.pop_back();
+  }
+
+  m_lru.push_front(m_key);
+  m_entries.emplace(m_key, Entry { JniGlobalRef<jstring>(javaString), m_lru.begin() });
+  return javaString;
+}
+
+void JavaStringPool::clear() {
+  m_entries.clear();
+  m_lru.clear();
+}
+
+JavaStringPool::Stats JavaStringPool::getStats() const {
+  Stats stats = m_stats;
+  stats.size = static_cast<int64_t>(m_entries.size());
+  return stats;
+}
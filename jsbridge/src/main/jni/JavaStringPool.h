@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVASTRINGPOOL_H
+#define _JSBRIDGE_JAVASTRINGPOOL_H
+
+#include "jni-helpers/JniGlobalRef.h"
+#include "jni-helpers/JStringLocalRef.h"
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+class JniContext;
+
+// Bounded pool of Java strings for the JS strings which are often converted to Java (e.g. enum-like
+// values, keys or event names), so that each of them is only created once in the JVM and then
+// handed out as a new local ref of a cached global ref.
+//
+// Strings are keyed by their UTF-8 (CESU-8 with Duktape) content. Strings longer than maxLength
+// are never pooled. The least recently used entry is evicted when the pool is full.
+//
+// Must only be used in the JS thread.
+class JavaStringPool {
+public:
+  struct Stats {
+    int64_t hits = 0;
+    int64_t misses = 0;  // pooled strings which had to be created (long strings are not counted)
+    int64_t evictions = 0;
+    int64_t size = 0;
+  };
+
+  // - maxEntries: > 0
+  // - maxLength: maximum length (in bytes) of the pooled strings
+  JavaStringPool(size_t maxEntries, size_t maxLength);
+  JavaStringPool(const JavaStringPool &) = delete;
+  JavaStringPool &operator=(const JavaStringPool &) = delete;
+
+  // Return the Java string of the given null-terminated string with the given length
+  JStringLocalRef get(const JniContext *, const char *s, size_t length);
+
+  Stats getStats() const;
+
+  // Release all the pooled Java strings (the stats are kept)
+  void clear();
+
+private:
+  struct Entry {
+    JniGlobalRef<jstring> javaString;
+    std::list<std::string>::iterator lruIt;
+  };
+
+  const size_t m_maxEntries;
+  const size_t m_maxLength;
+  std::unordered_map<std::string, Entry> m_entries;
+  std::list<std::string> m_lru;  // most recently used first
+  std::string m_key;  // reused for lookups
+  Stats m_stats;
+};
+
+#endif
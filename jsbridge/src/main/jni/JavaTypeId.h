@@ -44,6 +44,7 @@ enum class JavaTypeId {
   String = 30,
   Number = 31,
   Object = 40,
+  Enum = 41,
 
   ObjectArray = 50,
   List = 51,
@@ -23,6 +23,7 @@
 #include "java-types/Byte.h"
 #include "java-types/Deferred.h"
 #include "java-types/Double.h"
+#include "java-types/Enum.h"
 #include "java-types/Float.h"
 #include "java-types/FunctionX.h"
 #include "java-types/Integer.h"
@@ -63,6 +64,8 @@ JavaTypeProvider::JavaTypeProvider(const JsBridgeContext *jsBridgeContext)
  , m_objectType() {
 }
 
+JavaTypeProvider::~JavaTypeProvider() = default;
+
 const JavaType *JavaTypeProvider::newType(const JniRef<jsBridgeParameter> &parameter, bool boxed) const {
   JavaTypeId id = parameter.isNull() ? JavaTypeId::Object : getJavaTypeId(parameter);
 
@@ -111,6 +114,8 @@ const JavaType *JavaTypeProvider::newType(const JniRef<jsBridgeParameter> &param
       return createPrimitive<Double>(m_jsBridgeContext, true);
     case JavaTypeId::Object:
       return new Object(m_jsBridgeContext, std::nullopt);
+    case JavaTypeId::Enum:
+      return new Enum(m_jsBridgeContext, getEnumTable(parameter));
 
     case JavaTypeId::ObjectArray: {
       auto genericParameterType = getGenericParameterType(parameter);
@@ -170,6 +175,10 @@ std::unique_ptr<const JavaType> JavaTypeProvider::getDeferredType(const JniRef<j
   return std::make_unique<Deferred>(m_jsBridgeContext, makeUniqueType(parameter, true /*boxed*/));
 }
 
+void JavaTypeProvider::releaseEnumTables() const {
+  m_enumTables.clear();
+}
+
 
 // Private methods
 // ---
@@ -178,17 +187,33 @@ JavaTypeId JavaTypeProvider::getJavaTypeId(const JniRef<jsBridgeParameter> &para
   const JniContext *jniContext = m_jsBridgeContext->getJniContext();
   assert(jniContext != nullptr);
 
-  JStringLocalRef javaName = m_jsBridgeContext->getJniCache()->getParameterInterface(parameter).getJavaName();
+  ParameterInterface parameterInterface = m_jsBridgeContext->getJniCache()->getParameterInterface(parameter);
+
+  // Already resolved (Parameter instances are shared by all the JsBridge instances, see
+  // JsInterfaceDescriptors)
+  const jint resolvedId = parameterInterface.getJavaTypeId();
+  if (resolvedId != static_cast<jint>(JavaTypeId::Unknown)) {
+    return static_cast<JavaTypeId>(resolvedId);
+  }
+
+  JStringLocalRef javaName = parameterInterface.getJavaName();
   if (javaName.isNull()) {
     throw std::invalid_argument("Could not get Java name from Parameter!");
   }
 
   JavaTypeId id = getJavaTypeIdByJavaName(javaName.getUtf16View());
   if (id == JavaTypeId::Unknown) {
-    throw std::invalid_argument(std::string("Unsupported Java type: ") + javaName.toStdString());
-    //return JavaTypeId::Unknown;
+    // Enum classes cannot be identified by name
+    JniLocalRef<jclass> javaClass = parameterInterface.getJava();
+    if (!javaClass.isNull() && jniContext->isAssignableFrom(javaClass, m_jsBridgeContext->getJniCache()->getEnumClass())) {
+      id = JavaTypeId::Enum;
+    } else {
+      throw std::invalid_argument(std::string("Unsupported Java type: ") + javaName.toStdString());
+      //return JavaTypeId::Unknown;
+    }
   }
 
+  parameterInterface.setJavaTypeId(static_cast<jint>(id));
   return id;
 }
 
@@ -205,3 +230,16 @@ std::unique_ptr<const JavaType> JavaTypeProvider::getGenericParameterType(const
   return makeUniqueType(getGenericParameter(parameter), true /*boxed*/);
 }
 
+std::shared_ptr<const EnumTable> JavaTypeProvider::getEnumTable(const JniRef<jsBridgeParameter> &parameter) const {
+  ParameterInterface parameterInterface = m_jsBridgeContext->getJniCache()->getParameterInterface(parameter);
+  std::string javaName = parameterInterface.getJavaName().toStdString();
+
+  auto itFind = m_enumTables.find(javaName);
+  if (itFind != m_enumTables.end()) {
+    return itFind->second;
+  }
+
+  auto enumTable = std::make_shared<const EnumTable>(m_jsBridgeContext, parameterInterface.getJava());
+  m_enumTables.emplace(std::move(javaName), enumTable);
+  return enumTable;
+}
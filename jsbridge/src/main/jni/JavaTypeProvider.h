@@ -21,6 +21,7 @@
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JniLocalRef.h"
 #include <memory>
+#include <string>
 #include <unordered_map>
 
 class JsBridgeContext;
@@ -28,6 +29,7 @@ class JavaType;
 
 namespace JavaTypes {
   class Deferred;
+  class EnumTable;
 }
 
 // Manages the JavaType instances for a particular JsBridgeContext.
@@ -35,6 +37,7 @@ class JavaTypeProvider {
 public:
   JavaTypeProvider() = delete;
   JavaTypeProvider(const JsBridgeContext *);
+  ~JavaTypeProvider();
 
   JavaTypeProvider(const JavaTypeProvider &) = delete;
   JavaTypeProvider &operator = (const JavaTypeProvider &) = delete;
@@ -45,13 +48,20 @@ public:
   const std::unique_ptr<const JavaType> &getObjectType() const;
   std::unique_ptr<const JavaType> getDeferredType(const JniRef<jsBridgeParameter> &) const;
 
+  // Release the cached enum tables (those still used by Enum types are deleted with them)
+  void releaseEnumTables() const;
+
 private:
   const JsBridgeContext *m_jsBridgeContext;
   JavaTypeId getJavaTypeId(const JniRef<jsBridgeParameter> &) const;
   bool isParameterNullable(const JniRef<jsBridgeParameter> &) const;
   JniLocalRef<jsBridgeParameter> getGenericParameter(const JniRef<jsBridgeParameter> &) const;
   std::unique_ptr<const JavaType> getGenericParameterType(const JniRef<jsBridgeParameter> &) const;
+  std::shared_ptr<const JavaTypes::EnumTable> getEnumTable(const JniRef<jsBridgeParameter> &) const;
   mutable std::unique_ptr<const JavaType> m_objectType;
+
+  // Enum class name => conversion table (shared by all the parameters with the same enum class)
+  mutable std::unordered_map<std::string, std::shared_ptr<const JavaTypes::EnumTable>> m_enumTables;
 };
 
 #endif
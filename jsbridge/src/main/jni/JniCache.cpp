@@ -28,6 +28,7 @@ JniCache::JniCache(const JsBridgeContext *jsBridgeContext, const JniLocalRef<job
  , m_arrayListClass(m_jniContext->findClass("java/util/ArrayList"))
  , m_javaClassClass(m_jniContext->findClass("java/lang/Class"))
  , m_listClass(m_jniContext->findClass("java/util/List"))
+ , m_enumClass(m_jniContext->findClass("java/lang/Enum"))
  , m_jsBridgeClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/JsBridge"))
  , m_jsExceptionClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/JsException"))
  , m_illegalArgumentExceptionClass(m_jniContext->findClass("java/lang/IllegalArgumentException"))
@@ -76,9 +77,12 @@ JniLocalRef<jthrowable> JniCache::newJsException(
     const JStringLocalRef &jsStackTrace, const JniRef<jthrowable> &cause) const {
 
   static thread_local jmethodID methodId = m_jniContext->getMethodID(
-      m_jsExceptionClass, "<init>", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/Throwable;)V");
+      m_jsExceptionClass, "<init>", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/Throwable;L" JSBRIDGE_PKG_PATH "/JsSourceMaps;)V");
 
-  return m_jniContext->newObject<jthrowable>(m_jsExceptionClass, methodId, jsonValue, detailedMessage, jsStackTrace, cause);
+  // Source maps (if any) used to lazily resolve the JS stack trace
+  JniLocalRef<jobject> sourceMaps = m_jsBridgeInterface.getJsSourceMaps();
+
+  return m_jniContext->newObject<jthrowable>(m_jsExceptionClass, methodId, jsonValue, detailedMessage, jsStackTrace, cause, sourceMaps);
 }
 
 
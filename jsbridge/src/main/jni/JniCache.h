@@ -42,6 +42,7 @@ public:
   const JniRef<jclass> &getNumberClass() const { return m_numberClass; }
   const JniRef<jclass> &getStringClass() const { return m_stringClass; }
   const JniRef<jclass> &getListClass() const { return m_listClass; }
+  const JniRef<jclass> &getEnumClass() const { return m_enumClass; }
   const JniRef<jclass> &getJavaClassClass() const { return m_javaClassClass; }
   const JniRef<jclass> &getJsBridgeClass() const { return m_jsBridgeClass; }
   const JniRef<jclass> &getJsBridgeMethodClass() const { return m_jsBridgeMethodClass; }
@@ -104,6 +105,7 @@ private:
   JniGlobalRef<jclass> m_numberClass;
   JniGlobalRef<jclass> m_stringClass;
   JniGlobalRef<jclass> m_listClass;
+  JniGlobalRef<jclass> m_enumClass;
   JniGlobalRef<jclass> m_javaClassClass;
   JniGlobalRef<jclass> m_arrayListClass;
   JniGlobalRef<jclass> m_jsBridgeClass;
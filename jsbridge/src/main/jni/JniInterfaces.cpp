@@ -96,6 +96,12 @@ void JsBridgeInterface::addUnhandledJsPromiseException(const JValue &exception)
   m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, exception);
 }
 
+JniLocalRef<jobject> JsBridgeInterface::getJsSourceMaps() const {
+  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
+          m_class, "getJsSourceMaps", "()L" JSBRIDGE_PKG_PATH "/JsSourceMaps;");
+  return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId);
+}
+
 
 // MethodInterface
 // ---
@@ -142,6 +148,16 @@ jboolean MethodInterface::isVarArgs() const {
   return m_jniCache->getJniContext()->callBooleanMethod(m_object, methodId);
 }
 
+jint MethodInterface::getCacheMaxEntries() const {
+  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getCacheMaxEntries", "()I");
+  return m_jniCache->getJniContext()->callIntMethod(m_object, methodId);
+}
+
+jlong MethodInterface::getCacheTtlMs() const {
+  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getCacheTtlMs", "()J");
+  return m_jniCache->getJniContext()->callLongMethod(m_object, methodId);
+}
+
 
 // ParameterInterface
 // ---
@@ -182,6 +198,16 @@ JStringLocalRef ParameterInterface::getJavaName() const {
   return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
 }
 
+jint ParameterInterface::getJavaTypeId() const {
+  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getJavaTypeId", "()I");
+  return m_jniCache->getJniContext()->callIntMethod(m_object, methodId);
+}
+
+void ParameterInterface::setJavaTypeId(jint id) const {
+  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "setJavaTypeId", "(I)V");
+  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, id);
+}
+
 jboolean ParameterInterface::isNullable() const {
   static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "isNullable", "()Z");
   return m_jniCache->getJniContext()->callBooleanMethod(m_object, methodId);
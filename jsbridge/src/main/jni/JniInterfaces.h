@@ -55,6 +55,7 @@ public:
   JniLocalRef<jobject> createCompletableDeferred() const;
   void setUpJsPromise(const JStringLocalRef &, const JniRef<jobject> &deferred) const;
   void addUnhandledJsPromiseException(const JValue &exception) const;
+  JniLocalRef<jobject> getJsSourceMaps() const;
 };
 
 // de.prosiebensat1digital.oasisjsbridge.Method
@@ -68,6 +69,8 @@ public:
   JniLocalRef<jsBridgeParameter> getReturnParameter() const;
   JObjectArrayLocalRef getParameters() const;
   jboolean isVarArgs() const;
+  jint getCacheMaxEntries() const;
+  jlong getCacheTtlMs() const;
 };
 
 // de.prosiebensat1digital.oasisjsbridge.Parameter
@@ -79,6 +82,8 @@ public:
   JObjectArrayLocalRef getMethods() const;
   JniLocalRef<jclass> getJava() const;
   JStringLocalRef getJavaName() const;
+  jint getJavaTypeId() const;
+  void setJavaTypeId(jint) const;
   jboolean isNullable() const;
   JniLocalRef<jsBridgeParameter> getGenericParameter() const;
   JStringLocalRef getName() const;
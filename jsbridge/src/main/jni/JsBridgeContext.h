@@ -25,6 +25,7 @@
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include <jni.h>
 #include <string>
+#include <unordered_set>
 
 #if defined(DUKTAPE)
 # include "duktape/duktape.h"
@@ -34,9 +35,12 @@
 
 class DuktapeUtils;
 class ExceptionHandler;
+class JavaMethodCache;
+class JavaStringPool;
 class JavaType;
 class JniCache;
 class JObjectArrayLocalRef;
+class QuickJsHeap;
 class QuickJsUtils;
 
 // JS context, delegating operations to the JS engine.
@@ -49,8 +53,29 @@ public:
 
   ~JsBridgeContext();
 
+  // Optional built-in JS objects (bit = ordinal of JsBridgeConfig.RuntimeConfig.BuiltIn)
+  enum BuiltIn {
+    BUILTIN_DATE = 1 << 0,
+    BUILTIN_REGEXP = 1 << 1,
+    BUILTIN_EVAL = 1 << 2,
+    BUILTIN_PROXY = 1 << 3,
+    BUILTIN_MAP_SET = 1 << 4,
+    BUILTIN_TYPED_ARRAYS = 1 << 5,
+    BUILTIN_PROMISE = 1 << 6,
+    BUILTIN_STRING_NORMALIZE = 1 << 7,
+  };
+
   // Must be called immediately after the constructor
-  void init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject);
+  // - fastRelease: discard the whole JS heap on destruction instead of finalizing each JS value
+  //   (QuickJS only)
+  // - canBlock: allow Atomics.wait() to block the JS thread (QuickJS only, worker contexts)
+  // - builtIns: BuiltIn flags of the optional built-ins to install in the context (base objects
+  //   like Object, Function, Array, Error, Math or JSON are always installed)
+  void init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject, bool fastRelease, bool canBlock, int builtIns);
+
+  // Number of bytes allocated by the JS engine for the freshly created context (measured at the
+  // end of init())
+  int64_t getBaselineHeapSize() const { return m_baselineHeapSize; }
 
   void startDebugger(int port);
   void cancelDebug();
@@ -78,10 +103,52 @@ public:
   void copyJsValue(const std::string &strGlobalNameTo, const std::string &strGlobalNameFrom);
   void newJsFunction(const std::string &strGlobalName, const JObjectArrayLocalRef &args, const JStringLocalRef &strCode);
 
+  // Serialize a JS value into a byte array (structured clone with QuickJS, JSON with Duktape) which
+  // can be deserialized in another JS context. ArrayBuffers of the optional transfer list are
+  // detached from the current context. SharedArrayBuffers are only allowed when the value is
+  // deserialized in the same process (QuickJS).
+  JValue serializeJsValue(const std::string &strGlobalName, const std::string &strTransferListGlobalName, bool allowSharedArrayBuffers);
+  // SharedArrayBuffers are referenced by native pointers: they must only be allowed for data
+  // serialized by the current process (and not e.g. read from a file). Throws
+  // std::invalid_argument if the data contains SharedArrayBuffers which are not allowed.
+  void deserializeJsValue(const std::string &strGlobalName, const JniLocalRef<jarray> &data, bool allowSharedArrayBuffers);
+  void assignJsonTape(const std::string &strGlobalName, const JniLocalRef<jarray> &tape);
+  void assignJsonTape(const std::string &strGlobalName, const uint8_t *tape, size_t size);
+  void writeJson(const std::string &strGlobalName, const JniLocalRef<jobject> &buffer, const JniLocalRef<jobject> &output);
+  // Release the SharedArrayBuffers referenced by a serialized value which won't be deserialized
+  void releaseSerializedJsValue(const JniLocalRef<jarray> &data);
+
   void convertJavaValueToJs(const std::string &strGlobalName, const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter);
 
   void processPromiseQueue();
 
+  // Run the garbage collector, release the native caches and (if aggressive) compact the JS heap
+  // and return the free pages of the native allocator to the system. Returns the number of
+  // reclaimed bytes of the JS heap.
+  int64_t reclaimMemory(bool aggressive);
+
+  // Release the memory of all the native caches, which are filled again on demand: pooled Java
+  // strings, @JsCacheable results and enum tables. New caches must be added here.
+  void releaseNativeCaches();
+
+  // Count the executed opcodes, the function calls and the property lookups until
+  // stopEngineProfiling() which returns the report as a JSON string. Only supported with the
+  // instrumented QuickJS interpreter (CONFIG_PROFILING): throws std::runtime_error otherwise.
+  void startEngineProfiling();
+  std::string stopEngineProfiling(int maxFunctions);
+
+  // Discard the memoized results of all the @JsCacheable Java methods (see JavaMethodCache)
+  void invalidateJavaMethodCaches() { ++m_javaMethodCacheGeneration; }
+  uint32_t getJavaMethodCacheGeneration() const { return m_javaMethodCacheGeneration; }
+  // Called by JavaMethodCache so that its entries can be released on memory pressure
+  void registerJavaMethodCache(JavaMethodCache *cache) const { m_javaMethodCaches.insert(cache); }
+  void unregisterJavaMethodCache(JavaMethodCache *cache) const { m_javaMethodCaches.erase(cache); }
+
+  // Pool the Java strings converted from JS strings up to maxLength bytes (see JavaStringPool)
+  void enableJavaStringPool(size_t maxEntries, size_t maxLength);
+  // nullptr if the pool has not been enabled
+  JavaStringPool *getJavaStringPool() const { return m_javaStringPool; }
+
   JniContext *getJniContext() { return m_jniContext; }
   const JniContext *getJniContext() const { return m_jniContext; }
   const JniCache *getJniCache() const { return m_jniCache; }
@@ -106,9 +173,14 @@ private:
   JniContext *m_jniContext = nullptr;
   JniCache *m_jniCache = nullptr;
   ExceptionHandler *m_exceptionHandler = nullptr;
+  JavaStringPool *m_javaStringPool = nullptr;
 
   const JavaTypeProvider m_javaTypeProvider;
 
+  uint32_t m_javaMethodCacheGeneration = 0;
+  mutable std::unordered_set<JavaMethodCache *> m_javaMethodCaches;
+  int64_t m_baselineHeapSize = 0;
+
 #if defined(DUKTAPE)
   duk_context *m_ctx = nullptr;
   DuktapeUtils *m_utils = nullptr;
@@ -116,6 +188,8 @@ private:
   JSRuntime *m_runtime = nullptr;
   JSContext *m_ctx = nullptr;
   QuickJsUtils *m_utils = nullptr;
+  QuickJsHeap *m_heap = nullptr;  // only with fast release
+  int m_sharedArrayBufferRefCount = 0;
 #endif
 };
 
@@ -20,14 +20,22 @@
 
 #include "DuktapeUtils.h"
 #include "ExceptionHandler.h"
+#include "JavaMethodCache.h"
 #include "JavaObject.h"
 #include "JavaScriptLambda.h"
 #include "JavaScriptObject.h"
+#include "JavaStringPool.h"
 #include "JniCache.h"
+#include "JsonTape.h"
+#include "JsonWriter.h"
+#include "NativeHeap.h"
 #include "StackChecker.h"
+#include "custom_stringify.h"
 #include "log.h"
+#include "exceptions/JniException.h"
 #include "exceptions/JsException.h"
 #include "java-types/Deferred.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
@@ -44,6 +52,22 @@
 namespace {
   const char *JSBRIDGE_CPP_CLASS_PROP_NAME = "\xff\xffjsbridge_cpp";
 
+  // Global bindings of the optional built-ins (Map/Set, Promise and String.prototype.normalize()
+  // are not provided by Duktape)
+  struct BuiltInGlobals {
+    int flag;
+    const char *names[12];
+  };
+  const BuiltInGlobals BUILTIN_GLOBALS[] = {
+      { JsBridgeContext::BUILTIN_DATE, { "Date" } },
+      { JsBridgeContext::BUILTIN_REGEXP, { "RegExp" } },
+      { JsBridgeContext::BUILTIN_EVAL, { "eval" } },
+      { JsBridgeContext::BUILTIN_PROXY, { "Proxy", "Reflect" } },
+      { JsBridgeContext::BUILTIN_TYPED_ARRAYS, {
+          "ArrayBuffer", "DataView", "Int8Array", "Uint8Array", "Uint8ClampedArray", "Int16Array",
+          "Uint16Array", "Int32Array", "Uint32Array", "Float32Array", "Float64Array" } },
+  };
+
   void debugger_detached(duk_context */*ctx*/, void *udata) {
       alog_info("Debugger detached, udata: %p\n", udata);
   }
@@ -72,19 +96,38 @@ JsBridgeContext::~JsBridgeContext() {
 
   delete m_exceptionHandler;
   delete m_utils;
+  delete m_javaStringPool;
   delete m_jniCache;
 }
 
-void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject) {
+void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject, bool /*fastRelease*/, bool /*canBlock*/, int builtIns) {
 
   m_jniContext = jniContext;
 
+  // Duktape has no heap statistics: the baseline is measured on the native heap (which might also
+  // be modified by other threads in the meantime)
+  const size_t heapSizeBefore = NativeHeap::getAllocatedSize();
+
   m_ctx = duk_create_heap(nullptr, nullptr, nullptr, nullptr, fatalErrorHandler);
 
   if (!m_ctx) {
     throw std::bad_alloc();
   }
 
+  // Duktape always creates all its built-ins (and keeps internal references to them): the unwanted
+  // ones can only be removed from the global object, which hides them from the scripts but saves
+  // little memory
+  duk_push_global_object(m_ctx);
+  for (const BuiltInGlobals &builtInGlobals : BUILTIN_GLOBALS) {
+    if (builtIns & builtInGlobals.flag) continue;
+
+    for (const char *name : builtInGlobals.names) {
+      if (name == nullptr) break;
+      duk_del_prop_string(m_ctx, -1, name);
+    }
+  }
+  duk_pop(m_ctx);
+
   m_jniCache = new JniCache(this, jsBridgeObject);
   m_utils = new DuktapeUtils(jniContext, m_ctx);
   m_exceptionHandler = new ExceptionHandler(this);
@@ -94,6 +137,9 @@ void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &j
   duk_push_pointer(m_ctx, this);
   duk_put_prop_string(m_ctx, -2, JSBRIDGE_CPP_CLASS_PROP_NAME);
   duk_pop(m_ctx);
+
+  const size_t heapSizeAfter = NativeHeap::getAllocatedSize();
+  m_baselineHeapSize = heapSizeAfter > heapSizeBefore ? static_cast<int64_t>(heapSizeAfter - heapSizeBefore) : 0;
 }
 
 void JsBridgeContext::startDebugger(int port) {
@@ -127,6 +173,11 @@ void JsBridgeContext::cancelDebug() {
     duk_trans_socket_finish();
 }
 
+void JsBridgeContext::enableJavaStringPool(size_t maxEntries, size_t maxLength) {
+  delete m_javaStringPool;
+  m_javaStringPool = new JavaStringPool(maxEntries, maxLength);
+}
+
 void JsBridgeContext::enableModuleLoader() {
   throw std::invalid_argument("Cannot use JS module loader on Duktape!");
 }
@@ -410,6 +461,134 @@ void JsBridgeContext::newJsFunction(const std::string &strGlobalName, const JObj
   duk_put_global_string(m_ctx, strGlobalName.c_str());
 }
 
+namespace {
+  extern "C"
+  duk_ret_t tryJsonDecodeSerialized(duk_context *ctx, void *) {
+    duk_json_decode(ctx, -1);
+    return 1;
+  }
+}
+
+// Duktape has no structured clone: the value is serialized as JSON and ArrayBuffers cannot be
+// detached (the transfer list is ignored)
+JValue JsBridgeContext::serializeJsValue(const std::string &strGlobalName, const std::string &, bool) {
+  CHECK_STACK(m_ctx);
+
+  duk_get_global_string(m_ctx, strGlobalName.c_str());
+
+  if (custom_stringify(m_ctx, -1, false /*keepErrorStack*/) != DUK_EXEC_SUCCESS) {
+    duk_remove(m_ctx, -2);
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  // Values without JSON representation (e.g. undefined) are serialized as an empty array
+  duk_size_t size = 0;
+  const char *json = duk_is_string(m_ctx, -1) ? duk_get_lstring(m_ctx, -1, &size) : nullptr;
+
+  JArrayLocalRef<jbyte> byteArray(m_jniContext, static_cast<jsize>(size));
+  jbyte *elements = byteArray.isNull() ? nullptr : byteArray.getMutableElements();
+  if (elements == nullptr) {
+    duk_pop_2(m_ctx);  // pop the JSON string and the value
+    throw JniException(m_jniContext);
+  }
+
+  if (size > 0) {
+    memcpy(elements, json, size);
+  }
+  duk_pop_2(m_ctx);  // pop the JSON string and the value
+
+  byteArray.releaseArrayElements();  // copy back elements to Java
+  return JValue(byteArray);
+}
+
+void JsBridgeContext::deserializeJsValue(const std::string &strGlobalName, const JniLocalRef<jarray> &data, bool /*allowSharedArrayBuffers*/) {
+  CHECK_STACK(m_ctx);
+
+  JArrayLocalRef<jbyte> byteArray(data);
+  const auto size = byteArray.getLength();
+
+  if (size == 0) {
+    duk_push_undefined(m_ctx);
+    duk_put_global_string(m_ctx, strGlobalName.c_str());
+    return;
+  }
+
+  const jbyte *elements = byteArray.getElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  duk_push_lstring(m_ctx, reinterpret_cast<const char *>(elements), static_cast<duk_size_t>(size));
+  byteArray.releaseArrayElements();
+
+  if (duk_safe_call(m_ctx, tryJsonDecodeSerialized, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  duk_put_global_string(m_ctx, strGlobalName.c_str());
+}
+
+void JsBridgeContext::assignJsonTape(const std::string &strGlobalName, const JniLocalRef<jarray> &tape) {
+  JArrayLocalRef<jbyte> byteArray(tape);
+  const auto size = static_cast<size_t>(byteArray.getLength());
+
+  const jbyte *elements = byteArray.getElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  assignJsonTape(strGlobalName, reinterpret_cast<const uint8_t *>(elements), size);
+  byteArray.releaseArrayElements();
+}
+
+void JsBridgeContext::assignJsonTape(const std::string &strGlobalName, const uint8_t *tape, size_t size) {
+  CHECK_STACK(m_ctx);
+
+  JsonTape::push(m_ctx, tape, size);
+  duk_put_global_string(m_ctx, strGlobalName.c_str());
+}
+
+namespace {
+  extern "C"
+  duk_ret_t tryWriteJson(duk_context *ctx, void *udata) {
+    static_cast<JsonWriter *>(udata)->write(ctx, -1);
+    return 0;
+  }
+}
+
+void JsBridgeContext::writeJson(const std::string &strGlobalName, const JniLocalRef<jobject> &buffer, const JniLocalRef<jobject> &output) {
+  CHECK_STACK(m_ctx);
+
+  JNIEnv *env = m_jniContext->getJNIEnv();
+  auto bufferAddress = static_cast<uint8_t *>(env->GetDirectBufferAddress(buffer.get()));
+  const jlong bufferCapacity = env->GetDirectBufferCapacity(buffer.get());
+  if (bufferAddress == nullptr || bufferCapacity <= 0) {
+    throw std::invalid_argument("Invalid JSON output buffer");
+  }
+
+  // Each full buffer is written to the Java output via JsonOutput.write(length)
+  jmethodID writeMethodId = m_jniContext->getMethodID(m_jniContext->getObjectClass(output), "write", "(I)V");
+  JsonWriter writer(bufferAddress, static_cast<size_t>(bufferCapacity), [&](size_t length) {
+    m_jniContext->callVoidMethod(output, writeMethodId, static_cast<jint>(length));
+    return !m_jniContext->exceptionCheck();
+  });
+
+  duk_get_global_string(m_ctx, strGlobalName.c_str());
+
+  if (duk_safe_call(m_ctx, tryWriteJson, &writer, 1, 1) != DUK_EXEC_SUCCESS) {
+    if (writer.hasFlushFailed()) {
+      duk_pop(m_ctx);
+      throw JniException(m_jniContext);
+    }
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  duk_pop(m_ctx);
+}
+
+void JsBridgeContext::releaseSerializedJsValue(const JniLocalRef<jarray> &) {
+  // No SharedArrayBuffer
+}
+
 void JsBridgeContext::convertJavaValueToJs(const std::string &strGlobalName, const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter) {
 
   auto type = m_javaTypeProvider.makeUniqueType(parameter, true /*boxed*/);
@@ -422,6 +601,45 @@ void JsBridgeContext::processPromiseQueue() {
   // No built-in promise
 }
 
+int64_t JsBridgeContext::reclaimMemory(bool aggressive) {
+  // Duktape has no heap statistics: the reclaimed bytes are measured on the native heap (which
+  // might also be modified by other threads in the meantime)
+  const size_t sizeBefore = NativeHeap::getAllocatedSize();
+
+  // Called twice so that objects with a finalizer are also freed
+  const duk_uint_t flags = aggressive ? DUK_GC_COMPACT : 0;
+  duk_gc(m_ctx, flags);
+  duk_gc(m_ctx, flags);
+
+  const size_t sizeAfter = NativeHeap::getAllocatedSize();
+
+  releaseNativeCaches();
+
+  if (aggressive) {
+    NativeHeap::trim();
+  }
+
+  return sizeBefore > sizeAfter ? static_cast<int64_t>(sizeBefore - sizeAfter) : 0;
+}
+
+void JsBridgeContext::releaseNativeCaches() {
+  if (m_javaStringPool != nullptr) {
+    m_javaStringPool->clear();
+  }
+  for (JavaMethodCache *javaMethodCache : m_javaMethodCaches) {
+    javaMethodCache->clear();
+  }
+  m_javaTypeProvider.releaseEnumTables();
+}
+
+void JsBridgeContext::startEngineProfiling() {
+  throw std::runtime_error("Engine profiling is not supported with Duktape");
+}
+
+std::string JsBridgeContext::stopEngineProfiling(int /*maxFunctions*/) {
+  throw std::runtime_error("Engine profiling is not supported with Duktape");
+}
+
 // static
 JsBridgeContext *JsBridgeContext::getInstance(duk_context *ctx) {
   duk_push_global_stash(ctx);
@@ -17,12 +17,18 @@
 
 #include "AutoReleasedJSValue.h"
 #include "ExceptionHandler.h"
+#include "JavaMethodCache.h"
 #include "JavaObject.h"
 #include "JavaScriptLambda.h"
 #include "JavaScriptObject.h"
+#include "JavaStringPool.h"
 #include "JavaType.h"
 #include "JavaTypeProvider.h"
 #include "JniCache.h"
+#include "JsonTape.h"
+#include "JsonWriter.h"
+#include "NativeHeap.h"
+#include "QuickJsHeap.h"
 #include "QuickJsUtils.h"
 #include "custom_stringify.h"
 #include "log.h"
@@ -30,7 +36,12 @@
 #include "exceptions/JsException.h"
 #include "java-types/Deferred.h"
 #include "java-types/Object.h"
+#include "jni-helpers/JArrayLocalRef.h"
+#include <atomic>
+#include <cstdlib>
 #include <functional>
+#include <new>
+#include <stdexcept>
 
 
 // Internal
@@ -86,6 +97,77 @@ namespace {
     // Reject the Java Deferred
     jsBridgeContext->getJniCache()->getJsBridgeInterface().addUnhandledJsPromiseException(value);
   }
+
+  // Backing store of a SharedArrayBuffer, allocated outside of the QuickJS runtimes so that it
+  // can be shared between JsBridge instances (and workers). The data is released when the last
+  // SharedArrayBuffer (or serialized message) referencing it is gone.
+  struct alignas(16) SharedArrayBufferHeader {
+    std::atomic<int> refCount;
+  };
+
+  // When called by a runtime, the opaque is the number of SharedArrayBuffer references held by
+  // that runtime (nullptr for serialized values)
+  void countSharedArrayBufferRefs(void *opaque, int delta) {
+    if (opaque != nullptr) {
+      *static_cast<int *>(opaque) += delta;
+    }
+  }
+
+  void *sharedArrayBufferAlloc(void *opaque, size_t size) {
+    void *ptr = malloc(sizeof(SharedArrayBufferHeader) + size);
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+
+    auto header = new (ptr) SharedArrayBufferHeader();
+    header->refCount.store(1, std::memory_order_relaxed);
+    countSharedArrayBufferRefs(opaque, 1);
+    return header + 1;
+  }
+
+  void sharedArrayBufferFree(void *opaque, void *data) {
+    countSharedArrayBufferRefs(opaque, -1);
+
+    auto header = static_cast<SharedArrayBufferHeader *>(data) - 1;
+    if (header->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      header->~SharedArrayBufferHeader();
+      free(header);
+    }
+  }
+
+  void sharedArrayBufferDup(void *opaque, void *data) {
+    countSharedArrayBufferRefs(opaque, 1);
+
+    auto header = static_cast<SharedArrayBufferHeader *>(data) - 1;
+    header->refCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Serialized values start with the SharedArrayBuffers they reference (which are kept alive until
+  // the value has been deserialized):
+  // [uint32_t count][count * void *][JS_WriteObject() data]
+  size_t getSerializedHeaderSize(const uint8_t *data, size_t size) {
+    uint32_t count = 0;
+    if (size < sizeof(uint32_t)) {
+      throw std::invalid_argument("Invalid serialized JS value");
+    }
+    memcpy(&count, data, sizeof(uint32_t));
+
+    if (count > (size - sizeof(uint32_t)) / sizeof(void *)) {
+      throw std::invalid_argument("Invalid serialized JS value");
+    }
+    return sizeof(uint32_t) + count * sizeof(void *);
+  }
+
+  void releaseSerializedSharedArrayBuffers(const uint8_t *data) {
+    uint32_t count = 0;
+    memcpy(&count, data, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < count; ++i) {
+      void *sharedArrayBuffer = nullptr;
+      memcpy(&sharedArrayBuffer, data + sizeof(uint32_t) + i * sizeof(void *), sizeof(void *));
+      sharedArrayBufferFree(nullptr, sharedArrayBuffer);
+    }
+  }
 }
 
 
@@ -97,22 +179,61 @@ JsBridgeContext::JsBridgeContext()
 }
 
 JsBridgeContext::~JsBridgeContext() {
-  JS_FreeContext(m_ctx);
-  JS_FreeRuntime(m_runtime);
+  m_javaTypeProvider.releaseEnumTables();
+
+  if (m_heap != nullptr && m_sharedArrayBufferRefCount == 0) {
+    // Fast release: delete the C++ instances and JNI refs wrapped in JS values, and then discard
+    // the whole JS heap without finalizing each JS value.
+    // SharedArrayBuffers are not allocated in the heap so they need the regular release.
+    m_utils->deleteAllCppWrappers();
+    m_heap->freeAll();
+  } else {
+    JS_FreeContext(m_ctx);
+    JS_FreeRuntime(m_runtime);
+  }
 
+  delete m_heap;
   delete m_exceptionHandler;
   delete m_utils;
+  delete m_javaStringPool;
   delete m_jniCache;
 }
 
-void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject) {
+void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject, bool fastRelease, bool canBlock, int builtIns) {
   m_jniContext = jniContext;
 
-  m_runtime = JS_NewRuntime();
+  if (fastRelease) {
+    m_heap = new QuickJsHeap();
+    m_runtime = JS_NewRuntime2(&QuickJsHeap::mallocFunctions, m_heap);
+  } else {
+    m_runtime = JS_NewRuntime();
+  }
 
   //JS_SetInterruptHandler(rt, interrupt_handler, NULL)
 
-  m_ctx = JS_NewContext(m_runtime);
+  // Same as JS_NewContext() but only with the requested built-ins
+  m_ctx = JS_NewContextRaw(m_runtime);
+  if (m_ctx == nullptr) {
+    throw std::bad_alloc();
+  }
+  JS_AddIntrinsicBaseObjects(m_ctx);
+  JS_AddIntrinsicJSON(m_ctx);
+  JS_AddIntrinsicEval(m_ctx);  // needed by JS_Eval(), only the global eval() is optional
+  if (builtIns & BUILTIN_DATE) JS_AddIntrinsicDate(m_ctx);
+  if (builtIns & BUILTIN_REGEXP) JS_AddIntrinsicRegExp(m_ctx);
+  if (builtIns & BUILTIN_PROXY) JS_AddIntrinsicProxy(m_ctx);
+  if (builtIns & BUILTIN_MAP_SET) JS_AddIntrinsicMapSet(m_ctx);
+  if (builtIns & BUILTIN_TYPED_ARRAYS) JS_AddIntrinsicTypedArrays(m_ctx);
+  if (builtIns & BUILTIN_PROMISE) JS_AddIntrinsicPromise(m_ctx);
+  if (builtIns & BUILTIN_STRING_NORMALIZE) JS_AddIntrinsicStringNormalize(m_ctx);
+  if (!(builtIns & BUILTIN_EVAL)) {
+    JSValue globalObj = JS_GetGlobalObject(m_ctx);
+    JSAtom evalAtom = JS_NewAtom(m_ctx, "eval");
+    JS_DeleteProperty(m_ctx, globalObj, evalAtom, 0);
+    JS_FreeAtom(m_ctx, evalAtom);
+    JS_FreeValue(m_ctx, globalObj);
+  }
+
   JS_SetMaxStackSize(m_runtime, 1 * 1024 * 1024);  // default: 256kb, now: 1MB
 
   m_jniCache = new JniCache(this, jsBridgeObject);
@@ -128,6 +249,21 @@ void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &j
 
   // Unhandled promise exceptions
   JS_SetHostPromiseRejectionTracker(m_runtime, promiseRejectionTracker, nullptr);
+
+  // SharedArrayBuffers which can be shared with other contexts. Atomics.wait() may only block in
+  // worker contexts: in the main context, it would stall all the pending calls of the bridge.
+  const JSSharedArrayBufferFunctions sharedArrayBufferFunctions = {
+      sharedArrayBufferAlloc,
+      sharedArrayBufferFree,
+      sharedArrayBufferDup,
+      &m_sharedArrayBufferRefCount
+  };
+  JS_SetSharedArrayBufferFunctions(m_runtime, &sharedArrayBufferFunctions);
+  JS_SetCanBlock(m_runtime, canBlock);
+
+  JSMemoryUsage memoryUsage;
+  JS_ComputeMemoryUsage(m_runtime, &memoryUsage);
+  m_baselineHeapSize = memoryUsage.malloc_size;
 }
 
 void JsBridgeContext::startDebugger(int /*port*/) {
@@ -138,6 +274,11 @@ void JsBridgeContext::cancelDebug() {
   // Not supported yet
 }
 
+void JsBridgeContext::enableJavaStringPool(size_t maxEntries, size_t maxLength) {
+  delete m_javaStringPool;
+  m_javaStringPool = new JavaStringPool(maxEntries, maxLength);
+}
+
 void JsBridgeContext::enableModuleLoader() {
   JS_SetModuleLoaderFunc(m_runtime, nullptr, jsModuleLoader, nullptr);
 }
@@ -394,6 +535,174 @@ void JsBridgeContext::newJsFunction(const std::string &strGlobalName, const JObj
   JS_FreeValue(m_ctx, globalObj);
 }
 
+JValue JsBridgeContext::serializeJsValue(const std::string &strGlobalName, const std::string &strTransferListGlobalName, bool allowSharedArrayBuffers) {
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JS_AUTORELEASE_VALUE(m_ctx, globalObj);
+
+  JSValue value = JS_GetPropertyStr(m_ctx, globalObj, strGlobalName.c_str());
+  JS_AUTORELEASE_VALUE(m_ctx, value);
+
+  // Keep shared and cyclic references, as the structured clone algorithm does
+  size_t size = 0;
+  uint8_t **sharedArrayBuffers = nullptr;
+  size_t sharedArrayBufferCount = 0;
+  const int flags = JS_WRITE_OBJ_REFERENCE | (allowSharedArrayBuffers ? JS_WRITE_OBJ_SAB : 0);
+  uint8_t *buffer = JS_WriteObject2(m_ctx, &size, value, flags, &sharedArrayBuffers, &sharedArrayBufferCount);
+  if (buffer == nullptr) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  const size_t headerSize = sizeof(uint32_t) + sharedArrayBufferCount * sizeof(void *);
+  JArrayLocalRef<jbyte> byteArray(m_jniContext, static_cast<jsize>(headerSize + size));
+  jbyte *elements = byteArray.isNull() ? nullptr : byteArray.getMutableElements();
+  if (elements == nullptr) {
+    js_free(m_ctx, sharedArrayBuffers);
+    js_free(m_ctx, buffer);
+    throw JniException(m_jniContext);
+  }
+
+  // The serialized value holds a reference to its SharedArrayBuffers
+  auto count = static_cast<uint32_t>(sharedArrayBufferCount);
+  memcpy(elements, &count, sizeof(uint32_t));
+  for (size_t i = 0; i < sharedArrayBufferCount; ++i) {
+    sharedArrayBufferDup(nullptr, sharedArrayBuffers[i]);
+    memcpy(elements + sizeof(uint32_t) + i * sizeof(void *), &sharedArrayBuffers[i], sizeof(void *));
+  }
+  js_free(m_ctx, sharedArrayBuffers);
+
+  memcpy(elements + headerSize, buffer, size);
+  js_free(m_ctx, buffer);
+  byteArray.releaseArrayElements();  // copy back elements to Java
+
+  if (!strTransferListGlobalName.empty()) {
+    JSValue transferList = JS_GetPropertyStr(m_ctx, globalObj, strTransferListGlobalName.c_str());
+    JS_AUTORELEASE_VALUE(m_ctx, transferList);
+
+    uint32_t length = 0;
+    JSValue lengthValue = JS_GetPropertyStr(m_ctx, transferList, "length");
+    JS_ToUint32(m_ctx, &length, lengthValue);
+    JS_FreeValue(m_ctx, lengthValue);
+
+    // Transferred buffers are not usable anymore in the current context (other values are ignored)
+    for (uint32_t i = 0; i < length; ++i) {
+      JSValue transferable = JS_GetPropertyUint32(m_ctx, transferList, i);
+      JS_DetachArrayBuffer(m_ctx, transferable);
+      JS_FreeValue(m_ctx, transferable);
+    }
+  }
+
+  return JValue(byteArray);
+}
+
+void JsBridgeContext::deserializeJsValue(const std::string &strGlobalName, const JniLocalRef<jarray> &data, bool allowSharedArrayBuffers) {
+  JArrayLocalRef<jbyte> byteArray(data);
+  const auto size = static_cast<size_t>(byteArray.getLength());
+
+  const jbyte *elements = byteArray.getElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  auto serializedValue = reinterpret_cast<const uint8_t *>(elements);
+  const size_t headerSize = getSerializedHeaderSize(serializedValue, size);
+
+  JSValue value;
+  if (allowSharedArrayBuffers) {
+    // The deserialized SharedArrayBuffers hold their own reference
+    value = JS_ReadObject(m_ctx, serializedValue + headerSize, size - headerSize, JS_READ_OBJ_REFERENCE | JS_READ_OBJ_SAB);
+    releaseSerializedSharedArrayBuffers(serializedValue);
+  } else {
+    // Untrusted data: the header must not contain any SharedArrayBuffer pointer (which would be
+    // used or freed as is)
+    if (headerSize != sizeof(uint32_t)) {
+      byteArray.releaseArrayElements();
+      throw std::invalid_argument("Invalid serialized JS value (unexpected SharedArrayBuffers)");
+    }
+    value = JS_ReadObject(m_ctx, serializedValue + headerSize, size - headerSize, JS_READ_OBJ_REFERENCE);
+  }
+  byteArray.releaseArrayElements();
+
+  if (JS_IsException(value)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), value);
+  // No JS_FreeValue(m_ctx, value) after JS_SetPropertyStr
+  JS_FreeValue(m_ctx, globalObj);
+}
+
+void JsBridgeContext::assignJsonTape(const std::string &strGlobalName, const JniLocalRef<jarray> &tape) {
+  JArrayLocalRef<jbyte> byteArray(tape);
+  const auto size = static_cast<size_t>(byteArray.getLength());
+
+  const jbyte *elements = byteArray.getElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  assignJsonTape(strGlobalName, reinterpret_cast<const uint8_t *>(elements), size);
+  byteArray.releaseArrayElements();
+}
+
+void JsBridgeContext::assignJsonTape(const std::string &strGlobalName, const uint8_t *tape, size_t size) {
+  JSValue value = JsonTape::toJsValue(m_ctx, tape, size);
+  if (JS_IsException(value)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), value);
+  // No JS_FreeValue(m_ctx, value) after JS_SetPropertyStr
+  JS_FreeValue(m_ctx, globalObj);
+}
+
+void JsBridgeContext::writeJson(const std::string &strGlobalName, const JniLocalRef<jobject> &buffer, const JniLocalRef<jobject> &output) {
+
+  JNIEnv *env = m_jniContext->getJNIEnv();
+  auto bufferAddress = static_cast<uint8_t *>(env->GetDirectBufferAddress(buffer.get()));
+  const jlong bufferCapacity = env->GetDirectBufferCapacity(buffer.get());
+  if (bufferAddress == nullptr || bufferCapacity <= 0) {
+    throw std::invalid_argument("Invalid JSON output buffer");
+  }
+
+  // Each full buffer is written to the Java output via JsonOutput.write(length)
+  jmethodID writeMethodId = m_jniContext->getMethodID(m_jniContext->getObjectClass(output), "write", "(I)V");
+  JsonWriter writer(bufferAddress, static_cast<size_t>(bufferCapacity), [&](size_t length) {
+    m_jniContext->callVoidMethod(output, writeMethodId, static_cast<jint>(length));
+    return !m_jniContext->exceptionCheck();
+  });
+
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValue value = JS_GetPropertyStr(m_ctx, globalObj, strGlobalName.c_str());
+  JS_FreeValue(m_ctx, globalObj);
+
+  const bool success = writer.write(m_ctx, value);
+  JS_FreeValue(m_ctx, value);
+
+  if (!success) {
+    if (writer.hasFlushFailed()) {
+      throw JniException(m_jniContext);
+    }
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+}
+
+void JsBridgeContext::releaseSerializedJsValue(const JniLocalRef<jarray> &data) {
+  JArrayLocalRef<jbyte> byteArray(data);
+  const auto size = static_cast<size_t>(byteArray.getLength());
+
+  const jbyte *elements = byteArray.getElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  auto serializedValue = reinterpret_cast<const uint8_t *>(elements);
+  getSerializedHeaderSize(serializedValue, size);  // check
+  releaseSerializedSharedArrayBuffers(serializedValue);
+  byteArray.releaseArrayElements();
+}
+
 void JsBridgeContext::convertJavaValueToJs(const std::string &strGlobalName, const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter) {
 
   auto type = m_javaTypeProvider.makeUniqueType(parameter, true /*boxed*/);
@@ -425,6 +734,69 @@ void JsBridgeContext::processPromiseQueue() {
   }
 }
 
+int64_t JsBridgeContext::reclaimMemory(bool aggressive) {
+  JSMemoryUsage usageBefore;
+  JS_ComputeMemoryUsage(m_runtime, &usageBefore);
+
+  // Collect cycles (reference counted values are already freed)
+  JS_RunGC(m_runtime);
+
+  JSMemoryUsage usageAfter;
+  JS_ComputeMemoryUsage(m_runtime, &usageAfter);
+
+  releaseNativeCaches();
+
+  if (aggressive) {
+    // QuickJS does not compact its heap but the freed blocks can be returned to the system
+    NativeHeap::trim();
+  }
+
+  return usageBefore.malloc_size - usageAfter.malloc_size;
+}
+
+void JsBridgeContext::releaseNativeCaches() {
+  if (m_javaStringPool != nullptr) {
+    m_javaStringPool->clear();
+  }
+  for (JavaMethodCache *javaMethodCache : m_javaMethodCaches) {
+    javaMethodCache->clear();
+  }
+  m_javaTypeProvider.releaseEnumTables();
+}
+
+void JsBridgeContext::startEngineProfiling() {
+#ifdef CONFIG_PROFILING
+  JS_ResetProfile(m_runtime);
+  JS_SetProfilingEnabled(m_runtime, true);
+#else
+  throw std::runtime_error("Engine profiling is only available with the instrumented QuickJS interpreter");
+#endif
+}
+
+std::string JsBridgeContext::stopEngineProfiling(int maxFunctions) {
+#ifdef CONFIG_PROFILING
+  JS_SetProfilingEnabled(m_runtime, false);
+
+  JSValue profile = JS_GetProfile(m_ctx, maxFunctions);
+  if (JS_IsException(profile)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JSValue jsonValue = JS_JSONStringify(m_ctx, profile, JS_UNDEFINED, JS_UNDEFINED);
+  JS_FreeValue(m_ctx, profile);
+  if (JS_IsException(jsonValue)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  std::string json = m_utils->toString(jsonValue);
+  JS_FreeValue(m_ctx, jsonValue);
+  return json;
+#else
+  (void) maxFunctions;
+  throw std::runtime_error("Engine profiling is only available with the instrumented QuickJS interpreter");
+#endif
+}
+
 // static
 JsBridgeContext *JsBridgeContext::getInstance(JSContext *ctx) {
   //return QuickJsUtils::getCppPtrStatic<JsBridgeContext>(ctx, JSBRIDGE_CPP_CLASS_PROP_NAME);
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsThread.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+
+namespace {
+  [[noreturn]] void throwErrno(const std::string &what) {
+    throw std::runtime_error(what + ": " + strerror(errno));
+  }
+}
+
+namespace JsThread {
+
+  // Note: on Linux, the nice value and the affinity of "process 0" are the ones of the calling thread
+
+  void setPriority(int priority) {
+    if (setpriority(PRIO_PROCESS, 0, priority) != 0) {
+      throwErrno("Cannot set the priority of the JS thread to " + std::to_string(priority));
+    }
+  }
+
+  int getPriority() {
+    errno = 0;
+    int priority = getpriority(PRIO_PROCESS, 0);
+    if (priority == -1 && errno != 0) {
+      throwErrno("Cannot get the priority of the JS thread");
+    }
+    return priority;
+  }
+
+  void setAffinity(const std::vector<int> &cpus) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu : cpus) {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        throw std::invalid_argument("Invalid CPU index: " + std::to_string(cpu));
+      }
+      CPU_SET(cpu, &cpuSet);
+    }
+
+    if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+      throwErrno("Cannot set the CPU affinity of the JS thread");
+    }
+  }
+
+  std::vector<int> getAffinity() {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+      throwErrno("Cannot get the CPU affinity of the JS thread");
+    }
+
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpuSet)) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+
+  int getCurrentCpu() {
+    int cpu = sched_getcpu();
+    if (cpu < 0) {
+      throwErrno("Cannot get the current CPU of the JS thread");
+    }
+    return cpu;
+  }
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSTHREAD_H
+#define _JSBRIDGE_JSTHREAD_H
+
+#include <vector>
+
+// Scheduling settings of the current (JS) thread. System errors are thrown as std::runtime_error.
+namespace JsThread {
+
+  // Linux nice value (-20..19)
+  void setPriority(int priority);
+  int getPriority();
+
+  // CPUs the thread is allowed to run on. setAffinity() throws std::invalid_argument if a CPU index
+  // is out of range.
+  void setAffinity(const std::vector<int> &cpus);
+  std::vector<int> getAffinity();
+
+  // CPU the thread is currently running on
+  int getCurrentCpu();
+}
+
+#endif
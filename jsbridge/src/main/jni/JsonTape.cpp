@@ -0,0 +1,858 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsonTape.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+  // Same order of magnitude as the JSON.parse() limits of the JS engines
+  const int MAX_DEPTH = 512;
+
+  // Size of the chunks read via JsonTape::ReadFunction
+  const size_t CHUNK_SIZE = 64 * 1024;
+
+  // The JSON text is either given at once or read chunk by chunk: in the latter case, only the
+  // current chunk and the current token need to be kept in memory.
+  class Parser {
+  public:
+    Parser(const char *json, size_t length)
+     : m_p(json)
+     , m_end(json + length) {
+    }
+
+    explicit Parser(JsonTape::ReadFunction read)
+     : m_read(std::move(read))
+     , m_chunk(CHUNK_SIZE) {
+    }
+
+    std::vector<uint8_t> parse() {
+      // Skip UTF-8 BOM
+      if (peek() == 0xEF) {
+        expectLiteral("\xEF\xBB\xBF", 3);
+      }
+
+      skipWhitespace();
+      parseValue(0);
+      skipWhitespace();
+      if (peek() != -1) {
+        fail("Unexpected data after JSON value");
+      }
+
+      return std::move(m_tape);
+    }
+
+  private:
+    [[noreturn]] static void fail(const char *message) {
+      throw std::invalid_argument(message);
+    }
+
+    // Read the next chunk if the current one has been consumed. Returns false at the end of data.
+    bool fill() {
+      if (m_p != m_end) {
+        return true;
+      }
+      if (!m_read) {
+        return false;
+      }
+
+      const size_t length = m_read(m_chunk.data(), m_chunk.size());
+      if (length == 0) {
+        m_read = nullptr;
+        return false;
+      }
+      m_p = m_chunk.data();
+      m_end = m_p + length;
+      return true;
+    }
+
+    // Next byte (without consuming it) or -1 at the end of data
+    int peek() {
+      return fill() ? static_cast<uint8_t>(*m_p) : -1;
+    }
+
+    char next(const char *endMessage) {
+      if (!fill()) {
+        fail(endMessage);
+      }
+      return *m_p++;
+    }
+
+    void skipWhitespace() {
+      while (fill()) {
+        while (m_p != m_end && (*m_p == ' ' || *m_p == '\n' || *m_p == '\r' || *m_p == '\t')) {
+          ++m_p;
+        }
+        if (m_p != m_end) {
+          return;
+        }
+      }
+    }
+
+    void expectLiteral(const char *literal, size_t length) {
+      for (size_t i = 0; i < length; ++i) {
+        if (peek() != static_cast<uint8_t>(literal[i])) {
+          fail("Invalid JSON literal");
+        }
+        ++m_p;
+      }
+    }
+
+    void writeLeb128(uint32_t value) {
+      while (value >= 0x80) {
+        m_tape.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+      }
+      m_tape.push_back(static_cast<uint8_t>(value));
+    }
+
+    void writeBytes(const void *data, size_t size) {
+      auto bytes = static_cast<const uint8_t *>(data);
+      m_tape.insert(m_tape.end(), bytes, bytes + size);
+    }
+
+    void parseValue(int depth) {
+      switch (peek()) {
+        case -1:
+          fail("Unexpected end of JSON data");
+        case '{':
+          parseObject(depth + 1);
+          break;
+        case '[':
+          parseArray(depth + 1);
+          break;
+        case '"':
+          parseString(m_stringBuffer);
+          m_tape.push_back('s');
+          writeLeb128(static_cast<uint32_t>(m_stringBuffer.size()));
+          writeBytes(m_stringBuffer.data(), m_stringBuffer.size());
+          break;
+        case 't':
+          expectLiteral("true", 4);
+          m_tape.push_back('t');
+          break;
+        case 'f':
+          expectLiteral("false", 5);
+          m_tape.push_back('f');
+          break;
+        case 'n':
+          expectLiteral("null", 4);
+          m_tape.push_back('n');
+          break;
+        default:
+          parseNumber();
+          break;
+      }
+    }
+
+    // The element count is written once all the elements have been parsed
+    size_t beginContainer(uint8_t tag, int depth) {
+      if (depth > MAX_DEPTH) {
+        fail("JSON data is too deeply nested");
+      }
+
+      m_tape.push_back(tag);
+      const size_t countOffset = m_tape.size();
+      m_tape.resize(countOffset + sizeof(uint32_t));
+      return countOffset;
+    }
+
+    void endContainer(size_t countOffset, uint32_t count) {
+      memcpy(m_tape.data() + countOffset, &count, sizeof(count));
+    }
+
+    void parseArray(int depth) {
+      const size_t countOffset = beginContainer('[', depth);
+      uint32_t count = 0;
+
+      ++m_p;  // [
+      skipWhitespace();
+      if (peek() == ']') {
+        ++m_p;
+        endContainer(countOffset, count);
+        return;
+      }
+
+      while (true) {
+        skipWhitespace();
+        parseValue(depth);
+        ++count;
+
+        skipWhitespace();
+        const int c = peek();
+        if (c == -1) {
+          fail("Unexpected end of JSON array");
+        }
+        if (c == ',') {
+          ++m_p;
+          continue;
+        }
+        if (c == ']') {
+          ++m_p;
+          break;
+        }
+        fail("Expected ',' or ']' in JSON array");
+      }
+
+      endContainer(countOffset, count);
+    }
+
+    void parseObject(int depth) {
+      const size_t countOffset = beginContainer('{', depth);
+      uint32_t count = 0;
+
+      ++m_p;  // {
+      skipWhitespace();
+      if (peek() == '}') {
+        ++m_p;
+        endContainer(countOffset, count);
+        return;
+      }
+
+      while (true) {
+        skipWhitespace();
+        if (peek() != '"') {
+          fail("Expected string key in JSON object");
+        }
+        parseKey();
+
+        skipWhitespace();
+        if (peek() != ':') {
+          fail("Expected ':' in JSON object");
+        }
+        ++m_p;
+
+        skipWhitespace();
+        parseValue(depth);
+        ++count;
+
+        skipWhitespace();
+        const int c = peek();
+        if (c == -1) {
+          fail("Unexpected end of JSON object");
+        }
+        if (c == ',') {
+          ++m_p;
+          continue;
+        }
+        if (c == '}') {
+          ++m_p;
+          break;
+        }
+        fail("Expected ',' or '}' in JSON object");
+      }
+
+      endContainer(countOffset, count);
+    }
+
+    void parseKey() {
+      parseString(m_keyBuffer);
+
+      auto it = m_keyIndexes.find(m_keyBuffer);
+      if (it != m_keyIndexes.end()) {
+        m_tape.push_back('k');
+        writeLeb128(it->second);
+        return;
+      }
+
+      const auto index = static_cast<uint32_t>(m_keyIndexes.size());
+      m_keyIndexes.emplace(m_keyBuffer, index);
+
+      m_tape.push_back('K');
+      writeLeb128(static_cast<uint32_t>(m_keyBuffer.size()));
+      writeBytes(m_keyBuffer.data(), m_keyBuffer.size());
+    }
+
+    static void appendCodePoint(std::string &out, uint32_t cp) {
+      if (cp < 0x80) {
+        out += static_cast<char>(cp);
+      } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+      } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+      } else {
+#if defined(DUKTAPE)
+        // Duktape expects CESU-8: each surrogate is encoded separately
+        cp -= 0x10000;
+        appendCodePoint(out, 0xD800 + (cp >> 10));
+        appendCodePoint(out, 0xDC00 + (cp & 0x3FF));
+#else
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+#endif
+      }
+    }
+
+    uint32_t parseHex4() {
+      uint32_t value = 0;
+      for (int i = 0; i < 4; ++i) {
+        const char c = next("Invalid JSON unicode escape");
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else fail("Invalid JSON unicode escape");
+      }
+      return value;
+    }
+
+    static void appendSimpleEscape(std::string &out, char c) {
+      switch (c) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        default:
+          fail("Invalid JSON escape sequence");
+      }
+    }
+
+    void parseEscape(std::string &out) {
+      char c = next("Unexpected end of JSON string");
+      if (c != 'u') {
+        appendSimpleEscape(out, c);
+        return;
+      }
+
+      uint32_t cp = parseHex4();
+
+      // A high surrogate followed by a low surrogate escape is combined into a single code point.
+      // Lone surrogates are kept as 3-byte sequences (like JS strings).
+      while (cp >= 0xD800 && cp < 0xDC00 && peek() == '\\') {
+        ++m_p;
+        c = next("Unexpected end of JSON string");
+        if (c != 'u') {
+          appendCodePoint(out, cp);
+          appendSimpleEscape(out, c);
+          return;
+        }
+
+        const uint32_t nextCp = parseHex4();
+        if (nextCp >= 0xDC00 && nextCp < 0xE000) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (nextCp - 0xDC00);
+          break;
+        }
+        appendCodePoint(out, cp);
+        cp = nextCp;
+      }
+
+      appendCodePoint(out, cp);
+    }
+
+    // Copy a (validated) multi-byte UTF-8 sequence
+    void parseUtf8Sequence(std::string &out) {
+      const auto c = static_cast<uint8_t>(*m_p++);
+      size_t length;
+      uint32_t cp;
+      if (c >= 0xC2 && c <= 0xDF) { length = 2; cp = c & 0x1F; }
+      else if (c >= 0xE0 && c <= 0xEF) { length = 3; cp = c & 0x0F; }
+      else if (c >= 0xF0 && c <= 0xF4) { length = 4; cp = c & 0x07; }
+      else fail("Invalid UTF-8 data in JSON string");
+
+      char bytes[4] = { static_cast<char>(c) };
+      for (size_t i = 1; i < length; ++i) {
+        const int cc = peek();
+        if (cc == -1 || (cc & 0xC0) != 0x80) {
+          fail("Invalid UTF-8 data in JSON string");
+        }
+        bytes[i] = *m_p++;
+        cp = (cp << 6) | (cc & 0x3F);
+      }
+      if ((length == 3 && (cp < 0x800 || (cp >= 0xD800 && cp < 0xE000))) || (length == 4 && (cp < 0x10000 || cp > 0x10FFFF))) {
+        fail("Invalid UTF-8 data in JSON string");
+      }
+
+#if defined(DUKTAPE)
+      if (length == 4) {
+        appendCodePoint(out, cp);
+        return;
+      }
+#endif
+      out.append(bytes, length);
+    }
+
+    void parseString(std::string &out) {
+      out.clear();
+      ++m_p;  // opening quote
+
+      while (true) {
+        if (!fill()) {
+          fail("Unexpected end of JSON string");
+        }
+
+        // Copy plain ASCII runs at once
+        const char *runStart = m_p;
+        while (m_p != m_end) {
+          const auto c = static_cast<uint8_t>(*m_p);
+          if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) break;
+          ++m_p;
+        }
+        out.append(runStart, m_p - runStart);
+
+        if (m_p == m_end) {
+          continue;  // next chunk
+        }
+
+        const auto c = static_cast<uint8_t>(*m_p);
+        if (c == '"') {
+          ++m_p;
+          return;
+        } else if (c == '\\') {
+          ++m_p;
+          parseEscape(out);
+        } else if (c < 0x20) {
+          fail("Invalid control character in JSON string");
+        } else {
+          parseUtf8Sequence(out);
+        }
+      }
+    }
+
+    static bool isDigit(int c) {
+      return c >= '0' && c <= '9';
+    }
+
+    // The number text is copied into m_numberBuffer (it may span several chunks)
+    void takeNumberChar() {
+      m_numberBuffer += *m_p++;
+    }
+
+    void takeDigits() {
+      while (isDigit(peek())) {
+        takeNumberChar();
+      }
+    }
+
+    void parseNumber() {
+      m_numberBuffer.clear();
+      bool isInteger = true;
+
+      if (peek() == '-') {
+        takeNumberChar();
+      }
+
+      if (!isDigit(peek())) {
+        fail("Invalid JSON value");
+      }
+      if (peek() == '0') {
+        takeNumberChar();
+      } else {
+        takeDigits();
+      }
+
+      if (peek() == '.') {
+        isInteger = false;
+        takeNumberChar();
+        if (!isDigit(peek())) {
+          fail("Invalid JSON number");
+        }
+        takeDigits();
+      }
+
+      const int e = peek();
+      if (e == 'e' || e == 'E') {
+        isInteger = false;
+        takeNumberChar();
+        const int sign = peek();
+        if (sign == '+' || sign == '-') takeNumberChar();
+        if (!isDigit(peek())) {
+          fail("Invalid JSON number");
+        }
+        takeDigits();
+      }
+
+      const char *start = m_numberBuffer.data();
+      const size_t length = m_numberBuffer.size();
+
+      // Small integers (except -0) are stored as int32
+      const bool isNegative = *start == '-';
+      const size_t digitCount = length - (isNegative ? 1 : 0);
+      if (isInteger && digitCount <= 10 && !(isNegative && start[1] == '0')) {
+        int64_t value = 0;
+        for (const char *d = start + (isNegative ? 1 : 0); d != start + length; ++d) {
+          value = value * 10 + (*d - '0');
+        }
+        if (isNegative) value = -value;
+
+        if (value >= INT32_MIN && value <= INT32_MAX) {
+          const auto i = static_cast<int32_t>(value);
+          m_tape.push_back('i');
+          writeBytes(&i, sizeof(i));
+          return;
+        }
+      }
+
+      const double d = strtod(m_numberBuffer.c_str(), nullptr);
+      m_tape.push_back('d');
+      writeBytes(&d, sizeof(d));
+    }
+
+    const char *m_p = nullptr;
+    const char *m_end = nullptr;
+    JsonTape::ReadFunction m_read;
+    std::vector<char> m_chunk;
+
+    std::vector<uint8_t> m_tape;
+    std::unordered_map<std::string, uint32_t> m_keyIndexes;
+    std::string m_keyBuffer;
+    std::string m_stringBuffer;
+    std::string m_numberBuffer;
+  };
+
+  class TapeReader {
+  public:
+    TapeReader(const uint8_t *tape, size_t size)
+     : m_p(tape)
+     , m_end(tape + size) {
+    }
+
+    bool atEnd() const {
+      return m_p == m_end;
+    }
+
+    uint8_t readTag() {
+      check(1);
+      return *m_p++;
+    }
+
+    uint32_t readLeb128() {
+      uint32_t value = 0;
+      for (int shift = 0; shift < 35; shift += 7) {
+        const uint8_t b = readTag();
+        value |= static_cast<uint32_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+          return value;
+        }
+      }
+      throw std::invalid_argument("Invalid JSON tape");
+    }
+
+    template <typename T>
+    T read() {
+      check(sizeof(T));
+      T value;
+      memcpy(&value, m_p, sizeof(T));
+      m_p += sizeof(T);
+      return value;
+    }
+
+    const char *readBytes(size_t length) {
+      check(length);
+      auto bytes = reinterpret_cast<const char *>(m_p);
+      m_p += length;
+      return bytes;
+    }
+
+  private:
+    void check(size_t size) const {
+      if (static_cast<size_t>(m_end - m_p) < size) {
+        throw std::invalid_argument("Invalid JSON tape");
+      }
+    }
+
+    const uint8_t *m_p;
+    const uint8_t * const m_end;
+  };
+}
+
+// static
+std::vector<uint8_t> JsonTape::parse(const char *json, size_t length) {
+  return Parser(json, length).parse();
+}
+
+// static
+std::vector<uint8_t> JsonTape::parse(ReadFunction read) {
+  return Parser(std::move(read)).parse();
+}
+
+#if defined(DUKTAPE)
+
+namespace {
+  struct Key {
+    const char *data;
+    size_t length;
+  };
+
+  void pushValue(duk_context *ctx, TapeReader &reader, std::vector<Key> &keys) {
+    switch (reader.readTag()) {
+      case 'n':
+        duk_push_null(ctx);
+        break;
+      case 't':
+        duk_push_true(ctx);
+        break;
+      case 'f':
+        duk_push_false(ctx);
+        break;
+      case 'i':
+        duk_push_int(ctx, reader.read<int32_t>());
+        break;
+      case 'd':
+        duk_push_number(ctx, reader.read<double>());
+        break;
+      case 's': {
+        const uint32_t length = reader.readLeb128();
+        duk_push_lstring(ctx, reader.readBytes(length), length);
+        break;
+      }
+      case '[': {
+        const auto count = reader.read<uint32_t>();
+        duk_require_stack(ctx, 2);
+        duk_push_array(ctx);
+        for (uint32_t i = 0; i < count; ++i) {
+          pushValue(ctx, reader, keys);
+          duk_put_prop_index(ctx, -2, i);
+        }
+        break;
+      }
+      case '{': {
+        const auto count = reader.read<uint32_t>();
+        duk_require_stack(ctx, 3);
+        duk_push_object(ctx);
+        for (uint32_t i = 0; i < count; ++i) {
+          Key key {};
+          const uint8_t keyTag = reader.readTag();
+          if (keyTag == 'K') {
+            key.length = reader.readLeb128();
+            key.data = reader.readBytes(key.length);
+            keys.push_back(key);
+          } else if (keyTag == 'k') {
+            const uint32_t index = reader.readLeb128();
+            if (index >= keys.size()) {
+              throw std::invalid_argument("Invalid JSON tape");
+            }
+            key = keys[index];
+          } else {
+            throw std::invalid_argument("Invalid JSON tape");
+          }
+
+          // Defined (and not put) so that e.g. "__proto__" is an own property, as with JSON.parse()
+          duk_push_lstring(ctx, key.data, key.length);
+          pushValue(ctx, reader, keys);
+          duk_def_prop(ctx, -3, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WEC);
+        }
+        break;
+      }
+      default:
+        throw std::invalid_argument("Invalid JSON tape");
+    }
+  }
+}
+
+// static
+void JsonTape::push(duk_context *ctx, const uint8_t *tape, size_t size) {
+  TapeReader reader(tape, size);
+  std::vector<Key> keys;
+  const duk_idx_t top = duk_get_top(ctx);
+  try {
+    pushValue(ctx, reader, keys);
+  } catch (...) {
+    duk_set_top(ctx, top);
+    throw;
+  }
+}
+
+#elif defined(QUICKJS)
+
+namespace {
+  class QuickJsMaterializer {
+  public:
+    QuickJsMaterializer(JSContext *ctx, const uint8_t *tape, size_t size)
+     : m_ctx(ctx)
+     , m_reader(tape, size) {
+    }
+
+    ~QuickJsMaterializer() {
+      // Values of the unfinished objects (invalid tape)
+      for (JSValue value : m_values) {
+        JS_FreeValue(m_ctx, value);
+      }
+      for (auto &it : m_templates) {
+        JS_FreeValue(m_ctx, it.second);
+      }
+      for (JSAtom atom : m_atoms) {
+        JS_FreeAtom(m_ctx, atom);
+      }
+    }
+
+    JSValue readValue() {
+      switch (m_reader.readTag()) {
+        case 'n':
+          return JS_NULL;
+        case 't':
+          return JS_TRUE;
+        case 'f':
+          return JS_FALSE;
+        case 'i':
+          return JS_NewInt32(m_ctx, m_reader.read<int32_t>());
+        case 'd':
+          return JS_NewFloat64(m_ctx, m_reader.read<double>());
+        case 's': {
+          const uint32_t length = m_reader.readLeb128();
+          return JS_NewStringLen(m_ctx, m_reader.readBytes(length), length);
+        }
+        case '[': {
+          const auto count = m_reader.read<uint32_t>();
+          JSValue arrayValue = JS_NewArray(m_ctx);
+          if (JS_IsException(arrayValue)) {
+            return arrayValue;
+          }
+          try {
+            for (uint32_t i = 0; i < count; ++i) {
+              JSValue value = readValue();
+              if (JS_IsException(value) || JS_DefinePropertyValueUint32(m_ctx, arrayValue, i, value, JS_PROP_C_W_E) < 0) {
+                JS_FreeValue(m_ctx, arrayValue);
+                return JS_EXCEPTION;
+              }
+            }
+          } catch (...) {
+            // Invalid tape: the array (and its elements) is not referenced anywhere else
+            JS_FreeValue(m_ctx, arrayValue);
+            throw;
+          }
+          return arrayValue;
+        }
+        case '{': {
+          // The keys and values are collected first (nested objects use the stacks above "base")
+          const auto count = m_reader.read<uint32_t>();
+          const size_t base = m_values.size();
+          for (uint32_t i = 0; i < count; ++i) {
+            JSAtom atom = readKey();
+            JSValue value = atom == JS_ATOM_NULL ? JS_EXCEPTION : readValue();
+            if (JS_IsException(value)) {
+              popValues(base);
+              return JS_EXCEPTION;
+            }
+            m_keys.push_back(atom);
+            m_values.push_back(value);
+          }
+          return newObject(base);
+        }
+        default:
+          throw std::invalid_argument("Invalid JSON tape");
+      }
+    }
+
+  private:
+    // Create the object with the keys and values above "base" (and pop them).
+    //
+    // Objects with the same keys in the same order (e.g. records of a list) share a template: the
+    // first one is created property by property and the next ones directly get its shape, without
+    // any shape transition or property lookup.
+    JSValue newObject(size_t base) {
+      const size_t count = m_values.size() - base;
+      const JSAtom *keys = m_keys.data() + base;
+      JSValue *values = m_values.data() + base;
+
+      m_templateKey.assign(reinterpret_cast<const char *>(keys), count * sizeof(JSAtom));
+      auto it = m_templates.find(m_templateKey);
+      if (it != m_templates.end()) {
+        // The values are moved into the new object (also on failure)
+        JSValue objectValue = JS_NewObjectFromTemplate(m_ctx, it->second, values);
+        m_keys.resize(base);
+        m_values.resize(base);
+        return objectValue;
+      }
+
+      JSValue objectValue = JS_NewObject(m_ctx);
+      if (JS_IsException(objectValue)) {
+        popValues(base);
+        return objectValue;
+      }
+
+      for (size_t i = 0; i < count; ++i) {
+        // JS_DefinePropertyValue() always frees the value
+        JSValue value = values[i];
+        values[i] = JS_UNDEFINED;
+        if (JS_DefinePropertyValue(m_ctx, objectValue, keys[i], value, JS_PROP_C_W_E) < 0) {
+          popValues(base);
+          JS_FreeValue(m_ctx, objectValue);
+          return JS_EXCEPTION;
+        }
+      }
+      m_keys.resize(base);
+      m_values.resize(base);
+
+      // Objects with duplicate keys (less properties than keys) cannot be used as template
+      if (count > 0 && m_templates.size() < MAX_TEMPLATES
+          && JS_GetObjectTemplateSize(m_ctx, objectValue) == static_cast<int>(count)) {
+        m_templates.emplace(m_templateKey, JS_DupValue(m_ctx, objectValue));
+      }
+      return objectValue;
+    }
+
+    void popValues(size_t base) {
+      for (size_t i = base; i < m_values.size(); ++i) {
+        JS_FreeValue(m_ctx, m_values[i]);
+      }
+      m_keys.resize(base);
+      m_values.resize(base);
+    }
+
+    // Each key is only converted once into an atom
+    JSAtom readKey() {
+      const uint8_t tag = m_reader.readTag();
+      if (tag == 'K') {
+        const uint32_t length = m_reader.readLeb128();
+        JSAtom atom = JS_NewAtomLen(m_ctx, m_reader.readBytes(length), length);
+        if (atom != JS_ATOM_NULL) {
+          m_atoms.push_back(atom);
+        }
+        return atom;
+      }
+
+      if (tag == 'k') {
+        const uint32_t index = m_reader.readLeb128();
+        if (index < m_atoms.size()) {
+          return m_atoms[index];
+        }
+      }
+
+      throw std::invalid_argument("Invalid JSON tape");
+    }
+
+    // Maximum number of different key sets with a template (e.g. maps with dynamic keys)
+    static const size_t MAX_TEMPLATES = 256;
+
+    JSContext *m_ctx;
+    TapeReader m_reader;
+    std::vector<JSAtom> m_atoms;
+    std::vector<JSAtom> m_keys;  // keys of the objects being created
+    std::vector<JSValue> m_values;  // values of the objects being created
+    std::unordered_map<std::string, JSValue> m_templates;  // by key atoms
+    std::string m_templateKey;  // reused for lookups
+  };
+}
+
+// static
+JSValue JsonTape::toJsValue(JSContext *ctx, const uint8_t *tape, size_t size) {
+  return QuickJsMaterializer(ctx, tape, size).readValue();
+}
+
+#endif
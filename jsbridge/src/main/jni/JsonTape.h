@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSONTAPE_H
+#define _JSBRIDGE_JSONTAPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
+# include "quickjs/quickjs.h"
+#endif
+
+// Compact, pre-parsed representation of a JSON document which can be built in any thread (without
+// JS context) and quickly turned into JS values in the JS thread:
+// - strings are unescaped (and encoded as expected by the JS engine)
+// - numbers are converted (int32 or double)
+// - the element count of arrays and objects is known in advance
+// - object keys are only stored once (and converted once into JS property keys)
+//
+// Format (counts are 32-bit little-endian, lengths and indexes are LEB128):
+// 'n' | 't' | 'f'                  null, true, false
+// 'i' <int32> | 'd' <double>       number
+// 's' <length> <bytes>             string
+// '[' <count> <value>*             array
+// '{' <count> (<key> <value>)*     object with key = 'K' <length> <bytes> (new key) | 'k' <index>
+class JsonTape {
+public:
+  JsonTape() = delete;
+  ~JsonTape() = delete;
+
+  // Parse the given UTF-8 JSON text. Throws std::invalid_argument if the JSON text is invalid.
+  static std::vector<uint8_t> parse(const char *json, size_t length);
+
+  // Reads up to "capacity" bytes of the JSON text into the given buffer and returns the number of
+  // read bytes (0 at the end of data)
+  typedef std::function<size_t(char *buffer, size_t capacity)> ReadFunction;
+
+  // Same as above but the UTF-8 JSON text is read chunk by chunk, so that the whole text never
+  // needs to be kept in memory. Exceptions thrown by the read function are propagated.
+  static std::vector<uint8_t> parse(ReadFunction);
+
+#if defined(DUKTAPE)
+  // Push the JS value of the given tape
+  static void push(duk_context *, const uint8_t *tape, size_t size);
+#elif defined(QUICKJS)
+  // Create the JS value of the given tape. Returns JS_EXCEPTION on failure (e.g. out of memory).
+  static JSValue toJsValue(JSContext *, const uint8_t *tape, size_t size);
+#endif
+};
+
+#endif
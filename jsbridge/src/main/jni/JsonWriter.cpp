@@ -0,0 +1,772 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsonWriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(QUICKJS)
+# include <unordered_map>
+#endif
+
+namespace {
+  // Same as JsonTape
+  const int MAX_DEPTH = 512;
+
+  const char HEX_DIGITS[] = "0123456789abcdef";
+}
+
+JsonWriter::JsonWriter(uint8_t *buffer, size_t capacity, FlushFunction flush)
+ : m_buffer(buffer)
+ , m_capacity(capacity)
+ , m_flush(std::move(flush)) {
+}
+
+void JsonWriter::put(const char *s, size_t length) {
+  while (length > 0) {
+    if (m_size == m_capacity) {
+      flushBuffer(false);
+    }
+    const size_t chunkLength = std::min(length, m_capacity - m_size);
+    memcpy(m_buffer + m_size, s, chunkLength);
+    m_size += chunkLength;
+    s += chunkLength;
+    length -= chunkLength;
+  }
+}
+
+void JsonWriter::putString(const char *s, size_t length) {
+  put('"');
+
+  const auto *p = reinterpret_cast<const uint8_t *>(s);
+  const uint8_t *end = p + length;
+  while (p != end) {
+    // Copy runs of characters which do not need to be escaped
+    const uint8_t *runStart = p;
+    while (p != end && *p >= 0x20 && *p != '"' && *p != '\\' && *p != 0xED) {
+      ++p;
+    }
+    put(reinterpret_cast<const char *>(runStart), p - runStart);
+    if (p == end) {
+      break;
+    }
+
+    const uint8_t c = *p;
+    if (c == 0xED && end - p >= 3 && p[1] >= 0xA0) {
+      // UTF-16 surrogate encoded as a 3-byte sequence (CESU-8 or lone surrogate)
+      const unsigned unit = 0xD000u | ((p[1] & 0x3Fu) << 6) | (p[2] & 0x3Fu);
+      if (unit < 0xDC00 && end - p >= 6 && p[3] == 0xED && p[4] >= 0xB0) {
+        // Surrogate pair: convert into a 4-byte UTF-8 sequence
+        const unsigned low = 0xD000u | ((p[4] & 0x3Fu) << 6) | (p[5] & 0x3Fu);
+        const unsigned cp = 0x10000u + ((unit - 0xD800u) << 10) + (low - 0xDC00u);
+        const char utf8[] = {
+            static_cast<char>(0xF0 | (cp >> 18)),
+            static_cast<char>(0x80 | ((cp >> 12) & 0x3F)),
+            static_cast<char>(0x80 | ((cp >> 6) & 0x3F)),
+            static_cast<char>(0x80 | (cp & 0x3F))
+        };
+        put(utf8, 4);
+        p += 6;
+      } else {
+        // Lone surrogate: escaped like JSON.stringify() does
+        const char escaped[] = { '\\', 'u', 'd', HEX_DIGITS[(unit >> 8) & 0xF], HEX_DIGITS[(unit >> 4) & 0xF], HEX_DIGITS[unit & 0xF] };
+        put(escaped, sizeof(escaped));
+        p += 3;
+      }
+      continue;
+    }
+
+    switch (c) {
+      case '"': put("\\\"", 2); break;
+      case '\\': put("\\\\", 2); break;
+      case '\b': put("\\b", 2); break;
+      case '\f': put("\\f", 2); break;
+      case '\n': put("\\n", 2); break;
+      case '\r': put("\\r", 2); break;
+      case '\t': put("\\t", 2); break;
+      case 0xED: put(reinterpret_cast<const char *>(p), 1); break;  // other characters U+D000..U+D7FF
+      default: {
+        const char escaped[] = { '\\', 'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0xF] };
+        put(escaped, sizeof(escaped));
+        break;
+      }
+    }
+    ++p;
+  }
+
+  put('"');
+}
+
+// Same as Number.prototype.toString(), "null" for NaN and Infinity
+void JsonWriter::putNumber(double d) {
+  char s[32];
+
+  if (!std::isfinite(d)) {
+    put("null", 4);
+    return;
+  }
+
+  // Integers (including -0)
+  if (std::fabs(d) < 9007199254740992.0 && d == std::floor(d)) {
+    put(s, snprintf(s, sizeof(s), "%lld", static_cast<long long>(d)));
+    return;
+  }
+
+  // Shortest representation which can be converted back to the same value
+  char e[32];
+  for (int precision = 1; precision <= 17; ++precision) {
+    snprintf(e, sizeof(e), "%.*e", precision - 1, d);
+    if (strtod(e, nullptr) == d) {
+      break;
+    }
+  }
+
+  // e = [-]d[.ddd]e(+|-)nn
+  const char *p = e;
+  const bool negative = *p == '-';
+  if (negative) {
+    ++p;
+  }
+  char digits[20];
+  int k = 0;
+  for (; *p != 'e'; ++p) {
+    if (*p != '.') {
+      digits[k++] = *p;
+    }
+  }
+  while (k > 1 && digits[k - 1] == '0') {
+    --k;
+  }
+  const int n = atoi(p + 1) + 1;  // value = 0.digits * 10^n
+
+  std::string str;
+  if (negative) {
+    str += '-';
+  }
+  if (k <= n && n <= 21) {
+    str.append(digits, k);
+    str.append(n - k, '0');
+  } else if (0 < n && n <= 21) {
+    str.append(digits, n);
+    str += '.';
+    str.append(digits + n, k - n);
+  } else if (-6 < n && n <= 0) {
+    str += "0.";
+    str.append(-n, '0');
+    str.append(digits, k);
+  } else {
+    str += digits[0];
+    if (k > 1) {
+      str += '.';
+      str.append(digits + 1, k - 1);
+    }
+    str += n - 1 >= 0 ? "e+" : "e-";
+    str += std::to_string(std::abs(n - 1));
+  }
+  put(str.data(), str.size());
+}
+
+bool JsonWriter::finish() {
+  flushBuffer(true);
+  return !m_flushFailed;
+}
+
+void JsonWriter::flushBuffer(bool all) {
+  if (m_flushFailed) {
+    // Discard
+    m_size = 0;
+    return;
+  }
+
+  size_t length = m_size;
+  if (!all) {
+    // Keep an incomplete UTF-8 sequence at the end of the buffer for the next chunk
+    size_t i = m_size;
+    size_t continuationCount = 0;
+    while (continuationCount < 3 && i > 0 && (m_buffer[i - 1] & 0xC0) == 0x80) {
+      --i;
+      ++continuationCount;
+    }
+    if (i > 0) {
+      const uint8_t lead = m_buffer[i - 1];
+      const size_t sequenceLength = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+      if (sequenceLength > continuationCount + 1) {
+        length = i - 1;
+      }
+    }
+  }
+
+  if (length > 0 && !m_flush(length)) {
+    m_flushFailed = true;
+    m_size = 0;
+    return;
+  }
+
+  memmove(m_buffer, m_buffer + length, m_size - length);
+  m_size -= length;
+}
+
+#if defined(DUKTAPE)
+
+namespace {
+  class DuktapeSerializer {
+  public:
+    DuktapeSerializer(duk_context *ctx, JsonWriter &writer)
+     : m_ctx(ctx)
+     , m_writer(writer) {
+
+      // Prototypes of boxed primitives (kept referenced below the value until the end)
+      duk_eval_string(m_ctx, "[Number.prototype, String.prototype, Boolean.prototype]");
+      for (duk_uarridx_t i = 0; i < 3; ++i) {
+        duk_get_prop_index(m_ctx, -1, i);
+        m_boxedPrimitivePrototypes[i] = duk_get_heapptr(m_ctx, -1);
+        duk_pop(m_ctx);
+      }
+      duk_insert(m_ctx, -2);
+    }
+
+    // [... prototypes value] -> [...]
+    void writeRoot() {
+      duk_push_string(m_ctx, "");
+      duk_insert(m_ctx, -2);
+      if (prepare(duk_get_top_index(m_ctx) - 1, 0)) {
+        writePrepared(0);
+      }
+      duk_pop_2(m_ctx);  // key, prototypes
+    }
+
+  private:
+    // [... value] -> [... value] after toJSON() has been applied
+    // Return false (and pop the value) if the value is not serialized (undefined, function, symbol)
+    // keyIdx: index of the key or DUK_INVALID_INDEX for the given array index
+    bool prepare(duk_idx_t keyIdx, duk_uarridx_t arrayIndex) {
+      if (duk_is_object(m_ctx, -1)) {
+        duk_get_prop_string(m_ctx, -1, "toJSON");
+        if (duk_is_function(m_ctx, -1)) {
+          duk_dup(m_ctx, -2);
+          if (keyIdx == DUK_INVALID_INDEX) {
+            duk_push_uint(m_ctx, arrayIndex);
+            duk_to_string(m_ctx, -1);
+          } else {
+            duk_dup(m_ctx, keyIdx);
+          }
+          duk_call_method(m_ctx, 1);
+          duk_remove(m_ctx, -2);  // value
+        } else {
+          duk_pop(m_ctx);  // toJSON
+        }
+      }
+
+      if (duk_is_undefined(m_ctx, -1) || duk_is_function(m_ctx, -1) || duk_is_symbol(m_ctx, -1)) {
+        duk_pop(m_ctx);
+        return false;
+      }
+      return true;
+    }
+
+    // [... value] -> [...]
+    void writePrepared(int depth) {
+      switch (duk_get_type(m_ctx, -1)) {
+        case DUK_TYPE_NULL:
+          m_writer.put("null", 4);
+          break;
+        case DUK_TYPE_BOOLEAN:
+          if (duk_get_boolean(m_ctx, -1)) {
+            m_writer.put("true", 4);
+          } else {
+            m_writer.put("false", 5);
+          }
+          break;
+        case DUK_TYPE_NUMBER:
+          m_writer.putNumber(duk_get_number(m_ctx, -1));
+          break;
+        case DUK_TYPE_STRING: {
+          duk_size_t length;
+          const char *s = duk_get_lstring(m_ctx, -1, &length);
+          m_writer.putString(s, length);
+          break;
+        }
+        case DUK_TYPE_OBJECT:
+          if (!isBoxedPrimitive()) {
+            writeObject(depth);
+            break;
+          }
+          // fall through
+        default:
+          // Boxed primitives, buffers, pointers
+          writeJsonEncoded();
+          break;
+      }
+
+      duk_pop(m_ctx);
+      checkWriter();
+    }
+
+    // [... object] -> [... object]
+    void writeObject(int depth) {
+      if (depth >= MAX_DEPTH) {
+        duk_error(m_ctx, DUK_ERR_RANGE_ERROR, "JSON value is too deeply nested");
+      }
+
+      duk_require_stack(m_ctx, 8);
+      const duk_idx_t objectIdx = duk_get_top_index(m_ctx);
+
+      void *heapPtr = duk_get_heapptr(m_ctx, objectIdx);
+      if (std::find(m_stack.begin(), m_stack.end(), heapPtr) != m_stack.end()) {
+        duk_error(m_ctx, DUK_ERR_TYPE_ERROR, "circular reference");
+      }
+      m_stack.push_back(heapPtr);
+
+      if (duk_is_array(m_ctx, objectIdx)) {
+        m_writer.put('[');
+        const duk_size_t length = duk_get_length(m_ctx, objectIdx);
+        for (duk_uarridx_t i = 0; i < length; ++i) {
+          checkWriter();
+          if (i > 0) {
+            m_writer.put(',');
+          }
+          duk_get_prop_index(m_ctx, objectIdx, i);
+          if (prepare(DUK_INVALID_INDEX, i)) {
+            writePrepared(depth + 1);
+          } else {
+            m_writer.put("null", 4);
+          }
+        }
+        m_writer.put(']');
+      } else {
+        // Error instances: all own properties except "stack" (see custom_stringify)
+        const bool isError = duk_is_error(m_ctx, objectIdx);
+
+        m_writer.put('{');
+        bool hasContent = false;
+        duk_enum(m_ctx, objectIdx, DUK_ENUM_OWN_PROPERTIES_ONLY | (isError ? DUK_ENUM_INCLUDE_NONENUMERABLE : 0));
+        while (duk_next(m_ctx, -1, 0)) {
+          checkWriter();
+          const duk_idx_t keyIdx = duk_get_top_index(m_ctx);
+          if (isError && strcmp(duk_get_string(m_ctx, keyIdx), "stack") == 0) {
+            duk_pop(m_ctx);  // key
+            continue;
+          }
+          duk_dup(m_ctx, keyIdx);
+          duk_get_prop(m_ctx, objectIdx);
+          if (prepare(keyIdx, 0)) {
+            if (hasContent) {
+              m_writer.put(',');
+            }
+            duk_size_t keyLength;
+            const char *key = duk_get_lstring(m_ctx, keyIdx, &keyLength);
+            m_writer.putString(key, keyLength);
+            m_writer.put(':');
+            writePrepared(depth + 1);
+            hasContent = true;
+          }
+          duk_pop(m_ctx);  // key
+        }
+        duk_pop(m_ctx);  // enum
+        m_writer.put('}');
+      }
+
+      m_stack.pop_back();
+    }
+
+    bool isBoxedPrimitive() {
+      duk_get_prototype(m_ctx, -1);
+      if (!duk_is_object(m_ctx, -1)) {
+        duk_pop(m_ctx);
+        return false;
+      }
+      void *prototype = duk_get_heapptr(m_ctx, -1);
+      duk_pop(m_ctx);
+      return std::find(std::begin(m_boxedPrimitivePrototypes), std::end(m_boxedPrimitivePrototypes), prototype) != std::end(m_boxedPrimitivePrototypes);
+    }
+
+    // [... value] -> [... value]
+    void writeJsonEncoded() {
+      duk_dup(m_ctx, -1);
+      duk_size_t length;
+      const char *s = duk_json_encode(m_ctx, -1) ? duk_get_lstring(m_ctx, -1, &length) : nullptr;
+      if (s == nullptr) {
+        m_writer.put("null", 4);
+      } else {
+        m_writer.put(s, length);
+      }
+      duk_pop(m_ctx);
+    }
+
+    void checkWriter() {
+      if (m_writer.hasFlushFailed()) {
+        duk_error(m_ctx, DUK_ERR_ERROR, "Could not write JSON output");
+      }
+    }
+
+    duk_context *m_ctx;
+    JsonWriter &m_writer;
+    void *m_boxedPrimitivePrototypes[3] = {};
+    std::vector<void *> m_stack;
+  };
+}
+
+void JsonWriter::write(duk_context *ctx, duk_idx_t idx) {
+  duk_dup(ctx, idx);
+  DuktapeSerializer(ctx, *this).writeRoot();
+
+  if (!finish()) {
+    duk_error(ctx, DUK_ERR_ERROR, "Could not write JSON output");
+  }
+}
+
+#elif defined(QUICKJS)
+
+namespace {
+  // Property key given to toJSON()
+  struct Key {
+    JSAtom atom;  // JS_ATOM_NULL: array index (or "" if the index is negative)
+    int64_t index;
+  };
+
+  class QuickJsSerializer {
+  public:
+    QuickJsSerializer(JSContext *ctx, JsonWriter &writer)
+     : m_ctx(ctx)
+     , m_writer(writer)
+     , m_toJsonAtom(JS_NewAtom(ctx, "toJSON"))
+     , m_stackAtom(JS_NewAtom(ctx, "stack")) {
+
+      // Prototypes of boxed primitives
+      JSValue globalObj = JS_GetGlobalObject(m_ctx);
+      const char *constructorNames[] = { "Number", "String", "Boolean" };
+      for (int i = 0; i < 3; ++i) {
+        JSValue constructor = JS_GetPropertyStr(m_ctx, globalObj, constructorNames[i]);
+        m_boxedPrimitivePrototypes[i] = JS_GetPropertyStr(m_ctx, constructor, "prototype");
+        JS_FreeValue(m_ctx, constructor);
+      }
+      JS_FreeValue(m_ctx, globalObj);
+    }
+
+    ~QuickJsSerializer() {
+      for (JSValue prototype : m_boxedPrimitivePrototypes) {
+        JS_FreeValue(m_ctx, prototype);
+      }
+      for (const auto &it : m_keys) {
+        JS_FreeAtom(m_ctx, it.first);
+      }
+      JS_FreeAtom(m_ctx, m_toJsonAtom);
+      JS_FreeAtom(m_ctx, m_stackAtom);
+    }
+
+    bool writeRoot(JSValueConst value) {
+      JSValue prepared = prepare(JS_DupValue(m_ctx, value), Key { JS_ATOM_NULL, -1 });
+      if (JS_IsException(prepared)) {
+        return false;
+      }
+      if (JS_IsUndefined(prepared)) {
+        return true;
+      }
+      return writePrepared(prepared, 0);
+    }
+
+  private:
+    // Apply toJSON() on the given value (which is freed)
+    // Return JS_UNDEFINED if the value is not serialized (undefined, function, symbol)
+    JSValue prepare(JSValue value, const Key &key) {
+      if (JS_IsObject(value)) {
+        JSValue toJsonValue = JS_GetProperty(m_ctx, value, m_toJsonAtom);
+        if (JS_IsException(toJsonValue)) {
+          JS_FreeValue(m_ctx, value);
+          return JS_EXCEPTION;
+        }
+
+        if (JS_IsFunction(m_ctx, toJsonValue)) {
+          JSValue keyValue = key.atom != JS_ATOM_NULL
+              ? JS_AtomToString(m_ctx, key.atom)
+              : key.index >= 0 ? JS_NewString(m_ctx, std::to_string(key.index).c_str()) : JS_NewString(m_ctx, "");
+          JSValue ret = JS_IsException(keyValue) ? JS_EXCEPTION : JS_Call(m_ctx, toJsonValue, value, 1, &keyValue);
+          JS_FreeValue(m_ctx, keyValue);
+          JS_FreeValue(m_ctx, value);
+          value = ret;
+        }
+        JS_FreeValue(m_ctx, toJsonValue);
+      }
+
+      switch (JS_VALUE_GET_NORM_TAG(value)) {
+        case JS_TAG_OBJECT:
+          if (JS_IsFunction(m_ctx, value)) {
+            break;
+          }
+          return value;
+        case JS_TAG_STRING:
+        case JS_TAG_INT:
+        case JS_TAG_FLOAT64:
+        case JS_TAG_BOOL:
+        case JS_TAG_NULL:
+        case JS_TAG_EXCEPTION:
+          return value;
+        case JS_TAG_BIG_INT:
+          // Same as JSON.stringify()
+          JS_FreeValue(m_ctx, value);
+          JS_ThrowTypeError(m_ctx, "bigint are forbidden in JSON.stringify");
+          return JS_EXCEPTION;
+        default:
+          break;
+      }
+
+      JS_FreeValue(m_ctx, value);
+      return JS_UNDEFINED;
+    }
+
+    // Write the given value (which is freed)
+    bool writePrepared(JSValue value, int depth) {
+      bool ret = true;
+
+      switch (JS_VALUE_GET_NORM_TAG(value)) {
+        case JS_TAG_NULL:
+          m_writer.put("null", 4);
+          break;
+        case JS_TAG_BOOL:
+          if (JS_VALUE_GET_BOOL(value)) {
+            m_writer.put("true", 4);
+          } else {
+            m_writer.put("false", 5);
+          }
+          break;
+        case JS_TAG_INT:
+          m_writer.putNumber(JS_VALUE_GET_INT(value));
+          break;
+        case JS_TAG_FLOAT64:
+          m_writer.putNumber(JS_VALUE_GET_FLOAT64(value));
+          break;
+        case JS_TAG_STRING: {
+          size_t length;
+          const char *s = JS_ToCStringLen(m_ctx, &length, value);
+          if (s == nullptr) {
+            ret = false;
+            break;
+          }
+          m_writer.putString(s, length);
+          JS_FreeCString(m_ctx, s);
+          break;
+        }
+        case JS_TAG_OBJECT:
+          ret = isBoxedPrimitive(value) ? writeJsonStringified(value) : writeObject(value, depth);
+          break;
+        default:
+          m_writer.put("null", 4);
+          break;
+      }
+
+      JS_FreeValue(m_ctx, value);
+      return ret && !m_writer.hasFlushFailed();
+    }
+
+    bool writeObject(JSValueConst objectValue, int depth) {
+      if (depth >= MAX_DEPTH) {
+        JS_ThrowRangeError(m_ctx, "JSON value is too deeply nested");
+        return false;
+      }
+
+      void *ptr = JS_VALUE_GET_PTR(objectValue);
+      if (std::find(m_stack.begin(), m_stack.end(), ptr) != m_stack.end()) {
+        JS_ThrowTypeError(m_ctx, "circular reference");
+        return false;
+      }
+      m_stack.push_back(ptr);
+
+      const int isArray = JS_IsArray(m_ctx, objectValue);
+      const bool ret = isArray < 0 ? false
+          : isArray ? writeArrayElements(objectValue, depth)
+          : writeObjectProperties(objectValue, depth);
+
+      m_stack.pop_back();
+      return ret;
+    }
+
+    bool writeArrayElements(JSValueConst arrayValue, int depth) {
+      int64_t length;
+      JSValue lengthValue = JS_GetPropertyStr(m_ctx, arrayValue, "length");
+      const bool hasLength = !JS_IsException(lengthValue) && JS_ToInt64(m_ctx, &length, lengthValue) == 0;
+      JS_FreeValue(m_ctx, lengthValue);
+      if (!hasLength) {
+        return false;
+      }
+
+      m_writer.put('[');
+      for (int64_t i = 0; i < length; ++i) {
+        if (m_writer.hasFlushFailed()) {
+          return false;
+        }
+        if (i > 0) {
+          m_writer.put(',');
+        }
+
+        JSValue value = prepare(JS_GetPropertyUint32(m_ctx, arrayValue, static_cast<uint32_t>(i)), Key { JS_ATOM_NULL, i });
+        if (JS_IsException(value)) {
+          return false;
+        }
+        if (JS_IsUndefined(value)) {
+          m_writer.put("null", 4);
+        } else if (!writePrepared(value, depth + 1)) {
+          return false;
+        }
+      }
+      m_writer.put(']');
+      return true;
+    }
+
+    bool writeObjectProperties(JSValueConst objectValue, int depth) {
+      // Error instances: all own properties except "stack" (see custom_stringify)
+      const bool isError = JS_IsError(m_ctx, objectValue);
+      const int flags = isError ? JS_GPN_STRING_MASK : JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY;
+
+      JSPropertyEnum *properties;
+      uint32_t propertyCount;
+      if (JS_GetOwnPropertyNames(m_ctx, &properties, &propertyCount, objectValue, flags) < 0) {
+        return false;
+      }
+
+      bool ret = true;
+      bool hasContent = false;
+      m_writer.put('{');
+      for (uint32_t i = 0; i < propertyCount && !m_writer.hasFlushFailed(); ++i) {
+        const JSAtom atom = properties[i].atom;
+        if (isError && atom == m_stackAtom) {
+          continue;
+        }
+        JSValue value = prepare(JS_GetProperty(m_ctx, objectValue, atom), Key { atom, 0 });
+        if (JS_IsException(value)) {
+          ret = false;
+          break;
+        }
+        if (JS_IsUndefined(value)) {
+          continue;
+        }
+
+        if (hasContent) {
+          m_writer.put(',');
+        }
+        const std::string *quotedKey = getQuotedKey(atom);
+        if (quotedKey == nullptr) {
+          JS_FreeValue(m_ctx, value);
+          ret = false;
+          break;
+        }
+        m_writer.put(quotedKey->data(), quotedKey->size());
+        m_writer.put(':');
+        if (!writePrepared(value, depth + 1)) {
+          ret = false;
+          break;
+        }
+        hasContent = true;
+      }
+      m_writer.put('}');
+      ret = ret && !m_writer.hasFlushFailed();
+
+      for (uint32_t i = 0; i < propertyCount; ++i) {
+        JS_FreeAtom(m_ctx, properties[i].atom);
+      }
+      js_free(m_ctx, properties);
+      return ret;
+    }
+
+    // Keys are only escaped once (e.g. for arrays of objects with the same shape)
+    const std::string *getQuotedKey(JSAtom atom) {
+      auto it = m_keys.find(atom);
+      if (it != m_keys.end()) {
+        return &it->second;
+      }
+
+      size_t length;
+      JSValue keyValue = JS_AtomToString(m_ctx, atom);
+      const char *s = JS_IsException(keyValue) ? nullptr : JS_ToCStringLen(m_ctx, &length, keyValue);
+      JS_FreeValue(m_ctx, keyValue);
+      if (s == nullptr) {
+        return nullptr;
+      }
+
+      // Escape the key via a temporary writer
+      std::string quotedKey;
+      uint8_t buffer[256];
+      JsonWriter keyWriter(buffer, sizeof(buffer), [&](size_t length) {
+        quotedKey.append(reinterpret_cast<const char *>(buffer), length);
+        return true;
+      });
+      keyWriter.putString(s, length);
+      keyWriter.finish();
+      JS_FreeCString(m_ctx, s);
+
+      return &m_keys.emplace(JS_DupAtom(m_ctx, atom), std::move(quotedKey)).first->second;
+    }
+
+    bool isBoxedPrimitive(JSValueConst objectValue) {
+      JSValue prototype = JS_GetPrototype(m_ctx, objectValue);
+      if (JS_IsException(prototype)) {
+        JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+        return false;
+      }
+
+      bool ret = false;
+      if (JS_IsObject(prototype)) {
+        for (JSValue boxedPrimitivePrototype : m_boxedPrimitivePrototypes) {
+          ret = ret || JS_VALUE_GET_PTR(boxedPrimitivePrototype) == JS_VALUE_GET_PTR(prototype);
+        }
+      }
+      JS_FreeValue(m_ctx, prototype);
+      return ret;
+    }
+
+    bool writeJsonStringified(JSValueConst value) {
+      JSValue jsonValue = JS_JSONStringify(m_ctx, value, JS_UNDEFINED, JS_UNDEFINED);
+      if (JS_IsException(jsonValue)) {
+        return false;
+      }
+
+      size_t length;
+      const char *s = JS_IsString(jsonValue) ? JS_ToCStringLen(m_ctx, &length, jsonValue) : nullptr;
+      if (s != nullptr) {
+        m_writer.put(s, length);
+        JS_FreeCString(m_ctx, s);
+      } else {
+        m_writer.put("null", 4);
+      }
+      JS_FreeValue(m_ctx, jsonValue);
+      return true;
+    }
+
+    JSContext *m_ctx;
+    JsonWriter &m_writer;
+    const JSAtom m_toJsonAtom;
+    const JSAtom m_stackAtom;
+    JSValue m_boxedPrimitivePrototypes[3];
+    std::unordered_map<JSAtom, std::string> m_keys;
+    std::vector<void *> m_stack;
+  };
+}
+
+bool JsonWriter::write(JSContext *ctx, JSValueConst value) {
+  bool ret;
+  {
+    QuickJsSerializer serializer(ctx, *this);
+    ret = serializer.writeRoot(value);
+  }
+
+  return finish() && ret;
+}
+
+#endif
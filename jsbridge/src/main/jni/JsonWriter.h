@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSONWRITER_H
+#define _JSBRIDGE_JSONWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
+# include "quickjs/quickjs.h"
+#endif
+
+// Incremental JSON serialization of a JS value into a fixed-size buffer which is flushed whenever
+// it is full, so that the whole JSON string never needs to be built in memory.
+//
+// The output is the same as custom_stringify() (JSON.stringify() + Error instances serialized with
+// their own properties) and is valid UTF-8. Each flushed chunk only contains complete UTF-8
+// sequences.
+class JsonWriter {
+public:
+  // Called with the number of bytes written into the buffer, which can be reused afterwards.
+  // Returns false to abort the serialization (e.g. pending Java exception).
+  typedef std::function<bool(size_t length)> FlushFunction;
+
+  JsonWriter(uint8_t *buffer, size_t capacity, FlushFunction);
+  JsonWriter(const JsonWriter &) = delete;
+  JsonWriter &operator=(const JsonWriter &) = delete;
+
+#if defined(DUKTAPE)
+  // Serialize the value at the given index. Must be called via duk_safe_call(): JS errors are
+  // thrown as Duktape errors (also when the flush function fails).
+  void write(duk_context *, duk_idx_t);
+#elif defined(QUICKJS)
+  // Returns false when a JS exception is pending or when the flush function failed
+  bool write(JSContext *, JSValueConst);
+#endif
+
+  bool hasFlushFailed() const { return m_flushFailed; }
+
+  // Output (used by the JS engine specific serializers)
+  void put(char c) {
+    if (m_size == m_capacity) {
+      flushBuffer(false);
+    }
+    m_buffer[m_size++] = static_cast<uint8_t>(c);
+  }
+  void put(const char *s, size_t length);
+  // Quoted and escaped JSON string from the UTF-8 (or CESU-8) string of the JS engine
+  void putString(const char *s, size_t length);
+  void putNumber(double);
+
+  // Flush all the remaining data
+  bool finish();
+
+private:
+  void flushBuffer(bool all);
+
+  uint8_t * const m_buffer;
+  const size_t m_capacity;
+  const FlushFunction m_flush;
+  size_t m_size = 0;
+  bool m_flushFailed = false;
+};
+
+#endif
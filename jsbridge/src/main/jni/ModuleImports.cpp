@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ModuleImports.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+  enum class TokenType {
+    End, Identifier, String, Number, Punctuator, Literal  // Literal = template or regexp
+  };
+
+  struct Token {
+    TokenType type = TokenType::End;
+    std::string text;  // identifier name, string value or punctuator character
+  };
+
+  bool isIdentifierStart(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$' || c >= 0x80;
+  }
+
+  bool isIdentifierPart(unsigned char c) {
+    return isIdentifierStart(c) || (c >= '0' && c <= '9');
+  }
+
+  bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+  bool isIdentifier(const Token &token, const char *name) {
+    return token.type == TokenType::Identifier && token.text == name;
+  }
+
+  bool isPunctuator(const Token &token, char c) {
+    return token.type == TokenType::Punctuator && token.text[0] == c;
+  }
+
+  class Lexer {
+  public:
+    Lexer(const char *source, size_t length)
+     : m_p(source)
+     , m_end(source + length) {
+    }
+
+    Token next() {
+      m_last = read();
+      return m_last;
+    }
+
+  private:
+    Token read() {
+      skipSpacesAndComments();
+      if (m_p >= m_end) {
+        return {};
+      }
+
+      const char c = *m_p;
+
+      if (isIdentifierStart(c)) {
+        const char *start = m_p;
+        while (m_p < m_end && isIdentifierPart(*m_p)) ++m_p;
+        return { TokenType::Identifier, std::string(start, m_p) };
+      }
+
+      if (isDigit(c) || (c == '.' && m_p + 1 < m_end && isDigit(m_p[1]))) {
+        while (m_p < m_end && (isIdentifierPart(*m_p) || *m_p == '.')) ++m_p;
+        return { TokenType::Number, {} };
+      }
+
+      if (c == '"' || c == '\'') {
+        return { TokenType::String, readString(c) };
+      }
+
+      if (c == '`') {
+        skipTemplate();
+        return { TokenType::Literal, {} };
+      }
+
+      if (c == '/' && isRegExpAllowed()) {
+        skipRegExp();
+        return { TokenType::Literal, {} };
+      }
+
+      ++m_p;
+      return { TokenType::Punctuator, std::string(1, c) };
+    }
+
+    void skipSpacesAndComments() {
+      while (m_p < m_end) {
+        if (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r' || *m_p == '\f' || *m_p == '\v') {
+          ++m_p;
+        } else if (*m_p == '/' && m_p + 1 < m_end && m_p[1] == '/') {
+          while (m_p < m_end && *m_p != '\n') ++m_p;
+        } else if (*m_p == '/' && m_p + 1 < m_end && m_p[1] == '*') {
+          const char *commentEnd = std::search(m_p + 2, m_end, "*/", "*/" + 2);
+          m_p = commentEnd == m_end ? m_end : commentEnd + 2;
+        } else {
+          break;
+        }
+      }
+    }
+
+    // A slash starts a regexp unless it follows an operand (division)
+    bool isRegExpAllowed() const {
+      static const char *const keywords[] = {
+          "return", "typeof", "instanceof", "in", "of", "new", "delete", "void", "throw", "case",
+          "do", "else", "yield", "await"
+      };
+
+      switch (m_last.type) {
+        case TokenType::End:
+          return true;
+        case TokenType::Punctuator:
+          return !isPunctuator(m_last, ')') && !isPunctuator(m_last, ']') && !isPunctuator(m_last, '}');
+        case TokenType::Identifier:
+          return std::any_of(std::begin(keywords), std::end(keywords), [this](const char *keyword) {
+            return m_last.text == keyword;
+          });
+        default:
+          return false;
+      }
+    }
+
+    // Escape sequences are only unescaped for simple characters (e.g. \" or \\)
+    std::string readString(char quote) {
+      std::string value;
+      ++m_p;
+      while (m_p < m_end && *m_p != quote && *m_p != '\n') {
+        if (*m_p == '\\' && m_p + 1 < m_end) {
+          ++m_p;
+        }
+        value += *m_p++;
+      }
+      if (m_p < m_end && *m_p == quote) ++m_p;
+      return value;
+    }
+
+    void skipTemplate() {
+      ++m_p;
+      while (m_p < m_end && *m_p != '`') {
+        if (*m_p == '\\') {
+          m_p += 2;
+        } else if (*m_p == '$' && m_p + 1 < m_end && m_p[1] == '{') {
+          m_p += 2;
+          skipTemplateSubstitution();
+        } else {
+          ++m_p;
+        }
+      }
+      if (m_p < m_end) ++m_p;
+    }
+
+    // Tokenize the ${...} expression (which can contain nested templates) until its closing brace
+    void skipTemplateSubstitution() {
+      int depth = 1;
+      m_last = {};
+      while (depth > 0) {
+        Token token = next();
+        if (token.type == TokenType::End) {
+          break;
+        }
+        if (isPunctuator(token, '{')) {
+          ++depth;
+        } else if (isPunctuator(token, '}')) {
+          --depth;
+        }
+      }
+    }
+
+    void skipRegExp() {
+      ++m_p;
+      bool inClass = false;
+      while (m_p < m_end && *m_p != '\n') {
+        const char c = *m_p++;
+        if (c == '\\') {
+          ++m_p;
+        } else if (c == '[') {
+          inClass = true;
+        } else if (c == ']') {
+          inClass = false;
+        } else if (c == '/' && !inClass) {
+          break;
+        }
+      }
+      while (m_p < m_end && isIdentifierPart(*m_p)) ++m_p;  // flags
+    }
+
+    const char *m_p;
+    const char * const m_end;
+    Token m_last;  // for the regexp/division ambiguity
+  };
+
+  class Scanner {
+  public:
+    Scanner(const char *source, size_t length)
+     : m_lexer(source, length) {
+    }
+
+    std::vector<std::string> scan() {
+      bool afterDot = false;  // e.g. "obj.import(...)"
+      Token token = m_lexer.next();
+
+      while (token.type != TokenType::End) {
+        if (!afterDot && isIdentifier(token, "import")) {
+          token = scanImport();
+          afterDot = false;
+        } else if (!afterDot && isIdentifier(token, "export")) {
+          token = scanExport();
+          afterDot = false;
+        } else {
+          afterDot = isPunctuator(token, '.');
+          token = m_lexer.next();
+        }
+      }
+
+      return std::move(m_specifiers);
+    }
+
+  private:
+    // The scan functions return the first token which does not belong to the statement
+
+    Token scanImport() {
+      Token token = m_lexer.next();
+
+      if (isPunctuator(token, '(')) {
+        // import("x") or import("x", options)
+        Token specifier = m_lexer.next();
+        if (specifier.type != TokenType::String) {
+          return specifier;
+        }
+        token = m_lexer.next();
+        if (isPunctuator(token, ')') || isPunctuator(token, ',')) {
+          add(std::move(specifier.text));
+        }
+        return token;
+      }
+
+      if (token.type == TokenType::String) {
+        // import "x"
+        add(std::move(token.text));
+        return m_lexer.next();
+      }
+
+      return scanFromClause(token);
+    }
+
+    Token scanExport() {
+      Token token = m_lexer.next();
+
+      // export * from "x", export * as ns from "x", export { a, b as c } from "x"
+      if (isPunctuator(token, '*') || isPunctuator(token, '{')) {
+        return scanFromClause(token);
+      }
+
+      return token;
+    }
+
+    // Bindings followed by: from "x"
+    Token scanFromClause(Token token) {
+      while (true) {
+        if (isIdentifier(token, "from")) {
+          Token specifier = m_lexer.next();
+          if (specifier.type != TokenType::String) {
+            return specifier;
+          }
+          add(std::move(specifier.text));
+          return m_lexer.next();
+        }
+
+        if (isPunctuator(token, '{')) {
+          do {
+            token = m_lexer.next();
+          } while (token.type != TokenType::End && !isPunctuator(token, '}'));
+        } else if (token.type != TokenType::Identifier && !isPunctuator(token, '*') && !isPunctuator(token, ',')) {
+          return token;
+        }
+
+        token = m_lexer.next();
+      }
+    }
+
+    void add(std::string &&specifier) {
+      if (std::find(m_specifiers.begin(), m_specifiers.end(), specifier) == m_specifiers.end()) {
+        m_specifiers.push_back(std::move(specifier));
+      }
+    }
+
+    Lexer m_lexer;
+    std::vector<std::string> m_specifiers;
+  };
+}
+
+
+std::vector<std::string> ModuleImports::scan(const char *source, size_t length) {
+  return Scanner(source, length).scan();
+}
+
+std::string ModuleImports::normalize(const std::string &baseName, const std::string &specifier) {
+  if (specifier.empty() || specifier[0] != '.') {
+    return specifier;
+  }
+
+  // Directory of the base module
+  const size_t lastSlash = baseName.rfind('/');
+  std::string directory = lastSlash == std::string::npos ? std::string() : baseName.substr(0, lastSlash);
+
+  // Only the leading "./" and "../" are resolved
+  size_t pos = 0;
+  while (true) {
+    if (specifier.compare(pos, 2, "./") == 0) {
+      pos += 2;
+    } else if (specifier.compare(pos, 3, "../") == 0) {
+      if (directory.empty()) {
+        break;
+      }
+      const size_t slash = directory.rfind('/');
+      const std::string lastElement = slash == std::string::npos ? directory : directory.substr(slash + 1);
+      if (lastElement == "." || lastElement == "..") {
+        break;
+      }
+      directory.erase(slash == std::string::npos ? 0 : slash);
+      pos += 3;
+    } else {
+      break;
+    }
+  }
+
+  return directory.empty() ? specifier.substr(pos) : directory + "/" + specifier.substr(pos);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_MODULEIMPORTS_H
+#define _JSBRIDGE_MODULEIMPORTS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Lightweight scan of the modules imported by an ES module source. It does not need any JS context
+// (i.e. it can run in any thread) so that the imported modules can be fetched before the JS engine
+// asks for them:
+// - static imports and re-exports: import ... from "x", import "x", export ... from "x"
+// - dynamic imports of string literals: import("x")
+//
+// The source is only tokenized (strings, comments, template and regexp literals are skipped) and
+// the scan never fails: syntax errors are reported later by the JS engine.
+namespace ModuleImports {
+
+  // Module specifiers in order of appearance (without duplicates)
+  std::vector<std::string> scan(const char *source, size_t length);
+
+  // Same as the default module name normalizer of QuickJS: relative specifiers ("./", "../") are
+  // resolved against the directory of the base module name
+  std::string normalize(const std::string &baseName, const std::string &specifier);
+}
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "NativeHeap.h"
+
+#include <malloc.h>
+
+#if defined(__BIONIC__)
+# include <dlfcn.h>
+#endif
+
+namespace NativeHeap {
+
+  size_t getAllocatedSize() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+#else
+    struct mallinfo info = mallinfo();
+#endif
+    return static_cast<size_t>(info.uordblks);
+  }
+
+  void trim() {
+#if defined(__BIONIC__)
+    // mallopt(M_PURGE) is only available since API 28 (resolved at runtime as minSdk is lower)
+    static const auto malloptFunc = reinterpret_cast<int (*)(int, int)>(dlsym(RTLD_DEFAULT, "mallopt"));
+    const int M_PURGE_VALUE = -101;  // M_PURGE
+    if (malloptFunc != nullptr) {
+      malloptFunc(M_PURGE_VALUE, 0);
+    }
+#elif defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+  }
+}
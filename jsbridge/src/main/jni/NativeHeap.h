@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_NATIVEHEAP_H
+#define _JSBRIDGE_NATIVEHEAP_H
+
+#include <cstddef>
+
+// Helpers for the native (malloc) heap of the process
+namespace NativeHeap {
+
+  // Number of bytes currently allocated via malloc (all threads)
+  size_t getAllocatedSize();
+
+  // Return the free pages of the allocator to the system
+  void trim();
+}
+
+#endif
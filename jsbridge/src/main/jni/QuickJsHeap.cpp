@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "QuickJsHeap.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <malloc.h>
+
+namespace {
+  typedef QuickJsHeap::BlockHeader BlockHeader;
+
+  // Same as MALLOC_OVERHEAD in quickjs.c (+ block header)
+  const size_t BLOCK_OVERHEAD = 8 + sizeof(BlockHeader);
+
+  BlockHeader *toBlock(void *ptr) {
+    return static_cast<BlockHeader *>(ptr) - 1;
+  }
+
+  size_t blockUsableSize(const BlockHeader *block) {
+    return malloc_usable_size(const_cast<BlockHeader *>(block)) - sizeof(BlockHeader);
+  }
+
+  size_t heapMallocUsableSize(const void *ptr) {
+    if (ptr == nullptr) {
+      return 0;
+    }
+
+    return blockUsableSize(static_cast<const BlockHeader *>(ptr) - 1);
+  }
+
+  void *heapMalloc(JSMallocState *s, size_t size) {
+    // Do not allocate zero bytes: behavior is platform dependent
+    assert(size != 0);
+
+    if (s->malloc_size + size > s->malloc_limit) {
+      return nullptr;
+    }
+
+    auto block = static_cast<BlockHeader *>(malloc(sizeof(BlockHeader) + size));
+    if (block == nullptr) {
+      return nullptr;
+    }
+
+    static_cast<QuickJsHeap *>(s->opaque)->link(block);
+
+    s->malloc_count++;
+    s->malloc_size += blockUsableSize(block) + BLOCK_OVERHEAD;
+    return block + 1;
+  }
+
+  void heapFree(JSMallocState *s, void *ptr) {
+    if (ptr == nullptr) {
+      return;
+    }
+
+    BlockHeader *block = toBlock(ptr);
+    QuickJsHeap::unlink(block);
+
+    s->malloc_count--;
+    s->malloc_size -= blockUsableSize(block) + BLOCK_OVERHEAD;
+    free(block);
+  }
+
+  void *heapRealloc(JSMallocState *s, void *ptr, size_t size) {
+    if (ptr == nullptr) {
+      if (size == 0) {
+        return nullptr;
+      }
+      return heapMalloc(s, size);
+    }
+
+    if (size == 0) {
+      heapFree(s, ptr);
+      return nullptr;
+    }
+
+    BlockHeader *block = toBlock(ptr);
+    const size_t oldSize = blockUsableSize(block);
+    if (s->malloc_size + size - oldSize > s->malloc_limit) {
+      return nullptr;
+    }
+
+    // The block might be moved: unlink it first and link the new one
+    QuickJsHeap::unlink(block);
+    auto newBlock = static_cast<BlockHeader *>(realloc(block, sizeof(BlockHeader) + size));
+    if (newBlock == nullptr) {
+      // The original block is still valid
+      static_cast<QuickJsHeap *>(s->opaque)->link(block);
+      return nullptr;
+    }
+    static_cast<QuickJsHeap *>(s->opaque)->link(newBlock);
+
+    s->malloc_size += blockUsableSize(newBlock) - oldSize;
+    return newBlock + 1;
+  }
+}
+
+// static
+const JSMallocFunctions QuickJsHeap::mallocFunctions = {
+    heapMalloc,
+    heapFree,
+    heapRealloc,
+    heapMallocUsableSize
+};
+
+QuickJsHeap::QuickJsHeap() {
+  m_blocks.prev = &m_blocks;
+  m_blocks.next = &m_blocks;
+}
+
+QuickJsHeap::~QuickJsHeap() {
+  freeAll();
+}
+
+void QuickJsHeap::freeAll() {
+  BlockHeader *block = m_blocks.next;
+  while (block != &m_blocks) {
+    BlockHeader *next = block->next;
+    free(block);
+    block = next;
+  }
+
+  m_blocks.prev = &m_blocks;
+  m_blocks.next = &m_blocks;
+}
+
+void QuickJsHeap::link(BlockHeader *block) {
+  block->prev = &m_blocks;
+  block->next = m_blocks.next;
+  m_blocks.next->prev = block;
+  m_blocks.next = block;
+}
+
+// static
+void QuickJsHeap::unlink(BlockHeader *block) {
+  block->prev->next = block->next;
+  block->next->prev = block->prev;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_QUICKJS_HEAP_H
+#define _JSBRIDGE_QUICKJS_HEAP_H
+
+#include "quickjs/quickjs.h"
+
+// Allocator of a QuickJS runtime which keeps track of all its memory blocks so that the whole JS
+// heap can be discarded at once, without freeing (and finalizing) each JS value individually.
+//
+// Each block has an additional header linking it into the list of allocated blocks.
+//
+// Usage:
+// JSRuntime *rt = JS_NewRuntime2(&QuickJsHeap::mallocFunctions, heap);
+// ...
+// heap->freeAll();  // instead of JS_FreeRuntime(rt)
+class QuickJsHeap {
+
+public:
+  QuickJsHeap();
+  QuickJsHeap(const QuickJsHeap &) = delete;
+  QuickJsHeap &operator=(const QuickJsHeap &) = delete;
+
+  // Free all the remaining blocks
+  ~QuickJsHeap();
+
+  // Free all the allocated blocks. The runtime must not be used anymore!
+  void freeAll();
+
+  static const JSMallocFunctions mallocFunctions;
+
+public:  // internal
+  struct alignas(16) BlockHeader {
+    BlockHeader *prev;
+    BlockHeader *next;
+  };
+
+  void link(BlockHeader *block);
+  static void unlink(BlockHeader *block);
+
+private:
+  BlockHeader m_blocks;  // sentinel of the circular list
+};
+
+#endif
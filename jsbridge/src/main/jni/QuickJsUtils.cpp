@@ -21,7 +21,10 @@ JSClassID QuickJsUtils::js_cppwrapper_class_id;
 namespace {
   void js_cppwrapper_finalizer(JSRuntime *, JSValue val) {
     auto cppWrapper = reinterpret_cast<QuickJsUtils::CppWrapper *>(JS_GetOpaque(val, QuickJsUtils::js_cppwrapper_class_id));
-    cppWrapper->deleter();
+    QuickJsUtils::unregisterCppWrapper(cppWrapper);
+    if (cppWrapper->deleter != nullptr) {
+      cppWrapper->deleter(cppWrapper->ptr);
+    }
     delete cppWrapper;
   }
 
@@ -34,6 +37,9 @@ namespace {
 QuickJsUtils::QuickJsUtils(const JniContext *jniContext, JSContext *ctx)
  : m_jniContext(jniContext)
  , m_ctx(ctx) {
+  m_cppWrappers.prev = &m_cppWrappers;
+  m_cppWrappers.next = &m_cppWrappers;
+
   // class ID (created once)
   JS_NewClassID(&js_cppwrapper_class_id);
 
@@ -63,3 +69,26 @@ std::string QuickJsUtils::toString(JSValueConst v) const {
   return ret;
 }
 
+void QuickJsUtils::deleteAllCppWrappers() {
+  while (m_cppWrappers.next != &m_cppWrappers) {
+    CppWrapper *cppWrapper = m_cppWrappers.next;
+    unregisterCppWrapper(cppWrapper);
+    if (cppWrapper->deleter != nullptr) {
+      cppWrapper->deleter(cppWrapper->ptr);
+    }
+    delete cppWrapper;
+  }
+}
+
+void QuickJsUtils::registerCppWrapper(CppWrapper *cppWrapper) const {
+  cppWrapper->prev = &m_cppWrappers;
+  cppWrapper->next = m_cppWrappers.next;
+  m_cppWrappers.next->prev = cppWrapper;
+  m_cppWrappers.next = cppWrapper;
+}
+
+// static
+void QuickJsUtils::unregisterCppWrapper(CppWrapper *cppWrapper) {
+  cppWrapper->prev->next = cppWrapper->next;
+  cppWrapper->next->prev = cppWrapper->prev;
+}
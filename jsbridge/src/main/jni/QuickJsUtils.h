@@ -19,7 +19,6 @@
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
 #include "quickjs/quickjs.h"
-#include <functional>
 
 static const char *CPP_OBJECT_MAP_PROP_NAME = "__cpp_object_map";
 
@@ -43,13 +42,8 @@ public:
   JSValue createCppPtrValue(T *obj, bool deleteOnFinalize) const {
     JSValue cppWrapperObj = JS_NewObjectClass(m_ctx, js_cppwrapper_class_id);
 
-    auto deleter = [deleteOnFinalize, obj]() {
-      if (deleteOnFinalize) {
-        delete obj;
-      }
-    };
-
-    auto cppWrapper = new CppWrapper { obj, deleter };
+    auto cppWrapper = new CppWrapper { obj, deleteOnFinalize ? deleteCppPtr<T> : nullptr };
+    registerCppWrapper(cppWrapper);
     JS_SetOpaque(cppWrapperObj, cppWrapper);
     return cppWrapperObj;
   }
@@ -119,11 +113,8 @@ public:
 
     auto globalRefPtr = new JniGlobalRef<T>(ref);
 
-    auto deleter = [globalRefPtr]() {
-      delete globalRefPtr;
-    };
-
-    auto cppWrapper = new CppWrapper { globalRefPtr, deleter };
+    auto cppWrapper = new CppWrapper { globalRefPtr, deleteCppPtr<JniGlobalRef<T>> };
+    registerCppWrapper(cppWrapper);
     JS_SetOpaque(cppWrapperObj, cppWrapper);
 
     return cppWrapperObj;
@@ -143,17 +134,33 @@ public:
     return JniLocalRef<T>(*globalRefPtr);
   }
 
+  // Delete all the wrapped instances (and release the wrapped JNI refs) in one pass, without
+  // finalizing the wrapper values. Only used before discarding the whole JS heap!
+  void deleteAllCppWrappers();
+
 public:  // internal
-  typedef struct {
+  struct CppWrapper {
     void *ptr;
-    std::function<void()> deleter;
-  } CppWrapper;
+    void (*deleter)(void *);  // nullptr if the instance must not be deleted on finalize
+    CppWrapper *prev = nullptr;
+    CppWrapper *next = nullptr;
+  };
 
   static JSClassID js_cppwrapper_class_id;
 
+  static void unregisterCppWrapper(CppWrapper *);
+
 private:
+  template <class T>
+  static void deleteCppPtr(void *ptr) {
+    delete static_cast<T *>(ptr);
+  }
+
+  void registerCppWrapper(CppWrapper *) const;
+
   const JniContext *m_jniContext;
   JSContext *m_ctx;
+  mutable CppWrapper m_cppWrappers { nullptr, nullptr };  // sentinel of the circular list
 };
 
 #endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "SourceMap.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+  int base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+  }
+
+  // Decode a base64 VLQ value starting at pos (which is moved past the value)
+  int32_t decodeVlq(std::string_view mappings, size_t &pos) {
+    uint32_t result = 0;
+    int shift = 0;
+
+    for (;;) {
+      if (pos >= mappings.size()) {
+        throw std::invalid_argument("Invalid source map mappings (truncated VLQ value)");
+      }
+      const int digit = base64Value(mappings[pos++]);
+      if (digit < 0 || shift > 30) {
+        throw std::invalid_argument("Invalid source map mappings (invalid VLQ value)");
+      }
+      result |= static_cast<uint32_t>(digit & 31) << shift;
+      if ((digit & 32) == 0) {
+        break;
+      }
+      shift += 5;
+    }
+
+    // The sign is stored in the least significant bit
+    const auto value = static_cast<int32_t>(result >> 1);
+    return (result & 1) ? -value : value;
+  }
+}
+
+SourceMap::SourceMap(std::string_view mappings) {
+  // The generated column is relative to the previous segment of the same line, all the other
+  // fields are relative to the previous segment of the whole mappings
+  int32_t sourceIndex = 0, originalLine = 0, originalColumn = 0, nameIndex = 0;
+  int32_t generatedColumn = 0;
+
+  m_lineOffsets.push_back(0);
+
+  size_t pos = 0;
+  while (pos < mappings.size()) {
+    const char c = mappings[pos];
+    if (c == ';') {
+      ++pos;
+      m_lineOffsets.push_back(static_cast<uint32_t>(m_mappings.size()));
+      generatedColumn = 0;
+      continue;
+    }
+    if (c == ',') {
+      ++pos;
+      continue;
+    }
+
+    Mapping mapping = { 0, -1, 0, 0, -1 };
+    generatedColumn += decodeVlq(mappings, pos);
+    mapping.generatedColumn = generatedColumn;
+
+    if (pos < mappings.size() && mappings[pos] != ',' && mappings[pos] != ';') {
+      sourceIndex += decodeVlq(mappings, pos);
+      originalLine += decodeVlq(mappings, pos);
+      originalColumn += decodeVlq(mappings, pos);
+      mapping.sourceIndex = sourceIndex;
+      mapping.originalLine = originalLine;
+      mapping.originalColumn = originalColumn;
+
+      if (pos < mappings.size() && mappings[pos] != ',' && mappings[pos] != ';') {
+        nameIndex += decodeVlq(mappings, pos);
+        mapping.nameIndex = nameIndex;
+      }
+    }
+
+    if (pos < mappings.size() && mappings[pos] != ',' && mappings[pos] != ';') {
+      throw std::invalid_argument("Invalid source map mappings (too many segment fields)");
+    }
+
+    m_mappings.push_back(mapping);
+  }
+
+  m_lineOffsets.push_back(static_cast<uint32_t>(m_mappings.size()));
+  m_mappings.shrink_to_fit();
+  m_lineOffsets.shrink_to_fit();
+
+  // Segments should already be sorted by column but this is not enforced by all generators
+  for (size_t line = 0; line + 1 < m_lineOffsets.size(); ++line) {
+    std::stable_sort(m_mappings.begin() + m_lineOffsets[line], m_mappings.begin() + m_lineOffsets[line + 1],
+                     [](const Mapping &a, const Mapping &b) { return a.generatedColumn < b.generatedColumn; });
+  }
+}
+
+const SourceMap::Mapping *SourceMap::find(int line, int column) const {
+  if (line < 0 || static_cast<size_t>(line) + 1 >= m_lineOffsets.size()) {
+    return nullptr;
+  }
+
+  auto begin = m_mappings.begin() + m_lineOffsets[line];
+  auto end = m_mappings.begin() + m_lineOffsets[line + 1];
+
+  if (column < 0) {
+    auto it = std::find_if(begin, end, [](const Mapping &m) { return m.sourceIndex >= 0; });
+    if (it == end) {
+      return nullptr;
+    }
+
+    // Without a column, the line can only be resolved if all its segments map to the same
+    // original line (minified code usually merges several original lines into one)
+    bool isAmbiguous = std::any_of(it + 1, end, [&](const Mapping &m) {
+      return m.sourceIndex >= 0 && (m.sourceIndex != it->sourceIndex || m.originalLine != it->originalLine);
+    });
+    return isAmbiguous ? nullptr : &*it;
+  }
+
+  // Last segment starting at or before the column
+  auto it = std::upper_bound(begin, end, column, [](int c, const Mapping &m) { return c < m.generatedColumn; });
+  if (it == begin) {
+    return nullptr;
+  }
+  --it;
+  return it->sourceIndex >= 0 ? &*it : nullptr;
+}
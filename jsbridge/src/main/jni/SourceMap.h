@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_SOURCEMAP_H
+#define _JSBRIDGE_SOURCEMAP_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Decoded "mappings" of a source map (revision 3), indexed by generated line so that stack trace
+// locations can be resolved without scanning the whole mappings. Immutable once decoded: can be
+// used from any thread.
+//
+// Sources and names are kept on the Java side; mappings only reference them by index.
+class SourceMap {
+public:
+  struct Mapping {
+    int32_t generatedColumn;
+    int32_t sourceIndex;  // -1 for unmapped segments
+    int32_t originalLine;
+    int32_t originalColumn;
+    int32_t nameIndex;  // -1 if none
+  };
+
+  // Decode the VLQ mappings. Throws std::invalid_argument if they are invalid.
+  explicit SourceMap(std::string_view mappings);
+  SourceMap(const SourceMap &) = delete;
+  SourceMap &operator=(const SourceMap &) = delete;
+
+  // Mapping of the given 0-based generated position or nullptr if the position is not mapped.
+  // A negative column (unknown, e.g. stack traces with line numbers only) matches the first mapped
+  // segment of the line, or nullptr if the segments of the line map to different original lines.
+  const Mapping *find(int line, int column) const;
+
+private:
+  std::vector<Mapping> m_mappings;
+  // Index of the first mapping of each generated line (plus the end index)
+  std::vector<uint32_t> m_lineOffsets;
+};
+
+#endif
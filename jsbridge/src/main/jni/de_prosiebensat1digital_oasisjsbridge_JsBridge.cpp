@@ -18,15 +18,27 @@
  */
 #include "de_prosiebensat1digital_oasisjsbridge_JsBridge.h"
 #include "ExceptionHandler.h"
+#include "JavaStringPool.h"
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "JsThread.h"
+#include "JsonTape.h"
+#include "ModuleImports.h"
+#include "SourceMap.h"
 #include "log.h"
+#include "extensions/NativeExtensions.h"
+#include "extensions/TypedArrayKernels.h"
 #include "java-types/Deferred.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniContext.h"
 #include "jni-helpers/JniLocalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
+#include <algorithm>
+#include <memory>
 #include <new>
+#include <stdexcept>
+#include <vector>
 
 namespace {
   // This should be instanciated in each JNI entry function to make sure that the JNI context is
@@ -53,7 +65,7 @@ namespace {
 
 extern "C" {
 
-JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCreateContext(JNIEnv *env, jobject object) {
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCreateContext(JNIEnv *env, jobject object, jboolean fastRelease, jboolean canBlock, jint builtIns) {
 
   alog("jniCreateContext()");
 
@@ -61,7 +73,7 @@ JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniC
   auto jniContext = new JniContext(env, JniContext::EnvironmentSource::Manual);
 
   try {
-    jsBridgeContext->init(jniContext, JniLocalRef<jobject>(jniContext, object, JniLocalRefMode::Borrowed));
+    jsBridgeContext->init(jniContext, JniLocalRef<jobject>(jniContext, object, JniLocalRefMode::Borrowed), fastRelease, canBlock, builtIns);
   } catch (const std::bad_alloc &) {
     return 0L;
   }
@@ -117,6 +129,100 @@ JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jn
   return returnValue.get();
 }
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterTypedArrayKernels
+        (JNIEnv *env, jobject, jlong lctx, jstring globalName) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    TypedArrayKernels::registerGlobal(jsBridgeContext, strGlobalName);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterNativeExtension
+        (JNIEnv *env, jobject, jlong lctx, jstring libraryName, jstring entryPoint) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strLibraryName = JStringLocalRef(jniContext, libraryName, JniLocalRefMode::Borrowed).toStdString();
+  std::string strEntryPoint = JStringLocalRef(jniContext, entryPoint, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    NativeExtensions::load(jsBridgeContext, strLibraryName, strEntryPoint);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsThreadPriority
+        (JNIEnv *env, jobject, jlong lctx, jint priority) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+
+  try {
+    JsThread::setPriority(priority);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsThreadAffinity
+        (JNIEnv *env, jobject, jlong lctx, jintArray cpus) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JArrayLocalRef<jint> cpuArray(JniLocalRef<jarray>(jniContext, cpus, JniLocalRefMode::Borrowed));
+  const jint *elements = cpuArray.getElements();
+  if (elements == nullptr) {
+    // Pending Java exception (OutOfMemoryError)
+    return;
+  }
+  std::vector<int> cpuVector(elements, elements + cpuArray.getLength());
+  cpuArray.releaseArrayElements();
+
+  try {
+    JsThread::setAffinity(cpuVector);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+// Returns [priority, current CPU, allowed CPU 1, allowed CPU 2, ...]
+JNIEXPORT jintArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsThreadPlacement
+        (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::vector<int> placement;
+  try {
+    placement.push_back(JsThread::getPriority());
+    placement.push_back(JsThread::getCurrentCpu());
+    std::vector<int> cpus = JsThread::getAffinity();
+    placement.insert(placement.end(), cpus.begin(), cpus.end());
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  JArrayLocalRef<jint> placementArray(jniContext, static_cast<jsize>(placement.size()));
+  jint *elements = placementArray.getMutableElements();
+  std::copy(placement.begin(), placement.end(), elements);
+  placementArray.releaseArrayElements();  // copy back elements to Java
+
+  // Prevent auto-releasing the localref returned to Java
+  placementArray.detach();
+
+  return static_cast<jintArray>(placementArray.get());
+}
+
 
 JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateString
     (JNIEnv *env, jobject, jlong lctx, jstring code, jobject returnParameter, jboolean awaitJsPromise) {
@@ -332,6 +438,296 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCo
   }
 }
 
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSerializeJsValue
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jstring transferListGlobalName, jboolean allowSharedArrayBuffers) {
+
+  //alog("jniSerializeJsValue()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+  std::string strTransferListGlobalName = transferListGlobalName == nullptr ? std::string() :
+      JStringLocalRef(jniContext, transferListGlobalName, JniLocalRefMode::Borrowed).toStdString();
+
+  JValue returnValue;
+  try {
+    returnValue = jsBridgeContext->serializeJsValue(strGlobalName, strTransferListGlobalName, allowSharedArrayBuffers);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detachLocalRef();
+
+  return static_cast<jbyteArray>(returnValue.get().l);
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeserializeJsValue
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jbyteArray data, jboolean allowSharedArrayBuffers) {
+
+  //alog("jniDeserializeJsValue()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->deserializeJsValue(strGlobalName, JniLocalRef<jarray>(jniContext, data, JniLocalRefMode::Borrowed), allowSharedArrayBuffers);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+// Static: can be called from any thread (no JS context needed)
+// Returns null if the JSON text is invalid
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniParseJsonTape
+    (JNIEnv *env, jclass, jbyteArray json) {
+
+  //alog("jniParseJsonTape()");
+
+  jbyte *elements = env->GetByteArrayElements(json, nullptr);
+  if (elements == nullptr) {
+    return nullptr;  // OutOfMemoryError already thrown
+  }
+
+  std::vector<uint8_t> tape;
+  try {
+    tape = JsonTape::parse(reinterpret_cast<const char *>(elements), static_cast<size_t>(env->GetArrayLength(json)));
+  } catch (const std::invalid_argument &) {
+    // Invalid JSON: JSON.parse() will generate the appropriate error in the JS thread
+  }
+  env->ReleaseByteArrayElements(json, elements, JNI_ABORT);
+
+  if (tape.empty()) {
+    return nullptr;
+  }
+
+  jbyteArray tapeArray = env->NewByteArray(static_cast<jsize>(tape.size()));
+  if (tapeArray != nullptr) {
+    env->SetByteArrayRegion(tapeArray, 0, static_cast<jsize>(tape.size()), reinterpret_cast<const jbyte *>(tape.data()));
+  }
+  return tapeArray;
+}
+
+// Static: can be called from any thread (no JS context needed)
+// Returns a pointer to the native tape which must be consumed via jniAssignNativeJsonTape() or
+// deleted via jniDeleteNativeJsonTape(). The tape is not copied into the Java heap.
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniParseJsonTapeStream
+    (JNIEnv *env, jclass, jobject inputStream) {
+
+  //alog("jniParseJsonTapeStream()");
+
+  // Thrown when InputStream.read() failed (pending Java exception)
+  struct ReadError {};
+
+  const jint chunkSize = 64 * 1024;
+  jbyteArray chunkArray = env->NewByteArray(chunkSize);
+  if (chunkArray == nullptr) {
+    return 0;  // OutOfMemoryError already thrown
+  }
+  jclass inputStreamClass = env->GetObjectClass(inputStream);
+  jmethodID readMethodId = env->GetMethodID(inputStreamClass, "read", "([BII)I");
+  env->DeleteLocalRef(inputStreamClass);
+
+  std::vector<uint8_t> tape;
+  try {
+    tape = JsonTape::parse([=](char *buffer, size_t capacity) -> size_t {
+      const jint maxLength = std::min(chunkSize, static_cast<jint>(capacity));
+      const jint length = env->CallIntMethod(inputStream, readMethodId, chunkArray, 0, maxLength);
+      if (env->ExceptionCheck()) {
+        throw ReadError();
+      }
+      if (length <= 0) {
+        return 0;
+      }
+      env->GetByteArrayRegion(chunkArray, 0, length, reinterpret_cast<jbyte *>(buffer));
+      return static_cast<size_t>(length);
+    });
+  } catch (const ReadError &) {
+  } catch (const std::invalid_argument &e) {
+    jclass exceptionClass = env->FindClass("java/lang/IllegalArgumentException");
+    env->ThrowNew(exceptionClass, e.what());
+    env->DeleteLocalRef(exceptionClass);
+  }
+  env->DeleteLocalRef(chunkArray);
+
+  if (env->ExceptionCheck()) {
+    return 0;
+  }
+
+  return reinterpret_cast<jlong>(new std::vector<uint8_t>(std::move(tape)));
+}
+
+// Static: can be called from any thread (no JS context needed)
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteNativeJsonTape
+    (JNIEnv *, jclass, jlong ltape) {
+
+  delete reinterpret_cast<std::vector<uint8_t> *>(ltape);
+}
+
+// Static: can be called from any thread (no JS context needed)
+// Returns a pointer to the decoded mappings which must be deleted via jniDeleteSourceMap()
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDecodeSourceMap
+    (JNIEnv *env, jclass, jstring mappings) {
+
+  //alog("jniDecodeSourceMap()");
+
+  // Mappings only contain base64 characters, ',' and ';'
+  const char *mappingsChars = env->GetStringUTFChars(mappings, nullptr);
+  if (mappingsChars == nullptr) {
+    return 0;  // OutOfMemoryError already thrown
+  }
+
+  SourceMap *sourceMap = nullptr;
+  try {
+    sourceMap = new SourceMap(std::string_view(mappingsChars, static_cast<size_t>(env->GetStringUTFLength(mappings))));
+  } catch (const std::invalid_argument &e) {
+    jclass exceptionClass = env->FindClass("java/lang/IllegalArgumentException");
+    env->ThrowNew(exceptionClass, e.what());
+    env->DeleteLocalRef(exceptionClass);
+  }
+  env->ReleaseStringUTFChars(mappings, mappingsChars);
+
+  return reinterpret_cast<jlong>(sourceMap);
+}
+
+// Static: can be called from any thread (no JS context needed)
+// Returns [sourceIndex, originalLine, originalColumn, nameIndex] (0-based) or null if the given
+// 0-based generated position is not mapped
+JNIEXPORT jintArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniResolveSourceMapLocation
+    (JNIEnv *env, jclass, jlong lsourceMap, jint line, jint column) {
+
+  auto sourceMap = reinterpret_cast<const SourceMap *>(lsourceMap);
+  const SourceMap::Mapping *mapping = sourceMap->find(line, column);
+  if (mapping == nullptr) {
+    return nullptr;
+  }
+
+  const jint location[] = { mapping->sourceIndex, mapping->originalLine, mapping->originalColumn, mapping->nameIndex };
+  jintArray locationArray = env->NewIntArray(4);
+  if (locationArray != nullptr) {
+    env->SetIntArrayRegion(locationArray, 0, 4, location);
+  }
+  return locationArray;
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteSourceMap
+    (JNIEnv *, jclass, jlong lsourceMap) {
+
+  delete reinterpret_cast<SourceMap *>(lsourceMap);
+}
+
+// Static: can be called from any thread (no JS context needed)
+// Returns the normalized names of the modules imported by the given module source
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniScanModuleImports
+    (JNIEnv *env, jclass, jstring source, jstring moduleName) {
+
+  //alog("jniScanModuleImports()");
+
+  const char *sourceChars = env->GetStringUTFChars(source, nullptr);
+  if (sourceChars == nullptr) {
+    return nullptr;  // OutOfMemoryError already thrown
+  }
+  std::vector<std::string> specifiers = ModuleImports::scan(sourceChars, static_cast<size_t>(env->GetStringUTFLength(source)));
+  env->ReleaseStringUTFChars(source, sourceChars);
+
+  const char *moduleNameChars = env->GetStringUTFChars(moduleName, nullptr);
+  if (moduleNameChars == nullptr) {
+    return nullptr;  // OutOfMemoryError already thrown
+  }
+  const std::string baseName = moduleNameChars;
+  env->ReleaseStringUTFChars(moduleName, moduleNameChars);
+
+  jclass stringClass = env->FindClass("java/lang/String");
+  jobjectArray moduleNames = env->NewObjectArray(static_cast<jsize>(specifiers.size()), stringClass, nullptr);
+  env->DeleteLocalRef(stringClass);
+  if (moduleNames == nullptr) {
+    return nullptr;  // OutOfMemoryError already thrown
+  }
+
+  for (size_t i = 0; i < specifiers.size(); ++i) {
+    jstring name = env->NewStringUTF(ModuleImports::normalize(baseName, specifiers[i]).c_str());
+    if (name == nullptr) {
+      return nullptr;  // OutOfMemoryError already thrown
+    }
+    env->SetObjectArrayElement(moduleNames, static_cast<jsize>(i), name);
+    env->DeleteLocalRef(name);
+  }
+  return moduleNames;
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignJsonTape
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jbyteArray tape) {
+
+  //alog("jniAssignJsonTape()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->assignJsonTape(strGlobalName, JniLocalRef<jarray>(jniContext, tape, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+// Takes ownership of the native tape returned by jniParseJsonTapeStream()
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignNativeJsonTape
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jlong ltape) {
+
+  //alog("jniAssignNativeJsonTape()");
+
+  std::unique_ptr<std::vector<uint8_t>> tape(reinterpret_cast<std::vector<uint8_t> *>(ltape));
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->assignJsonTape(strGlobalName, tape->data(), tape->size());
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWriteJson
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jobject buffer, jobject output) {
+
+  //alog("jniWriteJson()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->writeJson(strGlobalName, JniLocalRef<jobject>(jniContext, buffer, JniLocalRefMode::Borrowed), JniLocalRef<jobject>(jniContext, output, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReleaseSerializedJsValue
+    (JNIEnv *env, jobject, jlong lctx, jbyteArray data) {
+
+  //alog("jniReleaseSerializedJsValue()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  try {
+    jsBridgeContext->releaseSerializedJsValue(JniLocalRef<jarray>(jniContext, data, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsFunction
     (JNIEnv *env, jobject, jlong lctx, jstring globalName, jobjectArray args, jstring jsCode) {
 
@@ -397,4 +793,98 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniPr
   jsBridgeContext->processPromiseQueue();
 }
 
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReclaimMemory
+  (JNIEnv *env, jobject, jlong lctx, jboolean aggressive) {
+
+  //alog("jniReclaimMemory()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  return static_cast<jlong>(jsBridgeContext->reclaimMemory(aggressive));
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetBaselineHeapSize
+  (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  return static_cast<jlong>(jsBridgeContext->getBaselineHeapSize());
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniInvalidateJavaMethodCaches
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  //alog("jniInvalidateJavaMethodCaches()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  jsBridgeContext->invalidateJavaMethodCaches();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableJavaStringPool
+    (JNIEnv *env, jobject, jlong lctx, jint maxEntries, jint maxLength) {
+
+  //alog("jniEnableJavaStringPool()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  jsBridgeContext->enableJavaStringPool(static_cast<size_t>(maxEntries), static_cast<size_t>(maxLength));
+}
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJavaStringPoolStats
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  //alog("jniGetJavaStringPoolStats()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+
+  const JavaStringPool *javaStringPool = jsBridgeContext->getJavaStringPool();
+  if (javaStringPool == nullptr) {
+    return nullptr;
+  }
+
+  const JavaStringPool::Stats stats = javaStringPool->getStats();
+  const jlong values[] = { stats.hits, stats.misses, stats.evictions, stats.size };
+
+  jlongArray statsArray = env->NewLongArray(4);
+  if (statsArray != nullptr) {
+    env->SetLongArrayRegion(statsArray, 0, 4, values);
+  }
+  return statsArray;
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartEngineProfiling
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  //alog("jniStartEngineProfiling()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+
+  try {
+    jsBridgeContext->startEngineProfiling();
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStopEngineProfiling
+    (JNIEnv *env, jobject, jlong lctx, jint maxFunctions) {
+
+  //alog("jniStopEngineProfiling()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string json;
+  try {
+    json = jsBridgeContext->stopEngineProfiling(maxFunctions);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  auto returnValue = JStringLocalRef(jniContext, json.c_str());
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detach();
+
+  return returnValue.get();
+}
+
 }  // extern "C"
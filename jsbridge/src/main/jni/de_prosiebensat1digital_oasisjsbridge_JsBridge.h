@@ -26,7 +26,7 @@ extern "C" {
 #endif
 
 JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCreateContext
-  (JNIEnv *, jobject);
+  (JNIEnv *, jobject, jboolean, jboolean, jint);
 
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartDebug
     (JNIEnv *, jobject, jlong, jint);
@@ -43,6 +43,21 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEn
 JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetCurrentScriptOrModuleName
         (JNIEnv *, jobject, jlong, jint);
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterTypedArrayKernels
+        (JNIEnv *, jobject, jlong, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterNativeExtension
+        (JNIEnv *, jobject, jlong, jstring, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsThreadPriority
+        (JNIEnv *, jobject, jlong, jint);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsThreadAffinity
+        (JNIEnv *, jobject, jlong, jintArray);
+
+JNIEXPORT jintArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsThreadPlacement
+        (JNIEnv *, jobject, jlong);
+
 JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateString
   (JNIEnv *, jobject, jlong, jstring, jobject, jboolean);
 
@@ -76,6 +91,45 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDe
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCopyJsValue
     (JNIEnv *, jobject, jlong, jstring, jstring);
 
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSerializeJsValue
+    (JNIEnv *, jobject, jlong, jstring, jstring, jboolean);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeserializeJsValue
+    (JNIEnv *, jobject, jlong, jstring, jbyteArray, jboolean);
+
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniParseJsonTape
+    (JNIEnv *, jclass, jbyteArray);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniParseJsonTapeStream
+    (JNIEnv *, jclass, jobject);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteNativeJsonTape
+    (JNIEnv *, jclass, jlong);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDecodeSourceMap
+    (JNIEnv *, jclass, jstring);
+
+JNIEXPORT jintArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniResolveSourceMapLocation
+    (JNIEnv *, jclass, jlong, jint, jint);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteSourceMap
+    (JNIEnv *, jclass, jlong);
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniScanModuleImports
+    (JNIEnv *, jclass, jstring, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignJsonTape
+    (JNIEnv *, jobject, jlong, jstring, jbyteArray);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignNativeJsonTape
+    (JNIEnv *, jobject, jlong, jstring, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWriteJson
+    (JNIEnv *, jobject, jlong, jstring, jobject, jobject);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReleaseSerializedJsValue
+    (JNIEnv *, jobject, jlong, jbyteArray);
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsFunction
 (JNIEnv *, jobject, jlong, jstring, jobjectArray, jstring);
 
@@ -88,6 +142,27 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCo
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniProcessPromiseQueue
     (JNIEnv *, jobject, jlong);
 
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReclaimMemory
+    (JNIEnv *, jobject, jlong, jboolean);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetBaselineHeapSize
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniInvalidateJavaMethodCaches
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableJavaStringPool
+    (JNIEnv *, jobject, jlong, jint, jint);
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJavaStringPoolStats
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartEngineProfiling
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStopEngineProfiling
+    (JNIEnv *, jobject, jlong, jint);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,566 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "NativeExtensions.h"
+
+#include "ExceptionHandler.h"
+#include "JsBridgeContext.h"
+#include "log.h"
+#include <cstring>
+#include <dlfcn.h>
+#include <stdexcept>
+#include <vector>
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#elif defined(QUICKJS)
+# include "QuickJsUtils.h"
+#endif
+
+struct JsBridgeNativeContext {
+  JsBridgeContext *jsBridgeContext;
+};
+
+namespace {
+  const char *PAYLOAD_PROP_NAME = "\xff\xffnativePayload";
+
+  struct NativeFunctionPayload {
+    NativeFunctionPayload(JsBridgeNativeFunction function, void *userData, JsBridgeNativeFinalizer finalizer)
+     : function(function)
+     , userData(userData)
+     , finalizer(finalizer) {
+    }
+
+    NativeFunctionPayload(const NativeFunctionPayload &) = delete;
+    NativeFunctionPayload &operator=(const NativeFunctionPayload &) = delete;
+
+    ~NativeFunctionPayload() {
+      if (finalizer != nullptr) {
+        finalizer(userData);
+      }
+    }
+
+    const JsBridgeNativeFunction function;
+    void * const userData;
+    const JsBridgeNativeFinalizer finalizer;
+  };
+}
+
+#if defined(DUKTAPE)
+
+struct JsBridgeNativeCall {
+  duk_context *ctx;
+  duk_idx_t argCount;
+  bool hasReturnValue;
+  bool hasError;
+  std::string errorMessage;
+};
+
+namespace {
+  bool isValidArg(const JsBridgeNativeCall *call, int index) {
+    return index >= 0 && index < call->argCount;
+  }
+
+  // Replace the previous return value (if any) with the value which will be pushed next
+  void prepareReturnValue(JsBridgeNativeCall *call) {
+    if (call->hasReturnValue) {
+      duk_pop(call->ctx);
+    }
+    call->hasReturnValue = true;
+  }
+
+  extern "C"
+  duk_ret_t callNativeFunction(duk_context *ctx) {
+    duk_push_current_function(ctx);
+    if (!duk_get_prop_string(ctx, -1, PAYLOAD_PROP_NAME)) {
+      duk_pop_2(ctx);  // (undefined) payload + current function
+      return DUK_RET_ERROR;
+    }
+
+    auto payload = reinterpret_cast<const NativeFunctionPayload *>(duk_require_pointer(ctx, -1));
+    duk_pop_2(ctx);  // payload + current function
+
+    bool hasReturnValue, hasError;
+    {
+      JsBridgeNativeCall call { ctx, duk_get_top(ctx), false, false, std::string() };
+      payload->function(&call, payload->userData);
+
+      hasReturnValue = call.hasReturnValue;
+      hasError = call.hasError;
+      if (hasError) {
+        if (hasReturnValue) {
+          duk_pop(ctx);
+        }
+        // Pushed before throwing so that the std::string gets destroyed
+        duk_push_error_object(ctx, DUK_ERR_ERROR, "%s", call.errorMessage.c_str());
+      }
+    }
+
+    if (hasError) {
+      duk_throw(ctx);
+    }
+
+    return hasReturnValue ? 1 : 0;
+  }
+
+  extern "C"
+  duk_ret_t finalizeNativeFunction(duk_context *ctx) {
+    if (duk_get_prop_string(ctx, -1, PAYLOAD_PROP_NAME)) {
+      delete reinterpret_cast<const NativeFunctionPayload *>(duk_require_pointer(ctx, -1));
+    }
+
+    duk_pop(ctx);  // payload
+    return 0;
+  }
+
+  int registerFunction(JsBridgeNativeContext *nativeCtx, const char *objectName, const char *name,
+                       JsBridgeNativeFunction function, int /*argCount*/, void *userData,
+                       JsBridgeNativeFinalizer finalizer) {
+    duk_context *ctx = nativeCtx->jsBridgeContext->getDuktapeContext();
+    CHECK_STACK(ctx);
+
+    if (name == nullptr || function == nullptr) {
+      return -1;
+    }
+
+    duk_push_global_object(ctx);
+    if (objectName != nullptr) {
+      if (!duk_get_prop_string(ctx, -1, objectName)) {
+        duk_pop(ctx);  // undefined
+        duk_push_object(ctx);
+        duk_dup_top(ctx);
+        duk_put_prop_string(ctx, -3, objectName);
+      } else if (!duk_is_object(ctx, -1)) {
+        duk_pop_2(ctx);  // value + global object
+        return -1;
+      }
+    }
+
+    const duk_idx_t funcIdx = duk_push_c_function(ctx, callNativeFunction, DUK_VARARGS);
+
+    duk_push_pointer(ctx, new NativeFunctionPayload(function, userData, finalizer));
+    duk_put_prop_string(ctx, funcIdx, PAYLOAD_PROP_NAME);
+
+    duk_push_c_function(ctx, finalizeNativeFunction, 1);
+    duk_set_finalizer(ctx, funcIdx);
+
+    duk_put_prop_string(ctx, -2, name);
+
+    duk_pop_n(ctx, objectName != nullptr ? 2 : 1);  // (object +) global object
+    return 0;
+  }
+
+  JsBridgeNativeType getArgType(const JsBridgeNativeCall *call, int index) {
+    if (!isValidArg(call, index)) {
+      return JSBRIDGE_NATIVE_TYPE_UNDEFINED;
+    }
+
+    duk_context *ctx = call->ctx;
+    switch (duk_get_type(ctx, index)) {
+      case DUK_TYPE_NULL:
+        return JSBRIDGE_NATIVE_TYPE_NULL;
+      case DUK_TYPE_BOOLEAN:
+        return JSBRIDGE_NATIVE_TYPE_BOOLEAN;
+      case DUK_TYPE_NUMBER:
+        return JSBRIDGE_NATIVE_TYPE_NUMBER;
+      case DUK_TYPE_STRING:
+        return JSBRIDGE_NATIVE_TYPE_STRING;
+      case DUK_TYPE_BUFFER:
+        return JSBRIDGE_NATIVE_TYPE_BUFFER;
+      case DUK_TYPE_OBJECT:
+        if (duk_is_buffer_data(ctx, index)) {
+          return JSBRIDGE_NATIVE_TYPE_BUFFER;
+        }
+        return duk_is_function(ctx, index) ? JSBRIDGE_NATIVE_TYPE_FUNCTION : JSBRIDGE_NATIVE_TYPE_OBJECT;
+      default:
+        return JSBRIDGE_NATIVE_TYPE_UNDEFINED;
+    }
+  }
+
+  int getBool(const JsBridgeNativeCall *call, int index) {
+    if (!isValidArg(call, index)) {
+      return 0;
+    }
+
+    duk_dup(call->ctx, index);
+    const bool b = duk_to_boolean(call->ctx, -1);
+    duk_pop(call->ctx);
+    return b ? 1 : 0;
+  }
+
+  double getDouble(const JsBridgeNativeCall *call, int index) {
+    return isValidArg(call, index) ? duk_get_number(call->ctx, index) : 0.0;
+  }
+
+  int32_t getInt32(const JsBridgeNativeCall *call, int index) {
+    return isValidArg(call, index) ? duk_get_int(call->ctx, index) : 0;
+  }
+
+  const char *getString(JsBridgeNativeCall *call, int index, size_t *length) {
+    if (!isValidArg(call, index) || !duk_is_string(call->ctx, index)) {
+      return nullptr;
+    }
+
+    duk_size_t size = 0;
+    const char *s = duk_get_lstring(call->ctx, index, &size);
+    if (length != nullptr) {
+      *length = size;
+    }
+    return s;
+  }
+
+  void *getBuffer(const JsBridgeNativeCall *call, int index, size_t *byteLength) {
+    if (!isValidArg(call, index) || !duk_is_buffer_data(call->ctx, index)) {
+      return nullptr;
+    }
+
+    duk_size_t size = 0;
+    void *data = duk_get_buffer_data(call->ctx, index, &size);
+    if (byteLength != nullptr) {
+      *byteLength = size;
+    }
+    return data;
+  }
+
+  void returnUndefined(JsBridgeNativeCall *call) {
+    prepareReturnValue(call);
+    duk_push_undefined(call->ctx);
+  }
+
+  void returnNull(JsBridgeNativeCall *call) {
+    prepareReturnValue(call);
+    duk_push_null(call->ctx);
+  }
+
+  void returnBool(JsBridgeNativeCall *call, int value) {
+    prepareReturnValue(call);
+    duk_push_boolean(call->ctx, value != 0);
+  }
+
+  void returnDouble(JsBridgeNativeCall *call, double value) {
+    prepareReturnValue(call);
+    duk_push_number(call->ctx, value);
+  }
+
+  void returnInt32(JsBridgeNativeCall *call, int32_t value) {
+    prepareReturnValue(call);
+    duk_push_int(call->ctx, value);
+  }
+
+  void returnString(JsBridgeNativeCall *call, const char *value, size_t length) {
+    prepareReturnValue(call);
+    duk_push_lstring(call->ctx, value, length);
+  }
+
+  void returnArrayBuffer(JsBridgeNativeCall *call, const void *data, size_t byteLength) {
+    prepareReturnValue(call);
+    duk_context *ctx = call->ctx;
+
+    void *buffer = duk_push_fixed_buffer(ctx, byteLength);
+    if (byteLength > 0) {
+      memcpy(buffer, data, byteLength);
+    }
+    duk_push_buffer_object(ctx, -1, 0, byteLength, DUK_BUFOBJ_ARRAYBUFFER);
+    duk_remove(ctx, -2);  // plain buffer
+  }
+}
+
+#elif defined(QUICKJS)
+
+struct JsBridgeNativeCall {
+  JSContext *ctx;
+  int argc;
+  JSValueConst *argv;
+  JSValue returnValue;
+  bool hasError;
+  std::string errorMessage;
+  std::vector<const char *> cStrings;  // freed at the end of the call
+};
+
+namespace {
+  bool isValidArg(const JsBridgeNativeCall *call, int index) {
+    return index >= 0 && index < call->argc;
+  }
+
+  void setReturnValue(JsBridgeNativeCall *call, JSValue value) {
+    JS_FreeValue(call->ctx, call->returnValue);
+    call->returnValue = value;
+  }
+
+  // Returns nullptr if the value is neither an ArrayBuffer nor a typed array
+  uint8_t *getBufferData(JSContext *ctx, JSValueConst value, size_t *byteLength) {
+    if (!JS_IsObject(value)) {
+      return nullptr;
+    }
+
+    size_t size = 0;
+    uint8_t *data = JS_GetArrayBuffer(ctx, &size, value);
+    if (data != nullptr) {
+      *byteLength = size;
+      return data;
+    }
+    JS_FreeValue(ctx, JS_GetException(ctx));  // not an ArrayBuffer
+
+    size_t byteOffset = 0, bytesPerElement = 0;
+    JSValue arrayBuffer = JS_GetTypedArrayBuffer(ctx, value, &byteOffset, byteLength, &bytesPerElement);
+    if (JS_IsException(arrayBuffer)) {
+      JS_FreeValue(ctx, JS_GetException(ctx));  // not a typed array
+      return nullptr;
+    }
+
+    data = JS_GetArrayBuffer(ctx, &size, arrayBuffer);
+    JS_FreeValue(ctx, arrayBuffer);  // still referenced by the typed array
+    if (data == nullptr) {
+      JS_FreeValue(ctx, JS_GetException(ctx));  // detached buffer
+      return nullptr;
+    }
+
+    return data + byteOffset;
+  }
+
+  JSValue callNativeFunction(JSContext *ctx, JSValueConst, int argc, JSValueConst *argv, int /*magic*/, JSValueConst *datav) {
+    auto payload = QuickJsUtils::getCppPtr<NativeFunctionPayload>(*datav);
+
+    JsBridgeNativeCall call { ctx, argc, argv, JS_UNDEFINED, false, std::string(), {} };
+    payload->function(&call, payload->userData);
+
+    for (const char *cString : call.cStrings) {
+      JS_FreeCString(ctx, cString);
+    }
+
+    if (call.hasError) {
+      JS_FreeValue(ctx, call.returnValue);
+
+      JSValue errorValue = JS_NewError(ctx);
+      JS_SetPropertyStr(ctx, errorValue, "message", JS_NewString(ctx, call.errorMessage.c_str()));
+      JS_Throw(ctx, errorValue);
+      // No JS_FreeValue(ctx, errorValue) after JS_Throw()
+      return JS_EXCEPTION;
+    }
+
+    return call.returnValue;
+  }
+
+  int registerFunction(JsBridgeNativeContext *nativeCtx, const char *objectName, const char *name,
+                       JsBridgeNativeFunction function, int argCount, void *userData,
+                       JsBridgeNativeFinalizer finalizer) {
+    JsBridgeContext *jsBridgeContext = nativeCtx->jsBridgeContext;
+    JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+    if (name == nullptr || function == nullptr) {
+      return -1;
+    }
+
+    JSValue globalObj = JS_GetGlobalObject(ctx);
+    JSValue targetObj = JS_DupValue(ctx, globalObj);
+    if (objectName != nullptr) {
+      JS_FreeValue(ctx, targetObj);
+      targetObj = JS_GetPropertyStr(ctx, globalObj, objectName);
+      if (JS_IsUndefined(targetObj)) {
+        targetObj = JS_NewObject(ctx);
+        JS_SetPropertyStr(ctx, globalObj, objectName, JS_DupValue(ctx, targetObj));
+      } else if (!JS_IsObject(targetObj)) {
+        JS_FreeValue(ctx, targetObj);
+        JS_FreeValue(ctx, globalObj);
+        return -1;
+      }
+    }
+    JS_FreeValue(ctx, globalObj);
+
+    auto payload = new NativeFunctionPayload(function, userData, finalizer);
+    JSValue payloadValue = jsBridgeContext->getUtils()->createCppPtrValue<NativeFunctionPayload>(payload, true);
+    JSValue functionValue = JS_NewCFunctionData(ctx, callNativeFunction, argCount, 0, 1, &payloadValue);
+    JS_FreeValue(ctx, payloadValue);
+
+    JS_SetPropertyStr(ctx, targetObj, name, functionValue);
+    // No JS_FreeValue(ctx, functionValue) after JS_SetPropertyStr()
+    JS_FreeValue(ctx, targetObj);
+    return 0;
+  }
+
+  JsBridgeNativeType getArgType(const JsBridgeNativeCall *call, int index) {
+    if (!isValidArg(call, index)) {
+      return JSBRIDGE_NATIVE_TYPE_UNDEFINED;
+    }
+
+    JSValueConst v = call->argv[index];
+    if (JS_IsNull(v)) {
+      return JSBRIDGE_NATIVE_TYPE_NULL;
+    }
+    if (JS_IsBool(v)) {
+      return JSBRIDGE_NATIVE_TYPE_BOOLEAN;
+    }
+    if (JS_IsNumber(v)) {
+      return JSBRIDGE_NATIVE_TYPE_NUMBER;
+    }
+    if (JS_IsString(v)) {
+      return JSBRIDGE_NATIVE_TYPE_STRING;
+    }
+    if (JS_IsFunction(call->ctx, v)) {
+      return JSBRIDGE_NATIVE_TYPE_FUNCTION;
+    }
+    if (JS_IsObject(v)) {
+      size_t byteLength = 0;
+      return getBufferData(call->ctx, v, &byteLength) != nullptr ? JSBRIDGE_NATIVE_TYPE_BUFFER : JSBRIDGE_NATIVE_TYPE_OBJECT;
+    }
+    return JSBRIDGE_NATIVE_TYPE_UNDEFINED;
+  }
+
+  int getBool(const JsBridgeNativeCall *call, int index) {
+    return isValidArg(call, index) && JS_ToBool(call->ctx, call->argv[index]) > 0 ? 1 : 0;
+  }
+
+  double getDouble(const JsBridgeNativeCall *call, int index) {
+    double d = 0.0;
+    if (!isValidArg(call, index) || !JS_IsNumber(call->argv[index])) {
+      return d;
+    }
+
+    JS_ToFloat64(call->ctx, &d, call->argv[index]);
+    return d;
+  }
+
+  int32_t getInt32(const JsBridgeNativeCall *call, int index) {
+    int32_t i = 0;
+    if (!isValidArg(call, index) || !JS_IsNumber(call->argv[index])) {
+      return i;
+    }
+
+    JS_ToInt32(call->ctx, &i, call->argv[index]);
+    return i;
+  }
+
+  const char *getString(JsBridgeNativeCall *call, int index, size_t *length) {
+    if (!isValidArg(call, index) || !JS_IsString(call->argv[index])) {
+      return nullptr;
+    }
+
+    size_t size = 0;
+    const char *s = JS_ToCStringLen(call->ctx, &size, call->argv[index]);
+    if (s == nullptr) {
+      JS_FreeValue(call->ctx, JS_GetException(call->ctx));
+      return nullptr;
+    }
+
+    call->cStrings.push_back(s);
+    if (length != nullptr) {
+      *length = size;
+    }
+    return s;
+  }
+
+  void *getBuffer(const JsBridgeNativeCall *call, int index, size_t *byteLength) {
+    if (!isValidArg(call, index)) {
+      return nullptr;
+    }
+
+    size_t size = 0;
+    uint8_t *data = getBufferData(call->ctx, call->argv[index], &size);
+    if (data != nullptr && byteLength != nullptr) {
+      *byteLength = size;
+    }
+    return data;
+  }
+
+  void returnUndefined(JsBridgeNativeCall *call) {
+    setReturnValue(call, JS_UNDEFINED);
+  }
+
+  void returnNull(JsBridgeNativeCall *call) {
+    setReturnValue(call, JS_NULL);
+  }
+
+  void returnBool(JsBridgeNativeCall *call, int value) {
+    setReturnValue(call, JS_NewBool(call->ctx, value != 0));
+  }
+
+  void returnDouble(JsBridgeNativeCall *call, double value) {
+    setReturnValue(call, JS_NewFloat64(call->ctx, value));
+  }
+
+  void returnInt32(JsBridgeNativeCall *call, int32_t value) {
+    setReturnValue(call, JS_NewInt32(call->ctx, value));
+  }
+
+  void returnString(JsBridgeNativeCall *call, const char *value, size_t length) {
+    setReturnValue(call, JS_NewStringLen(call->ctx, value, length));
+  }
+
+  void returnArrayBuffer(JsBridgeNativeCall *call, const void *data, size_t byteLength) {
+    setReturnValue(call, JS_NewArrayBufferCopy(call->ctx, static_cast<const uint8_t *>(data), byteLength));
+  }
+}
+
+#endif
+
+namespace {
+  int getArgCount(const JsBridgeNativeCall *call) {
+#if defined(DUKTAPE)
+    return call->argCount;
+#elif defined(QUICKJS)
+    return call->argc;
+#endif
+  }
+
+  void throwError(JsBridgeNativeCall *call, const char *message) {
+    call->hasError = true;
+    call->errorMessage = message != nullptr ? message : "";
+  }
+}
+
+// static
+const JsBridgeNativeApi NativeExtensions::api = {
+    JSBRIDGE_NATIVE_API_VERSION,
+    registerFunction,
+    getArgCount,
+    getArgType,
+    getBool,
+    getDouble,
+    getInt32,
+    getString,
+    getBuffer,
+    returnUndefined,
+    returnNull,
+    returnBool,
+    returnDouble,
+    returnInt32,
+    returnString,
+    returnArrayBuffer,
+    throwError
+};
+
+// static
+void NativeExtensions::load(JsBridgeContext *jsBridgeContext, const std::string &strLibraryName, const std::string &strEntryPoint) {
+  // The library has already been loaded via System.loadLibrary(): this only gets its handle.
+  // It is never closed because the JS context may still reference its functions.
+  void *handle = dlopen(strLibraryName.c_str(), RTLD_NOW);
+  if (handle == nullptr) {
+    const char *error = dlerror();
+    throw std::runtime_error("Cannot open native extension " + strLibraryName + ": " + (error ? error : "unknown error"));
+  }
+
+  auto init = reinterpret_cast<JsBridgeNativeExtensionInit>(dlsym(handle, strEntryPoint.c_str()));
+  if (init == nullptr) {
+    throw std::runtime_error("Cannot find entry point " + strEntryPoint + " in native extension " + strLibraryName);
+  }
+
+  JsBridgeNativeContext nativeContext { jsBridgeContext };
+  int ret = init(&api, &nativeContext);
+  if (ret != 0) {
+    throw std::runtime_error("Native extension " + strLibraryName + " could not be initialized (error " + std::to_string(ret) + ")");
+  }
+
+  alog("Native extension %s initialized", strLibraryName.c_str());
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_EXTENSIONS_NATIVEEXTENSIONS_H
+#define _JSBRIDGE_EXTENSIONS_NATIVEEXTENSIONS_H
+
+#include "jsbridge_native_extension.h"
+#include <string>
+
+class JsBridgeContext;
+
+// Implementation of the C API of jsbridge_native_extension.h for the current JS engine
+class NativeExtensions {
+public:
+  NativeExtensions() = delete;
+  ~NativeExtensions() = delete;
+
+  static const JsBridgeNativeApi api;
+
+  // Open the given (already loaded) shared library and call its entry point which registers
+  // its native functions into the JS context
+  static void load(JsBridgeContext *, const std::string &strLibraryName, const std::string &strEntryPoint);
+};
+
+#endif
@@ -0,0 +1,625 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "TypedArrayKernels.h"
+
+#include "ExceptionHandler.h"
+#include "JsBridgeContext.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define KERNELS_USE_NEON
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+# define KERNELS_USE_SSE2
+#endif
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#endif
+
+namespace {
+  const double NaN = std::numeric_limits<double>::quiet_NaN();
+  const double Infinity = std::numeric_limits<double>::infinity();
+
+  // Float64 kernels (SIMD)
+  // ---
+
+#if defined(KERNELS_USE_SSE2)
+  inline double horizontalSum(__m128d v) {
+    return _mm_cvtsd_f64(v) + _mm_cvtsd_f64(_mm_unpackhi_pd(v, v));
+  }
+#endif
+
+  double sumFloat64(const double *p, size_t count) {
+    size_t i = 0;
+    double ret = 0.0;
+
+#if defined(KERNELS_USE_NEON)
+    float64x2_t acc0 = vdupq_n_f64(0.0), acc1 = vdupq_n_f64(0.0);
+    for (; i + 4 <= count; i += 4) {
+      acc0 = vaddq_f64(acc0, vld1q_f64(p + i));
+      acc1 = vaddq_f64(acc1, vld1q_f64(p + i + 2));
+    }
+    ret = vaddvq_f64(vaddq_f64(acc0, acc1));
+#elif defined(KERNELS_USE_SSE2)
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+      acc0 = _mm_add_pd(acc0, _mm_loadu_pd(p + i));
+      acc1 = _mm_add_pd(acc1, _mm_loadu_pd(p + i + 2));
+    }
+    ret = horizontalSum(_mm_add_pd(acc0, acc1));
+#endif
+
+    for (; i < count; ++i) {
+      ret += p[i];
+    }
+    return ret;
+  }
+
+  double dotFloat64(const double *a, const double *b, size_t count) {
+    size_t i = 0;
+    double ret = 0.0;
+
+#if defined(KERNELS_USE_NEON)
+    float64x2_t acc0 = vdupq_n_f64(0.0), acc1 = vdupq_n_f64(0.0);
+    for (; i + 4 <= count; i += 4) {
+      acc0 = vfmaq_f64(acc0, vld1q_f64(a + i), vld1q_f64(b + i));
+      acc1 = vfmaq_f64(acc1, vld1q_f64(a + i + 2), vld1q_f64(b + i + 2));
+    }
+    ret = vaddvq_f64(vaddq_f64(acc0, acc1));
+#elif defined(KERNELS_USE_SSE2)
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+      acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+      acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    ret = horizontalSum(_mm_add_pd(acc0, acc1));
+#endif
+
+    for (; i < count; ++i) {
+      ret += a[i] * b[i];
+    }
+    return ret;
+  }
+
+  // Same semantics as Math.min()/Math.max(): NaN if any of the values is NaN
+  template <bool IS_MIN>
+  double minMaxFloat64(const double *p, size_t count) {
+    size_t i = 0;
+    double ret = IS_MIN ? Infinity : -Infinity;
+
+#if defined(KERNELS_USE_NEON)
+    if (count >= 2) {
+      // Note: FMIN/FMAX propagate NaN
+      float64x2_t acc = vld1q_f64(p);
+      for (i = 2; i + 2 <= count; i += 2) {
+        float64x2_t v = vld1q_f64(p + i);
+        acc = IS_MIN ? vminq_f64(acc, v) : vmaxq_f64(acc, v);
+      }
+      ret = IS_MIN ? vminvq_f64(acc) : vmaxvq_f64(acc);
+      if (std::isnan(ret)) return NaN;
+    }
+#elif defined(KERNELS_USE_SSE2)
+    if (count >= 2) {
+      // Note: MINPD/MAXPD do not propagate NaN so we keep track of unordered values separately
+      __m128d acc = _mm_loadu_pd(p);
+      __m128d nanMask = _mm_cmpunord_pd(acc, acc);
+      for (i = 2; i + 2 <= count; i += 2) {
+        __m128d v = _mm_loadu_pd(p + i);
+        nanMask = _mm_or_pd(nanMask, _mm_cmpunord_pd(v, v));
+        acc = IS_MIN ? _mm_min_pd(acc, v) : _mm_max_pd(acc, v);
+      }
+      if (_mm_movemask_pd(nanMask) != 0) return NaN;
+
+      double lanes[2];
+      _mm_storeu_pd(lanes, acc);
+      ret = IS_MIN ? std::min(lanes[0], lanes[1]) : std::max(lanes[0], lanes[1]);
+    }
+#endif
+
+    for (; i < count; ++i) {
+      const double v = p[i];
+      if (std::isnan(v)) return NaN;
+      ret = IS_MIN ? std::min(ret, v) : std::max(ret, v);
+    }
+    return ret;
+  }
+
+  void scaleFloat64(double *p, size_t count, double factor) {
+    size_t i = 0;
+
+#if defined(KERNELS_USE_NEON)
+    for (; i + 2 <= count; i += 2) {
+      vst1q_f64(p + i, vmulq_n_f64(vld1q_f64(p + i), factor));
+    }
+#elif defined(KERNELS_USE_SSE2)
+    const __m128d f = _mm_set1_pd(factor);
+    for (; i + 2 <= count; i += 2) {
+      _mm_storeu_pd(p + i, _mm_mul_pd(_mm_loadu_pd(p + i), f));
+    }
+#endif
+
+    for (; i < count; ++i) {
+      p[i] *= factor;
+    }
+  }
+
+
+  // Generic kernels (auto-vectorized)
+  // ---
+
+  template <typename T, typename A>
+  double sumGeneric(const T *p, size_t count) {
+    A s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      s0 += p[i];
+      s1 += p[i + 1];
+      s2 += p[i + 2];
+      s3 += p[i + 3];
+    }
+    for (; i < count; ++i) {
+      s0 += p[i];
+    }
+    return static_cast<double>((s0 + s1) + (s2 + s3));
+  }
+
+  template <typename T, typename A>
+  double dotGeneric(const T *a, const T *b, size_t count) {
+    A ret = 0;
+    for (size_t i = 0; i < count; ++i) {
+      ret += static_cast<A>(a[i]) * static_cast<A>(b[i]);
+    }
+    return static_cast<double>(ret);
+  }
+
+  template <bool IS_MIN>
+  double minMaxFloat32(const float *p, size_t count) {
+    float ret = IS_MIN ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+    bool hasNaN = false;
+    for (size_t i = 0; i < count; ++i) {
+      hasNaN |= std::isnan(p[i]);
+      ret = IS_MIN ? std::min(ret, p[i]) : std::max(ret, p[i]);
+    }
+    return hasNaN ? NaN : ret;
+  }
+
+  template <bool IS_MIN>
+  double minMaxInt32(const int32_t *p, size_t count) {
+    if (count == 0) return IS_MIN ? Infinity : -Infinity;
+
+    int32_t ret = p[0];
+    for (size_t i = 1; i < count; ++i) {
+      ret = IS_MIN ? std::min(ret, p[i]) : std::max(ret, p[i]);
+    }
+    return ret;
+  }
+
+  // ECMAScript ToInt32()
+  inline int32_t toInt32(double d) {
+    if (!std::isfinite(d)) return 0;
+
+    double m = std::fmod(std::trunc(d), 4294967296.0);
+    if (m < 0) m += 4294967296.0;
+    return static_cast<int32_t>(static_cast<uint32_t>(m));
+  }
+
+  template <typename T>
+  void histogramGeneric(const T *p, size_t count, double min, double max, int32_t *bins, size_t binCount) {
+    const double factor = static_cast<double>(binCount) / (max - min);
+    for (size_t i = 0; i < count; ++i) {
+      const double v = p[i];
+      if (!(v >= min && v <= max)) continue;  // also skips NaN
+
+      auto bin = static_cast<size_t>((v - min) * factor);
+      if (bin >= binCount) bin = binCount - 1;
+      ++bins[bin];
+    }
+  }
+
+  // Same order as TypedArray.prototype.sort(): -0 before +0, NaN at the end
+  template <typename T>
+  void sortFloat(T *p, size_t count) {
+    T *end = std::partition(p, p + count, [](T v) { return !std::isnan(v); });
+    std::sort(p, end, [](T a, T b) {
+      return a < b || (a == b && std::signbit(a) && !std::signbit(b));
+    });
+  }
+
+  TypedArrayKernels::ElementType toElementType(int32_t typeCode) {
+    switch (typeCode) {
+      case static_cast<int32_t>(TypedArrayKernels::ElementType::Float64):
+      case static_cast<int32_t>(TypedArrayKernels::ElementType::Float32):
+      case static_cast<int32_t>(TypedArrayKernels::ElementType::Int32):
+        return static_cast<TypedArrayKernels::ElementType>(typeCode);
+      default:
+        throw std::invalid_argument("Unsupported typed array type");
+    }
+  }
+}
+
+
+// Kernels
+// ---
+
+size_t TypedArrayKernels::elementSize(ElementType type) {
+  switch (type) {
+    case ElementType::Float64: return sizeof(double);
+    case ElementType::Float32: return sizeof(float);
+    case ElementType::Int32: return sizeof(int32_t);
+  }
+  return 1;
+}
+
+double TypedArrayKernels::sum(const View &view) {
+  switch (view.type) {
+    case ElementType::Float64: return sumFloat64(static_cast<const double *>(view.data), view.count);
+    case ElementType::Float32: return sumGeneric<float, double>(static_cast<const float *>(view.data), view.count);
+    case ElementType::Int32: return sumGeneric<int32_t, int64_t>(static_cast<const int32_t *>(view.data), view.count);
+  }
+  return NaN;
+}
+
+double TypedArrayKernels::min(const View &view) {
+  switch (view.type) {
+    case ElementType::Float64: return minMaxFloat64<true>(static_cast<const double *>(view.data), view.count);
+    case ElementType::Float32: return minMaxFloat32<true>(static_cast<const float *>(view.data), view.count);
+    case ElementType::Int32: return minMaxInt32<true>(static_cast<const int32_t *>(view.data), view.count);
+  }
+  return NaN;
+}
+
+double TypedArrayKernels::max(const View &view) {
+  switch (view.type) {
+    case ElementType::Float64: return minMaxFloat64<false>(static_cast<const double *>(view.data), view.count);
+    case ElementType::Float32: return minMaxFloat32<false>(static_cast<const float *>(view.data), view.count);
+    case ElementType::Int32: return minMaxInt32<false>(static_cast<const int32_t *>(view.data), view.count);
+  }
+  return NaN;
+}
+
+double TypedArrayKernels::dot(const View &a, const View &b) {
+  if (a.type != b.type || a.count != b.count) {
+    throw std::invalid_argument("dot() expects two typed arrays with the same type and length");
+  }
+
+  switch (a.type) {
+    case ElementType::Float64: return dotFloat64(static_cast<const double *>(a.data), static_cast<const double *>(b.data), a.count);
+    case ElementType::Float32: return dotGeneric<float, double>(static_cast<const float *>(a.data), static_cast<const float *>(b.data), a.count);
+    case ElementType::Int32: return dotGeneric<int32_t, double>(static_cast<const int32_t *>(a.data), static_cast<const int32_t *>(b.data), a.count);
+  }
+  return NaN;
+}
+
+void TypedArrayKernels::scale(const View &view, double factor) {
+  switch (view.type) {
+    case ElementType::Float64:
+      scaleFloat64(static_cast<double *>(view.data), view.count, factor);
+      break;
+    case ElementType::Float32: {
+      auto p = static_cast<float *>(view.data);
+      for (size_t i = 0; i < view.count; ++i) {
+        p[i] = static_cast<float>(p[i] * factor);
+      }
+      break;
+    }
+    case ElementType::Int32: {
+      auto p = static_cast<int32_t *>(view.data);
+      for (size_t i = 0; i < view.count; ++i) {
+        p[i] = toInt32(p[i] * factor);
+      }
+      break;
+    }
+  }
+}
+
+void TypedArrayKernels::histogram(const View &view, double min, double max, int32_t *bins, size_t binCount) {
+  if (!(max > min)) {
+    throw std::invalid_argument("histogram() expects max > min");
+  }
+
+  if (binCount == 0) {
+    return;
+  }
+
+  switch (view.type) {
+    case ElementType::Float64:
+      histogramGeneric(static_cast<const double *>(view.data), view.count, min, max, bins, binCount);
+      break;
+    case ElementType::Float32:
+      histogramGeneric(static_cast<const float *>(view.data), view.count, min, max, bins, binCount);
+      break;
+    case ElementType::Int32:
+      histogramGeneric(static_cast<const int32_t *>(view.data), view.count, min, max, bins, binCount);
+      break;
+  }
+}
+
+void TypedArrayKernels::sort(const View &view) {
+  switch (view.type) {
+    case ElementType::Float64:
+      sortFloat(static_cast<double *>(view.data), view.count);
+      break;
+    case ElementType::Float32:
+      sortFloat(static_cast<float *>(view.data), view.count);
+      break;
+    case ElementType::Int32: {
+      auto p = static_cast<int32_t *>(view.data);
+      std::sort(p, p + view.count);
+      break;
+    }
+  }
+}
+
+
+// JS bindings
+// ---
+
+#if defined(DUKTAPE)
+
+namespace {
+  TypedArrayKernels::View getView(duk_context *ctx, duk_idx_t typeIdx, duk_idx_t arrayIdx) {
+    if (!duk_is_number(ctx, typeIdx)) {
+      throw std::invalid_argument("Unsupported typed array type");
+    }
+    const auto type = toElementType(duk_get_int(ctx, typeIdx));
+
+    if (!duk_is_buffer_data(ctx, arrayIdx)) {
+      throw std::invalid_argument("Expected a typed array");
+    }
+
+    duk_size_t size = 0;
+    void *data = duk_get_buffer_data(ctx, arrayIdx, &size);
+
+    // The element size must match (as checked with QuickJS) and the view must be aligned (which is
+    // not the case of e.g. an Uint8Array with an odd offset)
+    const size_t elementSize = TypedArrayKernels::elementSize(type);
+    duk_get_prop_string(ctx, arrayIdx, "BYTES_PER_ELEMENT");
+    const bool isElementSizeMatching = duk_is_number(ctx, -1) && duk_get_uint(ctx, -1) == elementSize;
+    duk_pop(ctx);
+    if (!isElementSizeMatching || size % elementSize != 0 || reinterpret_cast<uintptr_t>(data) % elementSize != 0) {
+      throw std::invalid_argument("Typed array type mismatch");
+    }
+
+    return { type, data, size / elementSize };
+  }
+
+  double getNumber(duk_context *ctx, duk_idx_t idx) {
+    if (!duk_is_number(ctx, idx)) {
+      throw std::invalid_argument("Expected a number");
+    }
+    return duk_get_number(ctx, idx);
+  }
+
+  template <typename F>
+  duk_ret_t callKernel(duk_context *ctx, F &&f) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    assert(jsBridgeContext != nullptr);
+
+    try {
+      return f();
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return DUK_RET_ERROR;
+    }
+  }
+
+  extern "C" {
+    duk_ret_t kernelSum(duk_context *ctx) {
+      return callKernel(ctx, [ctx]() {
+        duk_push_number(ctx, TypedArrayKernels::sum(getView(ctx, 0, 1)));
+        return 1;
+      });
+    }
+
+    duk_ret_t kernelMin(duk_context *ctx) {
+      return callKernel(ctx, [ctx]() {
+        duk_push_number(ctx, TypedArrayKernels::min(getView(ctx, 0, 1)));
+        return 1;
+      });
+    }
+
+    duk_ret_t kernelMax(duk_context *ctx) {
+      return callKernel(ctx, [ctx]() {
+        duk_push_number(ctx, TypedArrayKernels::max(getView(ctx, 0, 1)));
+        return 1;
+      });
+    }
+
+    duk_ret_t kernelDot(duk_context *ctx) {
+      return callKernel(ctx, [ctx]() {
+        duk_push_number(ctx, TypedArrayKernels::dot(getView(ctx, 0, 1), getView(ctx, 0, 2)));
+        return 1;
+      });
+    }
+
+    duk_ret_t kernelScale(duk_context *ctx) {
+      return callKernel(ctx, [ctx]() {
+        TypedArrayKernels::scale(getView(ctx, 0, 1), getNumber(ctx, 2));
+        return 0;
+      });
+    }
+
+    duk_ret_t kernelHistogram(duk_context *ctx) {
+      return callKernel(ctx, [ctx]() {
+        duk_push_int(ctx, static_cast<duk_int_t>(TypedArrayKernels::ElementType::Int32));
+        auto bins = getView(ctx, -1, 2);
+        duk_pop(ctx);
+
+        TypedArrayKernels::histogram(getView(ctx, 0, 1), getNumber(ctx, 3), getNumber(ctx, 4), static_cast<int32_t *>(bins.data), bins.count);
+        return 0;
+      });
+    }
+
+    duk_ret_t kernelSort(duk_context *ctx) {
+      return callKernel(ctx, [ctx]() {
+        TypedArrayKernels::sort(getView(ctx, 0, 1));
+        return 0;
+      });
+    }
+  }  // extern "C"
+
+  const duk_function_list_entry kernelFunctions[] = {
+      { "sum", kernelSum, 2 },
+      { "min", kernelMin, 2 },
+      { "max", kernelMax, 2 },
+      { "dot", kernelDot, 3 },
+      { "scale", kernelScale, 3 },
+      { "histogram", kernelHistogram, 5 },
+      { "sort", kernelSort, 2 },
+      { nullptr, nullptr, 0 }
+  };
+}
+
+void TypedArrayKernels::registerGlobal(const JsBridgeContext *jsBridgeContext, const std::string &strName) {
+  duk_context *ctx = jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  duk_push_global_object(ctx);
+  duk_push_object(ctx);
+  duk_put_function_list(ctx, -1, kernelFunctions);
+  duk_put_prop_string(ctx, -2, strName.c_str());
+  duk_pop(ctx);  // global object
+}
+
+#elif defined(QUICKJS)
+
+namespace {
+  TypedArrayKernels::View getView(JSContext *ctx, JSValueConst typeValue, JSValueConst arrayValue) {
+    if (JS_VALUE_GET_TAG(typeValue) != JS_TAG_INT) {
+      throw std::invalid_argument("Unsupported typed array type");
+    }
+    const auto type = toElementType(JS_VALUE_GET_INT(typeValue));
+
+    size_t byteOffset = 0, byteLength = 0, bytesPerElement = 0;
+    JSValue arrayBuffer = JS_GetTypedArrayBuffer(ctx, arrayValue, &byteOffset, &byteLength, &bytesPerElement);
+    if (JS_IsException(arrayBuffer)) {
+      JS_FreeValue(ctx, JS_GetException(ctx));  // not a typed array
+      throw std::invalid_argument("Expected a typed array");
+    }
+
+    size_t size = 0;
+    uint8_t *buffer = JS_GetArrayBuffer(ctx, &size, arrayBuffer);
+    JS_FreeValue(ctx, arrayBuffer);  // still referenced by the typed array
+    if (buffer == nullptr) {
+      JS_FreeValue(ctx, JS_GetException(ctx));  // detached buffer
+      throw std::invalid_argument("Cannot use a typed array with a detached buffer");
+    }
+
+    if (bytesPerElement != TypedArrayKernels::elementSize(type)) {
+      throw std::invalid_argument("Typed array type mismatch");
+    }
+
+    return { type, buffer + byteOffset, byteLength / bytesPerElement };
+  }
+
+  double getNumber(JSContext *ctx, JSValueConst v) {
+    double d;
+    if (!JS_IsNumber(v) || JS_ToFloat64(ctx, &d, v) != 0) {
+      throw std::invalid_argument("Expected a number");
+    }
+    return d;
+  }
+
+  template <typename F>
+  JSValue callKernel(JSContext *ctx, F &&f) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    assert(jsBridgeContext != nullptr);
+
+    try {
+      return f();
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return JS_EXCEPTION;
+    }
+  }
+
+  JSValue kernelSum(JSContext *ctx, JSValueConst, int, JSValueConst *argv) {
+    return callKernel(ctx, [=]() {
+      return JS_NewFloat64(ctx, TypedArrayKernels::sum(getView(ctx, argv[0], argv[1])));
+    });
+  }
+
+  JSValue kernelMin(JSContext *ctx, JSValueConst, int, JSValueConst *argv) {
+    return callKernel(ctx, [=]() {
+      return JS_NewFloat64(ctx, TypedArrayKernels::min(getView(ctx, argv[0], argv[1])));
+    });
+  }
+
+  JSValue kernelMax(JSContext *ctx, JSValueConst, int, JSValueConst *argv) {
+    return callKernel(ctx, [=]() {
+      return JS_NewFloat64(ctx, TypedArrayKernels::max(getView(ctx, argv[0], argv[1])));
+    });
+  }
+
+  JSValue kernelDot(JSContext *ctx, JSValueConst, int, JSValueConst *argv) {
+    return callKernel(ctx, [=]() {
+      return JS_NewFloat64(ctx, TypedArrayKernels::dot(getView(ctx, argv[0], argv[1]), getView(ctx, argv[0], argv[2])));
+    });
+  }
+
+  JSValue kernelScale(JSContext *ctx, JSValueConst, int, JSValueConst *argv) {
+    return callKernel(ctx, [=]() {
+      TypedArrayKernels::scale(getView(ctx, argv[0], argv[1]), getNumber(ctx, argv[2]));
+      return JS_UNDEFINED;
+    });
+  }
+
+  JSValue kernelHistogram(JSContext *ctx, JSValueConst, int, JSValueConst *argv) {
+    return callKernel(ctx, [=]() {
+      JSValue binsType = JS_NewInt32(ctx, static_cast<int32_t>(TypedArrayKernels::ElementType::Int32));
+      auto bins = getView(ctx, binsType, argv[2]);
+
+      TypedArrayKernels::histogram(getView(ctx, argv[0], argv[1]), getNumber(ctx, argv[3]), getNumber(ctx, argv[4]), static_cast<int32_t *>(bins.data), bins.count);
+      return JS_UNDEFINED;
+    });
+  }
+
+  JSValue kernelSort(JSContext *ctx, JSValueConst, int, JSValueConst *argv) {
+    return callKernel(ctx, [=]() {
+      TypedArrayKernels::sort(getView(ctx, argv[0], argv[1]));
+      return JS_UNDEFINED;
+    });
+  }
+
+  const JSCFunctionListEntry kernelFunctions[] = {
+      JS_CFUNC_DEF("sum", 2, kernelSum),
+      JS_CFUNC_DEF("min", 2, kernelMin),
+      JS_CFUNC_DEF("max", 2, kernelMax),
+      JS_CFUNC_DEF("dot", 3, kernelDot),
+      JS_CFUNC_DEF("scale", 3, kernelScale),
+      JS_CFUNC_DEF("histogram", 5, kernelHistogram),
+      JS_CFUNC_DEF("sort", 2, kernelSort),
+  };
+}
+
+void TypedArrayKernels::registerGlobal(const JsBridgeContext *jsBridgeContext, const std::string &strName) {
+  JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+  JSValue kernelsObj = JS_NewObject(ctx);
+  JS_SetPropertyFunctionList(ctx, kernelsObj, kernelFunctions, sizeof(kernelFunctions) / sizeof(kernelFunctions[0]));
+
+  JSValue globalObj = JS_GetGlobalObject(ctx);
+  JS_SetPropertyStr(ctx, globalObj, strName.c_str(), kernelsObj);
+  // No JS_FreeValue(ctx, kernelsObj) after JS_SetPropertyStr()
+  JS_FreeValue(ctx, globalObj);
+}
+
+#endif
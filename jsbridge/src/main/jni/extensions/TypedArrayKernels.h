@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_EXTENSIONS_TYPEDARRAYKERNELS_H
+#define _JSBRIDGE_EXTENSIONS_TYPEDARRAYKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class JsBridgeContext;
+
+// Native kernels (reductions, transforms, sort) working in place on the memory of JS typed
+// arrays. Float64 kernels use SSE2 (x86) or NEON (arm64) when available, other element types
+// rely on compiler auto-vectorization.
+class TypedArrayKernels {
+public:
+  // Must match the type codes used by the JS code of TypedArrayKernelsExtension
+  enum class ElementType {
+    Float64 = 0,
+    Float32 = 1,
+    Int32 = 2,
+  };
+
+  struct View {
+    ElementType type;
+    void *data;
+    size_t count;
+  };
+
+  TypedArrayKernels() = delete;
+  ~TypedArrayKernels() = delete;
+
+  static size_t elementSize(ElementType);
+
+  static double sum(const View &);
+  static double min(const View &);
+  static double max(const View &);
+  static double dot(const View &, const View &);
+  static void scale(const View &, double factor);
+  static void histogram(const View &, double min, double max, int32_t *bins, size_t binCount);
+  static void sort(const View &);
+
+  // Create a global JS object with the native kernel functions
+  static void registerGlobal(const JsBridgeContext *, const std::string &strName);
+};
+
+#endif
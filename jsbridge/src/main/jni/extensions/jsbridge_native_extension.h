@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_NATIVE_EXTENSION_H
+#define _JSBRIDGE_NATIVE_EXTENSION_H
+
+// Stable C API to register native functions into a JsBridge JS context without going through JNI.
+//
+// This header is self-contained and can be copied into the host app. The host app does not link
+// against the JsBridge library: all the functions are given via the JsBridgeNativeApi table
+// passed to the entry point.
+//
+// Usage (host app library "libmyextension.so"):
+//
+// static void add(JsBridgeNativeCall *call, void *userData) {
+//   const JsBridgeNativeApi *api = (const JsBridgeNativeApi *) userData;
+//   api->returnDouble(call, api->getDouble(call, 0) + api->getDouble(call, 1));
+// }
+//
+// JSBRIDGE_NATIVE_EXPORT int JsBridge_initNativeExtension(const JsBridgeNativeApi *api, JsBridgeNativeContext *ctx) {
+//   if (api->version < JSBRIDGE_NATIVE_API_VERSION) return -1;
+//   return api->registerFunction(ctx, "myMath", "add", add, 2, (void *) api, NULL);
+// }
+//
+// Kotlin:
+// jsBridge.registerNativeExtension("myextension")
+// jsBridge.evaluate<Double>("myMath.add(1, 2)")
+//
+// Notes:
+// - all the functions must be called in the JS thread
+// - the JsBridgeNativeContext is only valid inside the entry point
+// - the JsBridgeNativeCall is only valid inside the native function call
+// - strings are UTF-8 encoded (CESU-8 with Duktape)
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSBRIDGE_NATIVE_API_VERSION 1
+#define JSBRIDGE_NATIVE_EXPORT __attribute__((visibility("default")))
+
+typedef struct JsBridgeNativeContext JsBridgeNativeContext;
+typedef struct JsBridgeNativeCall JsBridgeNativeCall;
+
+typedef enum {
+  JSBRIDGE_NATIVE_TYPE_UNDEFINED = 0,
+  JSBRIDGE_NATIVE_TYPE_NULL = 1,
+  JSBRIDGE_NATIVE_TYPE_BOOLEAN = 2,
+  JSBRIDGE_NATIVE_TYPE_NUMBER = 3,
+  JSBRIDGE_NATIVE_TYPE_STRING = 4,
+  JSBRIDGE_NATIVE_TYPE_BUFFER = 5,  // ArrayBuffer or typed array
+  JSBRIDGE_NATIVE_TYPE_FUNCTION = 6,
+  JSBRIDGE_NATIVE_TYPE_OBJECT = 7,
+} JsBridgeNativeType;
+
+// Native function implementation. If none of the return*() functions is called, the JS function
+// returns undefined.
+typedef void (*JsBridgeNativeFunction)(JsBridgeNativeCall *call, void *userData);
+
+// Called when the JS function is garbage-collected (or when the JS context is released)
+typedef void (*JsBridgeNativeFinalizer)(void *userData);
+
+typedef struct JsBridgeNativeApi {
+  // JSBRIDGE_NATIVE_API_VERSION of the JsBridge library. Functions are only appended in newer
+  // versions.
+  int version;
+
+  // Register a native function as <objectName>.<name> (or as the global <name> if objectName is
+  // NULL). The global object <objectName> is created if it does not exist yet.
+  // Returns 0 on success.
+  int (*registerFunction)(JsBridgeNativeContext *ctx, const char *objectName, const char *name,
+                          JsBridgeNativeFunction function, int argCount, void *userData,
+                          JsBridgeNativeFinalizer finalizer);
+
+  // Arguments
+  int (*getArgCount)(const JsBridgeNativeCall *call);
+  JsBridgeNativeType (*getArgType)(const JsBridgeNativeCall *call, int index);
+  int (*getBool)(const JsBridgeNativeCall *call, int index);
+  double (*getDouble)(const JsBridgeNativeCall *call, int index);
+  int32_t (*getInt32)(const JsBridgeNativeCall *call, int index);
+  // Returns NULL if the argument is not a string. The string is valid until the end of the call.
+  const char *(*getString)(JsBridgeNativeCall *call, int index, size_t *length);
+  // Returns NULL if the argument is not an ArrayBuffer or a typed array. The memory can be
+  // modified in place and is valid until the end of the call.
+  void *(*getBuffer)(const JsBridgeNativeCall *call, int index, size_t *byteLength);
+
+  // Return value
+  void (*returnUndefined)(JsBridgeNativeCall *call);
+  void (*returnNull)(JsBridgeNativeCall *call);
+  void (*returnBool)(JsBridgeNativeCall *call, int value);
+  void (*returnDouble)(JsBridgeNativeCall *call, double value);
+  void (*returnInt32)(JsBridgeNativeCall *call, int32_t value);
+  void (*returnString)(JsBridgeNativeCall *call, const char *value, size_t length);
+  // Return a new ArrayBuffer with a copy of the given data
+  void (*returnArrayBuffer)(JsBridgeNativeCall *call, const void *data, size_t byteLength);
+
+  // Throw a JS Error with the given message after the native function returns
+  void (*throwError)(JsBridgeNativeCall *call, const char *message);
+} JsBridgeNativeApi;
+
+// Signature of the entry point exported by the host library. Returns 0 on success.
+typedef int (*JsBridgeNativeExtensionInit)(const JsBridgeNativeApi *api, JsBridgeNativeContext *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,10 +18,13 @@
  */
 #include "Byte.h"
 
+#include "ExceptionHandler.h"
 #include "JsBridgeContext.h"
 #include "log.h"
 #include "exceptions/JniException.h"
+#include "exceptions/JsException.h"
 #include "jni-helpers/JArrayLocalRef.h"
+#include <cstring>
 
 #if defined(DUKTAPE)
 # include "JsBridgeContext.h"
@@ -55,6 +58,10 @@ JValue Byte::pop() const {
 
 JValue Byte::popArray(uint32_t count, bool expanded) const {
   if (!expanded) {
+    if (duk_is_buffer_data(m_ctx, -1)) {
+      return popBuffer();
+    }
+
     count = static_cast<uint32_t>(duk_get_length(m_ctx, -1));
     if (!duk_is_array(m_ctx, -1)) {
       const auto message = std::string("Cannot convert JS value ") + duk_safe_to_string(m_ctx, -1) + " to Array<Byte>";
@@ -92,6 +99,30 @@ JValue Byte::popArray(uint32_t count, bool expanded) const {
   return JValue(byteArray);
 }
 
+// Bulk copy of a buffer object (ArrayBuffer, Uint8Array, ...) into a Java byte array
+JValue Byte::popBuffer() const {
+  duk_size_t size = 0;
+  const void *buffer = duk_get_buffer_data(m_ctx, -1, &size);
+
+  JArrayLocalRef<jbyte> byteArray(m_jniContext, static_cast<jsize>(size));
+  if (byteArray.isNull()) {
+    duk_pop(m_ctx);  // pop the buffer
+    throw JniException(m_jniContext);
+  }
+
+  jbyte *elements = byteArray.getMutableElements();
+  if (elements == nullptr) {
+    duk_pop(m_ctx);  // pop the buffer
+    throw JniException(m_jniContext);
+  }
+
+  memcpy(elements, buffer, size);
+  duk_pop(m_ctx);  // pop the buffer
+
+  byteArray.releaseArrayElements();  // copy back elements to Java
+  return JValue(byteArray);
+}
+
 duk_ret_t Byte::push(const JValue &value) const {
   duk_push_int(m_ctx, value.getByte());
   return 1;
@@ -109,17 +140,19 @@ duk_ret_t Byte::pushArray(const JniLocalRef<jarray> &values, bool expand) const
   CHECK_STACK_OFFSET(m_ctx, expand ? count : 1);
 
   if (!expand) {
-    duk_push_array(m_ctx);
+    // Bulk copy into a Uint8Array
+    void *buffer = duk_push_fixed_buffer(m_ctx, static_cast<duk_size_t>(count));
+    memcpy(buffer, elements, static_cast<size_t>(count));
+    duk_push_buffer_object(m_ctx, -1, 0, static_cast<duk_size_t>(count), DUK_BUFOBJ_UINT8ARRAY);
+    duk_remove(m_ctx, -2);  // remove the plain buffer
+    return 1;
   }
 
   for (jsize i = 0; i < count; ++i) {
-    duk_push_int(m_ctx, elements[i]);
-    if (!expand) {
-      duk_put_prop_index(m_ctx, -2, static_cast<duk_uarridx_t>(i));
-    }
+    duk_push_uint(m_ctx, static_cast<uint8_t>(elements[i]));
   }
 
-  return expand ? count : 1;
+  return count;
 }
 
 #elif defined(QUICKJS)
@@ -152,10 +185,8 @@ JValue Byte::toJavaArray(JSValueConst v) const {
     return JValue();
   }
 
-  // TODO: if it is an ArrayBuffer...
-
   if (!JS_IsArray(m_ctx, v)) {
-    throw std::invalid_argument("Cannot convert JS value to Java array");
+    return bufferToJavaArray(v);
   }
 
   JSValue lengthValue = JS_GetPropertyStr(m_ctx, v, "length");
@@ -182,6 +213,47 @@ JValue Byte::toJavaArray(JSValueConst v) const {
   return JValue(byteArray);
 }
 
+// Bulk copy of an ArrayBuffer or a typed array (e.g. Uint8Array) into a Java byte array
+JValue Byte::bufferToJavaArray(JSValueConst v) const {
+  size_t size = 0;
+  uint8_t *buffer = JS_GetArrayBuffer(m_ctx, &size, v);
+
+  if (buffer == nullptr) {
+    JS_FreeValue(m_ctx, JS_GetException(m_ctx));  // not an ArrayBuffer
+
+    size_t byteOffset = 0, byteLength = 0;
+    JSValue arrayBuffer = JS_GetTypedArrayBuffer(m_ctx, v, &byteOffset, &byteLength, nullptr);
+    if (JS_IsException(arrayBuffer)) {
+      JS_FreeValue(m_ctx, JS_GetException(m_ctx));  // not a typed array
+      throw std::invalid_argument("Cannot convert JS value to Java array");
+    }
+
+    buffer = JS_GetArrayBuffer(m_ctx, &size, arrayBuffer);
+    JS_FreeValue(m_ctx, arrayBuffer);
+    if (buffer == nullptr) {
+      JS_FreeValue(m_ctx, JS_GetException(m_ctx));  // detached buffer
+      throw std::invalid_argument("Cannot convert detached JS buffer to Java array");
+    }
+
+    buffer += byteOffset;
+    size = byteLength;
+  }
+
+  JArrayLocalRef<jbyte> byteArray(m_jniContext, static_cast<jsize>(size));
+  if (byteArray.isNull()) {
+    throw JniException(m_jniContext);
+  }
+
+  jbyte *elements = byteArray.getMutableElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  memcpy(elements, buffer, size);
+  byteArray.releaseArrayElements();  // copy back elements to Java
+  return JValue(byteArray);
+}
+
 JSValue Byte::fromJava(const JValue &value) const {
   return JS_NewInt32(m_ctx, value.getByte());
 }
@@ -190,17 +262,24 @@ JSValue Byte::fromJavaArray(const JniLocalRef<jarray> &values) const {
   JArrayLocalRef<jbyte> byteArray(values);
   const auto count = byteArray.getLength();
 
-  // TODO: or ByteArray???
-  JSValue jsArray = JS_NewArray(m_ctx);
-
   const jbyte *elements = byteArray.getElements();
   if (elements == nullptr) {
-    JS_FreeValue(m_ctx, jsArray);
     throw JniException(m_jniContext);
   }
 
+  // Bulk copy into a Uint8Array if typed arrays are available (JsBridgeConfig.RuntimeConfig.builtIns)
+  JSValue uint8Array = JS_NewUint8ArrayCopy(m_ctx, reinterpret_cast<const uint8_t *>(elements), static_cast<size_t>(count));
+  if (!JS_IsUndefined(uint8Array)) {
+    byteArray.releaseArrayElements();
+    if (JS_IsException(uint8Array)) {
+      throw getExceptionHandler()->getCurrentJsException();
+    }
+    return uint8Array;
+  }
+
+  JSValue jsArray = JS_NewArray(m_ctx);
   for (jsize i = 0; i < count; ++i) {
-    JSValue elementValue = JS_NewInt32(m_ctx, elements[i]);
+    JSValue elementValue = JS_NewInt32(m_ctx, static_cast<uint8_t>(elements[i]));
     JS_SetPropertyUint32(m_ctx, jsArray, static_cast<uint32_t>(i), elementValue);
   }
 
@@ -48,6 +48,12 @@ public:
   JavaTypeId arrayId() const override { return JavaTypeId::IntArray; }
 
 private:
+#if defined(DUKTAPE)
+  JValue popBuffer() const;
+#elif defined(QUICKJS)
+  JValue bufferToJavaArray(JSValueConst) const;
+#endif
+
   JValue box(const JValue &) const override;
   JValue unbox(const JValue &) const override;
 };
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Enum.h"
+
+#include "JsBridgeContext.h"
+#include "JniCache.h"
+#include "exceptions/JniException.h"
+#include "jni-helpers/JniContext.h"
+#include "jni-helpers/JObjectArrayLocalRef.h"
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#endif
+
+namespace JavaTypes {
+
+EnumTable::EnumTable(const JsBridgeContext *jsBridgeContext, const JniRef<jclass> &enumClass)
+ : m_enumClass(JniLocalRef<jclass>(enumClass))
+#if defined(QUICKJS)
+ , m_ctx(jsBridgeContext->getQuickJsContext())
+ , m_runtime(JS_GetRuntime(m_ctx))
+#endif
+{
+  const JniContext *jniContext = jsBridgeContext->getJniContext();
+  const JniCache *jniCache = jsBridgeContext->getJniCache();
+
+  static thread_local jmethodID getEnumConstantsMethodId = jniContext->getMethodID(jniCache->getJavaClassClass(), "getEnumConstants", "()[Ljava/lang/Object;");
+  static thread_local jmethodID nameMethodId = jniContext->getMethodID(jniCache->getEnumClass(), "name", "()Ljava/lang/String;");
+
+  // Enum constants are returned in ordinal order
+  JObjectArrayLocalRef constants(jniContext->callObjectMethod<jobjectArray>(enumClass, getEnumConstantsMethodId));
+  if (jniContext->exceptionCheck()) {
+    throw JniException(jniContext);
+  }
+  if (constants.isNull()) {
+    throw std::invalid_argument("Cannot get the constants of the Java enum class");
+  }
+
+  const jsize count = constants.getLength();
+  m_constants.reserve(count);
+#if defined(DUKTAPE)
+  m_names.reserve(count);
+#elif defined(QUICKJS)
+  m_atoms.reserve(count);
+#endif
+
+  for (jsize i = 0; i < count; ++i) {
+    JniLocalRef<jobject> constant = constants.getElement(i);
+    JStringLocalRef name = jniContext->callStringMethod(constant, nameMethodId);
+    if (jniContext->exceptionCheck()) {
+      throw JniException(jniContext);
+    }
+
+    m_constants.emplace_back(constant);
+
+#if defined(DUKTAPE)
+    m_names.push_back(name.toStdString());
+#elif defined(QUICKJS)
+    const char *utf8Name = name.toUtf8Chars();
+    JSAtom atom = JS_NewAtomLen(m_ctx, utf8Name, strlen(utf8Name));
+    if (atom == JS_ATOM_NULL) {
+      for (JSAtom a : m_atoms) {
+        JS_FreeAtom(m_ctx, a);
+      }
+      throw std::bad_alloc();
+    }
+    m_atoms.push_back(atom);
+    m_ordinalsByAtom.emplace(atom, i);
+#endif
+  }
+
+#if defined(DUKTAPE)
+  // m_names won't be modified anymore
+  for (jsize i = 0; i < count; ++i) {
+    m_ordinalsByName.emplace(m_names[i], i);
+  }
+#endif
+}
+
+EnumTable::~EnumTable() {
+#if defined(QUICKJS)
+  for (JSAtom atom : m_atoms) {
+    JS_FreeAtomRT(m_runtime, atom);
+  }
+#endif
+}
+
+#if defined(DUKTAPE)
+
+void EnumTable::pushName(duk_context *ctx, jint ordinal) const {
+  if (ordinal < 0 || static_cast<size_t>(ordinal) >= m_names.size()) {
+    throw std::invalid_argument("Invalid Java enum ordinal");
+  }
+
+  const std::string &name = m_names[ordinal];
+  duk_push_lstring(ctx, name.data(), name.size());
+}
+
+const JniGlobalRef<jobject> *EnumTable::getConstant(const char *name, duk_size_t length) const {
+  auto it = m_ordinalsByName.find(std::string_view(name, length));
+  return it == m_ordinalsByName.end() ? nullptr : &m_constants[it->second];
+}
+
+#elif defined(QUICKJS)
+
+JSValue EnumTable::newName(jint ordinal) const {
+  if (ordinal < 0 || static_cast<size_t>(ordinal) >= m_atoms.size()) {
+    throw std::invalid_argument("Invalid Java enum ordinal");
+  }
+
+  return JS_AtomToString(m_ctx, m_atoms[ordinal]);
+}
+
+const JniGlobalRef<jobject> *EnumTable::getConstant(JSValueConst v) const {
+  if (!JS_IsString(v)) {
+    return nullptr;
+  }
+
+  // Strings are converted into existing atoms via a hash lookup
+  JSAtom atom = JS_ValueToAtom(m_ctx, v);
+  if (atom == JS_ATOM_NULL) {
+    JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+    return nullptr;
+  }
+
+  auto it = m_ordinalsByAtom.find(atom);
+  JS_FreeAtom(m_ctx, atom);
+  return it == m_ordinalsByAtom.end() ? nullptr : &m_constants[it->second];
+}
+
+#endif
+
+
+Enum::Enum(const JsBridgeContext *jsBridgeContext, std::shared_ptr<const EnumTable> table)
+ : JavaType(jsBridgeContext, JavaTypeId::Enum)
+ , m_table(std::move(table)) {
+}
+
+#if defined(DUKTAPE)
+
+JValue Enum::pop() const {
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  if (duk_is_null_or_undefined(m_ctx, -1)) {
+    duk_pop(m_ctx);
+    return JValue();
+  }
+
+  const JniGlobalRef<jobject> *constant = nullptr;
+  if (duk_is_string(m_ctx, -1)) {
+    duk_size_t length;
+    const char *name = duk_get_lstring(m_ctx, -1, &length);
+    constant = m_table->getConstant(name, length);
+  }
+
+  if (constant == nullptr) {
+    const auto message = std::string("Cannot convert JS value ") + duk_safe_to_string(m_ctx, -1) + " to a Java enum constant";
+    duk_pop(m_ctx);
+    throw std::invalid_argument(message);
+  }
+
+  duk_pop(m_ctx);
+  return JValue(JniLocalRef<jobject>(*constant));
+}
+
+duk_ret_t Enum::push(const JValue &value) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  if (value.isNull()) {
+    duk_push_null(m_ctx);
+    return 1;
+  }
+
+  m_table->pushName(m_ctx, getOrdinal(value));
+  return 1;
+}
+
+#elif defined(QUICKJS)
+
+JValue Enum::toJava(JSValueConst v) const {
+  if (JS_IsNull(v) || JS_IsUndefined(v)) {
+    return JValue();
+  }
+
+  const JniGlobalRef<jobject> *constant = m_table->getConstant(v);
+  if (constant == nullptr) {
+    throw std::invalid_argument("Cannot convert JS value to a Java enum constant");
+  }
+
+  return JValue(JniLocalRef<jobject>(*constant));
+}
+
+JSValue Enum::fromJava(const JValue &value) const {
+  if (value.isNull()) {
+    return JS_NULL;
+  }
+
+  return m_table->newName(getOrdinal(value));
+}
+
+#endif
+
+JniLocalRef<jclass> Enum::getJavaClass() const {
+  return JniLocalRef<jclass>(m_table->getEnumClass());
+}
+
+jint Enum::getOrdinal(const JValue &value) const {
+  static thread_local jmethodID ordinalMethodId = m_jniContext->getMethodID(getJniCache()->getEnumClass(), "ordinal", "()I");
+
+  jint ordinal = m_jniContext->callIntMethod(value.getLocalRef(), ordinalMethodId);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+  return ordinal;
+}
+
+}  // namespace JavaTypes
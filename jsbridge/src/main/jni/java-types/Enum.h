@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVATYPES_ENUM_H
+#define _JSBRIDGE_JAVATYPES_ENUM_H
+
+#include "JavaType.h"
+#include "jni-helpers/JniGlobalRef.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace JavaTypes {
+
+// Conversion table of a Java enum class, built once per enum class and JS context (see
+// JavaTypeProvider::getEnumTable()):
+// - Java -> JS: ordinal => constant name (interned JS string)
+// - JS -> Java: constant name => enum constant (global ref)
+//
+// Shared by the Enum types using it: a table released from the JavaTypeProvider cache (e.g. on
+// memory pressure) is deleted with the last of them.
+class EnumTable {
+public:
+  EnumTable(const JsBridgeContext *, const JniRef<jclass> &enumClass);
+  EnumTable(const EnumTable &) = delete;
+  EnumTable &operator=(const EnumTable &) = delete;
+  ~EnumTable();
+
+  const JniGlobalRef<jclass> &getEnumClass() const { return m_enumClass; }
+
+#if defined(DUKTAPE)
+  void pushName(duk_context *, jint ordinal) const;
+
+  // Returns nullptr if there is no constant with the given name
+  const JniGlobalRef<jobject> *getConstant(const char *name, duk_size_t length) const;
+#elif defined(QUICKJS)
+  JSValue newName(jint ordinal) const;
+
+  // Returns nullptr if the value is not the name of a constant
+  const JniGlobalRef<jobject> *getConstant(JSValueConst) const;
+#endif
+
+private:
+  JniGlobalRef<jclass> m_enumClass;
+  std::vector<JniGlobalRef<jobject>> m_constants;  // by ordinal
+
+#if defined(DUKTAPE)
+  std::vector<std::string> m_names;
+  std::unordered_map<std::string_view, jint> m_ordinalsByName;  // views of m_names
+#elif defined(QUICKJS)
+  JSContext *m_ctx;
+  JSRuntime *m_runtime;  // the atoms are freed via the runtime which outlives the JS finalizers
+  std::vector<JSAtom> m_atoms;
+  std::unordered_map<JSAtom, jint> m_ordinalsByAtom;
+#endif
+};
+
+// Java enum <-> JS string (constant name)
+class Enum : public JavaType {
+
+public:
+  Enum(const JsBridgeContext *, std::shared_ptr<const EnumTable>);
+
+#if defined(DUKTAPE)
+  JValue pop() const override;
+  duk_ret_t push(const JValue &) const override;
+#elif defined(QUICKJS)
+  JValue toJava(JSValueConst) const override;
+  JSValue fromJava(const JValue &) const override;
+#endif
+
+protected:
+  JniLocalRef<jclass> getJavaClass() const override;
+
+private:
+  jint getOrdinal(const JValue &) const;
+
+  const std::shared_ptr<const EnumTable> m_table;
+};
+
+}  // namespace JavaTypes
+
+#endif
@@ -18,6 +18,7 @@
 #include "ExceptionHandler.h"
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "JsonTape.h"
 #include "custom_stringify.h"
 #include "log.h"
 #include "exceptions/JniException.h"
@@ -106,6 +107,41 @@ duk_ret_t JsonObjectWrapper::push(const JValue &value) const {
 
 #elif defined(QUICKJS)
 
+namespace {
+  // Standard UTF-8 encoding of the given UTF-16 string. The "modified UTF-8" of GetStringUTFChars()
+  // encodes supplementary characters as 2 surrogates, which the JSON tape rightly rejects. Lone
+  // surrogates are encoded as they are.
+  std::string toUtf8(std::u16string_view sv) {
+    std::string out;
+    out.reserve(sv.length());
+
+    for (size_t i = 0; i < sv.length(); ++i) {
+      uint32_t cp = sv[i];
+      if (cp >= 0xD800 && cp < 0xDC00 && i + 1 < sv.length() && sv[i + 1] >= 0xDC00 && sv[i + 1] < 0xE000) {
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (sv[++i] - 0xDC00);
+      }
+
+      if (cp < 0x80) {
+        out += static_cast<char>(cp);
+      } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+      } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+      } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+      }
+    }
+
+    return out;
+  }
+}
+
 JValue JsonObjectWrapper::toJava(JSValueConst v) const {
   if (m_isNullable && (JS_IsNull(v) || JS_IsUndefined(v))) {
     return JValue();
@@ -145,7 +181,22 @@ JSValue JsonObjectWrapper::fromJava(const JValue &value) const {
     return JS_UNDEFINED;
   }
 
-  JSValue decodedValue = JS_ParseJSON(m_ctx, str, strlen(str), "JsonObjectWrapper.cpp");
+  const size_t length = strlen(str);
+  JSValue decodedValue;
+  if (str[0] == '[') {
+    // Lists (typically of records with the same keys) are created via a JSON tape so that the
+    // objects with the same keys share a template
+    try {
+      const std::string utf8Str = toUtf8(strRef.getUtf16View());
+      std::vector<uint8_t> tape = JsonTape::parse(utf8Str.data(), utf8Str.size());
+      decodedValue = JsonTape::toJsValue(m_ctx, tape.data(), tape.size());
+    } catch (const std::invalid_argument &) {
+      // e.g. lone surrogates: leave the error handling (or the conversion) to QuickJS
+      decodedValue = JS_ParseJSON(m_ctx, str, length, "JsonObjectWrapper.cpp");
+    }
+  } else {
+    decodedValue = JS_ParseJSON(m_ctx, str, length, "JsonObjectWrapper.cpp");
+  }
 
   if (JS_IsException(decodedValue)) {
     JS_GetException(m_ctx);
@@ -18,6 +18,7 @@
  */
 #include "String.h"
 #include "JsBridgeContext.h"
+#include "JavaStringPool.h"
 #include "JniCache.h"
 
 #if defined(DUKTAPE)
@@ -62,7 +63,15 @@ JValue String::pop() const {
     return JValue();
   }
 
-  JStringLocalRef stringLocalRef(m_jniContext, duk_safe_to_string(m_ctx, -1));
+  JStringLocalRef stringLocalRef;
+  JavaStringPool *javaStringPool = m_jsBridgeContext->getJavaStringPool();
+  if (javaStringPool != nullptr) {
+    duk_size_t length;
+    const char *s = duk_safe_to_lstring(m_ctx, -1, &length);
+    stringLocalRef = javaStringPool->get(m_jniContext, s, length);
+  } else {
+    stringLocalRef = JStringLocalRef(m_jniContext, duk_safe_to_string(m_ctx, -1));
+  }
   duk_pop(m_ctx);
   return JValue(stringLocalRef);
 }
@@ -115,6 +124,18 @@ JValue String::toJava(JSValueConst v) const {
     return JValue();
   }
 
+  JavaStringPool *javaStringPool = m_jsBridgeContext->getJavaStringPool();
+  if (javaStringPool != nullptr) {
+    size_t length;
+    const char *s = JS_ToCStringLen(m_ctx, &length, v);
+    if (s == nullptr) {
+      return JValue();
+    }
+    JStringLocalRef stringLocalRef = javaStringPool->get(m_jniContext, s, length);
+    JS_FreeCString(m_ctx, s);
+    return JValue(stringLocalRef);
+  }
+
   JStringLocalRef stringLocalRef = m_jsBridgeContext->getUtils()->toJString(v);
   return JValue(stringLocalRef);
 }
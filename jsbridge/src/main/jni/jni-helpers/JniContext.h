@@ -65,6 +65,11 @@ public:
     return env->IsInstanceOf(obj.get(), klass.get());
   }
 
+  jboolean isAssignableFrom(const JniRef<jclass> &klass, const JniRef<jclass> &superClass) const {
+    JNIEnv *env = getJNIEnv();
+    return env->IsAssignableFrom(klass.get(), superClass.get());
+  }
+
   template <class T>
   jmethodID fromReflectedMethod(const JniRef<T> &t) const {
     JNIEnv *env = getJNIEnv();
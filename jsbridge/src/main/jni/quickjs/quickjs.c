@@ -109,6 +109,10 @@
 /* test the GC by forcing it before each object allocation */
 //#define FORCE_GC_AT_MALLOC
 
+/* CONFIG_PROFILING: count the executed opcodes, the function calls and the
+   property lookups walking up the prototype chain (see JS_GetProfile()).
+   The counters are only updated when enabled with JS_SetProfilingEnabled(). */
+
 #ifdef CONFIG_ATOMICS
 #include <pthread.h>
 #include <stdatomic.h>
@@ -298,6 +302,13 @@ struct JSRuntime {
     int shape_hash_size;
     int shape_hash_count; /* number of hashed shapes */
     JSShape **shape_hash;
+#ifdef CONFIG_PROFILING
+    BOOL profiling_enabled;
+    uint64_t profile_opcode_counts[256];
+    uint64_t profile_property_get_count;
+    /* number of prototype objects searched by the property gets */
+    uint64_t profile_proto_lookup_count;
+#endif
 #ifdef CONFIG_BIGNUM
     bf_context_t bf_ctx;
     JSNumericOperations bigint_ops;
@@ -612,6 +623,9 @@ typedef struct JSFunctionBytecode {
     JSValue *cpool; /* constant pool (self pointer) */
     int cpool_count;
     int closure_var_count;
+#ifdef CONFIG_PROFILING
+    uint64_t profile_call_count;
+#endif
     struct {
         /* debug info, move to separate structure to save memory? */
         JSAtom filename;
@@ -4927,6 +4941,55 @@ JSValue JS_NewObject(JSContext *ctx)
     return JS_NewObjectProtoClass(ctx, ctx->class_proto[JS_CLASS_OBJECT], JS_CLASS_OBJECT);
 }
 
+/* Return the number of properties of 'obj' if it can be used as a
+   template by JS_NewObjectFromTemplate(), -1 otherwise. */
+int JS_GetObjectTemplateSize(JSContext *ctx, JSValueConst obj)
+{
+    JSObject *p;
+    JSShape *sh;
+    JSShapeProperty *prs;
+    int i;
+
+    if (JS_VALUE_GET_TAG(obj) != JS_TAG_OBJECT)
+        return -1;
+    p = JS_VALUE_GET_OBJ(obj);
+    sh = p->shape;
+    /* only plain extensible objects with a shared shape and data properties */
+    if (p->class_id != JS_CLASS_OBJECT || !p->extensible || p->is_exotic ||
+        !sh->is_hashed || sh->deleted_prop_count != 0)
+        return -1;
+    for(i = 0, prs = get_shape_prop(sh); i < sh->prop_count; i++, prs++) {
+        if (prs->flags != JS_PROP_C_W_E)
+            return -1;
+    }
+    return sh->prop_count;
+}
+
+/* Create an object with the same shape as 'template_obj' (which must be
+   accepted by JS_GetObjectTemplateSize()) without any shape transition
+   or property lookup. 'values' contains the values of the properties in
+   the template order and is always freed. */
+JSValue JS_NewObjectFromTemplate(JSContext *ctx, JSValueConst template_obj,
+                                 JSValue *values)
+{
+    JSShape *sh;
+    JSValue obj;
+    JSObject *p;
+    int i;
+
+    sh = JS_VALUE_GET_OBJ(template_obj)->shape;
+    obj = JS_NewObjectFromShape(ctx, js_dup_shape(sh), JS_CLASS_OBJECT);
+    if (JS_IsException(obj)) {
+        for(i = 0; i < sh->prop_count; i++)
+            JS_FreeValue(ctx, values[i]);
+        return obj;
+    }
+    p = JS_VALUE_GET_OBJ(obj);
+    for(i = 0; i < sh->prop_count; i++)
+        p->prop[i].u.value = values[i];
+    return obj;
+}
+
 static void js_function_set_properties(JSContext *ctx, JSValueConst func_obj,
                                        JSAtom name, int len)
 {
@@ -7080,6 +7143,10 @@ JSValue JS_GetPropertyInternal(JSContext *ctx, JSValueConst obj,
     JSShapeProperty *prs;
     uint32_t tag;
 
+#ifdef CONFIG_PROFILING
+    if (unlikely(ctx->rt->profiling_enabled))
+        ctx->rt->profile_property_get_count++;
+#endif
     tag = JS_VALUE_GET_TAG(obj);
     if (unlikely(tag != JS_TAG_OBJECT)) {
         switch(tag) {
@@ -7209,6 +7276,10 @@ JSValue JS_GetPropertyInternal(JSContext *ctx, JSValueConst obj,
         p = p->shape->proto;
         if (!p)
             break;
+#ifdef CONFIG_PROFILING
+        if (unlikely(ctx->rt->profiling_enabled))
+            ctx->rt->profile_proto_lookup_count++;
+#endif
     }
     if (unlikely(throw_ref_error)) {
         return JS_ThrowReferenceErrorNotDefined(ctx, prop);
@@ -16195,6 +16266,15 @@ typedef enum {
 #define FUNC_RET_YIELD_STAR 2
 
 /* argv[] is modified if (flags & JS_CALL_FLAG_COPY_ARGV) = 0. */
+#ifdef CONFIG_PROFILING
+static inline int js_profile_opcode(JSRuntime *rt, int op)
+{
+    if (unlikely(rt->profiling_enabled))
+        rt->profile_opcode_counts[op]++;
+    return op;
+}
+#endif
+
 static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                                JSValueConst this_obj, JSValueConst new_target,
                                int argc, JSValue *argv, int flags)
@@ -16210,8 +16290,13 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
     JSVarRef **var_refs;
     size_t alloca_size;
 
+#ifdef CONFIG_PROFILING
+#define FETCH_OPCODE(pc) js_profile_opcode(rt, *pc++)
+#else
+#define FETCH_OPCODE(pc) *pc++
+#endif
 #if !DIRECT_DISPATCH
-#define SWITCH(pc)      switch (opcode = *pc++)
+#define SWITCH(pc)      switch (opcode = FETCH_OPCODE(pc))
 #define CASE(op)        case op
 #define DEFAULT         default
 #define BREAK           break
@@ -16226,7 +16311,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
 #include "quickjs-opcode.h"
         [ OP_COUNT ... 255 ] = &&case_default
     };
-#define SWITCH(pc)      goto *dispatch_table[opcode = *pc++];
+#define SWITCH(pc)      goto *dispatch_table[opcode = FETCH_OPCODE(pc)];
 #define CASE(op)        case_ ## op
 #define DEFAULT         case_default
 #define BREAK           SWITCH(pc)
@@ -16272,6 +16357,10 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                          (JSValueConst *)argv, flags);
     }
     b = p->u.func.function_bytecode;
+#ifdef CONFIG_PROFILING
+    if (unlikely(rt->profiling_enabled))
+        b->profile_call_count++;
+#endif
 
     if (unlikely(argc < b->arg_count || (flags & JS_CALL_FLAG_COPY_ARGV))) {
         arg_allocated_size = b->arg_count;
@@ -18898,6 +18987,10 @@ static __exception int async_func_init(JSContext *ctx, JSAsyncFunctionState *s,
     init_list_head(&sf->var_ref_list);
     p = JS_VALUE_GET_OBJ(func_obj);
     b = p->u.func.function_bytecode;
+#ifdef CONFIG_PROFILING
+    if (unlikely(ctx->rt->profiling_enabled))
+        b->profile_call_count++;
+#endif
     sf->js_mode = b->js_mode;
     sf->cur_pc = b->byte_code_buf;
     arg_buf_len = max_int(b->arg_count, argc);
@@ -20103,7 +20196,7 @@ typedef struct JSParseState {
 } JSParseState;
 
 typedef struct JSOpCode {
-#ifdef DUMP_BYTECODE
+#if defined(DUMP_BYTECODE) || defined(CONFIG_PROFILING)
     const char *name;
 #endif
     uint8_t size; /* in bytes */
@@ -20116,7 +20209,7 @@ typedef struct JSOpCode {
 
 static const JSOpCode opcode_info[OP_COUNT + (OP_TEMP_END - OP_TEMP_START)] = {
 #define FMT(f)
-#ifdef DUMP_BYTECODE
+#if defined(DUMP_BYTECODE) || defined(CONFIG_PROFILING)
 #define DEF(id, size, n_pop, n_push, f) { #id, size, n_pop, n_push, OP_FMT_ ## f },
 #else
 #define DEF(id, size, n_pop, n_push, f) { size, n_pop, n_push, OP_FMT_ ## f },
@@ -20138,6 +20231,137 @@ static const JSOpCode opcode_info[OP_COUNT + (OP_TEMP_END - OP_TEMP_START)] = {
 #define short_opcode_info(op) opcode_info[op]
 #endif
 
+#ifdef CONFIG_PROFILING
+
+void JS_SetProfilingEnabled(JSRuntime *rt, BOOL enabled)
+{
+    rt->profiling_enabled = enabled;
+}
+
+void JS_ResetProfile(JSRuntime *rt)
+{
+    struct list_head *el;
+    JSGCObjectHeader *gp;
+
+    memset(rt->profile_opcode_counts, 0, sizeof(rt->profile_opcode_counts));
+    rt->profile_property_get_count = 0;
+    rt->profile_proto_lookup_count = 0;
+    list_for_each(el, &rt->gc_obj_list) {
+        gp = list_entry(el, JSGCObjectHeader, link);
+        if (gp->gc_obj_type == JS_GC_OBJ_TYPE_FUNCTION_BYTECODE)
+            ((JSFunctionBytecode *)gp)->profile_call_count = 0;
+    }
+}
+
+static int js_profile_opcode_cmp(const void *a, const void *b, void *opaque)
+{
+    const uint64_t *counts = opaque;
+    uint64_t ca = counts[*(const uint8_t *)a];
+    uint64_t cb = counts[*(const uint8_t *)b];
+    return (ca < cb) - (ca > cb);
+}
+
+static int js_profile_function_cmp(const void *a, const void *b, void *opaque)
+{
+    uint64_t ca = (*(JSFunctionBytecode * const *)a)->profile_call_count;
+    uint64_t cb = (*(JSFunctionBytecode * const *)b)->profile_call_count;
+    return (ca < cb) - (ca > cb);
+}
+
+JSValue JS_GetProfile(JSContext *ctx, int max_functions)
+{
+    JSRuntime *rt = ctx->rt;
+    JSValue ret, opcodes, functions, func;
+    JSFunctionBytecode **tab, *b;
+    struct list_head *el;
+    JSGCObjectHeader *gp;
+    uint8_t ops[256];
+    int i, op_count, func_count, func_size;
+    const char *name;
+
+    ret = JS_NewObject(ctx);
+    if (JS_IsException(ret))
+        return ret;
+
+    /* opcodes by decreasing count */
+    opcodes = JS_NewObject(ctx);
+    if (JS_IsException(opcodes))
+        goto fail;
+    JS_SetPropertyStr(ctx, ret, "opcodes", opcodes);
+    op_count = 0;
+    for(i = 0; i < 256; i++) {
+        if (rt->profile_opcode_counts[i] != 0)
+            ops[op_count++] = i;
+    }
+    rqsort(ops, op_count, sizeof(ops[0]), js_profile_opcode_cmp,
+           rt->profile_opcode_counts);
+    for(i = 0; i < op_count; i++) {
+        if (ops[i] < OP_COUNT)
+            name = short_opcode_info(ops[i]).name;
+        else
+            name = "invalid";
+        if (JS_SetPropertyStr(ctx, opcodes, name,
+                              JS_NewInt64(ctx, rt->profile_opcode_counts[ops[i]])) < 0)
+            goto fail;
+    }
+
+    /* most called functions */
+    functions = JS_NewArray(ctx);
+    if (JS_IsException(functions))
+        goto fail;
+    JS_SetPropertyStr(ctx, ret, "functions", functions);
+    tab = NULL;
+    func_count = 0;
+    func_size = 0;
+    list_for_each(el, &rt->gc_obj_list) {
+        gp = list_entry(el, JSGCObjectHeader, link);
+        if (gp->gc_obj_type != JS_GC_OBJ_TYPE_FUNCTION_BYTECODE)
+            continue;
+        b = (JSFunctionBytecode *)gp;
+        if (b->profile_call_count == 0)
+            continue;
+        if (js_resize_array(ctx, (void **)&tab, sizeof(tab[0]),
+                            &func_size, func_count + 1)) {
+            js_free(ctx, tab);
+            goto fail;
+        }
+        tab[func_count++] = b;
+    }
+    rqsort(tab, func_count, sizeof(tab[0]), js_profile_function_cmp, NULL);
+    if (func_count > max_functions)
+        func_count = max_functions;
+    for(i = 0; i < func_count; i++) {
+        b = tab[i];
+        func = JS_NewObject(ctx);
+        if (JS_IsException(func))
+            goto fail_tab;
+        JS_SetPropertyUint32(ctx, functions, i, func);
+        JS_SetPropertyStr(ctx, func, "name", JS_AtomToString(ctx, b->func_name));
+        if (b->has_debug) {
+            JS_SetPropertyStr(ctx, func, "fileName",
+                              JS_AtomToString(ctx, b->debug.filename));
+            JS_SetPropertyStr(ctx, func, "lineNumber",
+                              JS_NewInt32(ctx, b->debug.line_num));
+        }
+        JS_SetPropertyStr(ctx, func, "callCount",
+                          JS_NewInt64(ctx, b->profile_call_count));
+    }
+    js_free(ctx, tab);
+
+    JS_SetPropertyStr(ctx, ret, "propertyGets",
+                      JS_NewInt64(ctx, rt->profile_property_get_count));
+    JS_SetPropertyStr(ctx, ret, "prototypeLookups",
+                      JS_NewInt64(ctx, rt->profile_proto_lookup_count));
+    return ret;
+ fail_tab:
+    js_free(ctx, tab);
+ fail:
+    JS_FreeValue(ctx, ret);
+    return JS_EXCEPTION;
+}
+
+#endif /* CONFIG_PROFILING */
+
 static __exception int next_token(JSParseState *s);
 
 static void free_token(JSParseState *s, JSToken *token)
@@ -53142,6 +53366,30 @@ static JSValue js_typed_array_constructor(JSContext *ctx,
     return obj;
 }
 
+/* Uint8Array with a copy of the given bytes, created from the intrinsic
+   prototype (not affected by changes of the global object). Return
+   JS_UNDEFINED if the typed arrays are not available in the context. */
+JSValue JS_NewUint8ArrayCopy(JSContext *ctx, const uint8_t *buf, size_t len)
+{
+    JSValue buffer, obj;
+
+    if (JS_IsNull(ctx->class_proto[JS_CLASS_UINT8_ARRAY]))
+        return JS_UNDEFINED;
+    buffer = JS_NewArrayBufferCopy(ctx, buf, len);
+    if (JS_IsException(buffer))
+        return JS_EXCEPTION;
+    obj = js_create_from_ctor(ctx, JS_UNDEFINED, JS_CLASS_UINT8_ARRAY);
+    if (JS_IsException(obj)) {
+        JS_FreeValue(ctx, buffer);
+        return JS_EXCEPTION;
+    }
+    if (typed_array_init(ctx, obj, buffer, 0, len)) {
+        JS_FreeValue(ctx, obj);
+        return JS_EXCEPTION;
+    }
+    return obj;
+}
+
 static void js_typed_array_finalizer(JSRuntime *rt, JSValue val)
 {
     JSObject *p = JS_VALUE_GET_OBJ(val);
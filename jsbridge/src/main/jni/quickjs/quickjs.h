@@ -415,6 +415,18 @@ typedef struct JSMemoryUsage {
 void JS_ComputeMemoryUsage(JSRuntime *rt, JSMemoryUsage *s);
 void JS_DumpMemoryUsage(FILE *fp, const JSMemoryUsage *s, JSRuntime *rt);
 
+#ifdef CONFIG_PROFILING
+/* execution profile (only available when built with CONFIG_PROFILING) */
+void JS_SetProfilingEnabled(JSRuntime *rt, JS_BOOL enabled);
+void JS_ResetProfile(JSRuntime *rt);
+/* return the profile as an object:
+   { opcodes: { <name>: <count>, ... } (by decreasing count),
+     functions: [ { name, fileName, lineNumber, callCount }, ... ]
+       (the 'max_functions' most called functions),
+     propertyGets: <count>, prototypeLookups: <count> } */
+JSValue JS_GetProfile(JSContext *ctx, int max_functions);
+#endif
+
 /* atom support */
 #define JS_ATOM_NULL 0
 
@@ -712,6 +724,9 @@ JSValue JS_NewObjectProtoClass(JSContext *ctx, JSValueConst proto, JSClassID cla
 JSValue JS_NewObjectClass(JSContext *ctx, int class_id);
 JSValue JS_NewObjectProto(JSContext *ctx, JSValueConst proto);
 JSValue JS_NewObject(JSContext *ctx);
+/* shape templates: create objects with the same properties without shape transitions */
+int JS_GetObjectTemplateSize(JSContext *ctx, JSValueConst obj);
+JSValue JS_NewObjectFromTemplate(JSContext *ctx, JSValueConst template_obj, JSValue *values);
 
 JS_BOOL JS_IsFunction(JSContext* ctx, JSValueConst val);
 JS_BOOL JS_IsConstructor(JSContext* ctx, JSValueConst val);
@@ -816,6 +831,7 @@ JSValue JS_NewArrayBuffer(JSContext *ctx, uint8_t *buf, size_t len,
                           JSFreeArrayBufferDataFunc *free_func, void *opaque,
                           JS_BOOL is_shared);
 JSValue JS_NewArrayBufferCopy(JSContext *ctx, const uint8_t *buf, size_t len);
+JSValue JS_NewUint8ArrayCopy(JSContext *ctx, const uint8_t *buf, size_t len);
 void JS_DetachArrayBuffer(JSContext *ctx, JSValueConst obj);
 uint8_t *JS_GetArrayBuffer(JSContext *ctx, size_t *psize, JSValueConst obj);
 JSValue JS_GetTypedArrayBuffer(JSContext *ctx, JSValueConst obj,
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import org.json.JSONObject
+
+/**
+ * Read-only JSON data (e.g. catalogs, rule tables, localization) which can be assigned as a deeply
+ * frozen global variable to several JsBridge instances.
+ *
+ * Only the JSON string is kept once in the JVM: JS values cannot be shared between JS runtimes,
+ * so each JsBridge instance parses the data into its own object graph (when the global variable
+ * is first accessed). The object graph is deeply frozen and the global variable cannot be
+ * re-assigned or deleted.
+ *
+ * Usage:
+ * val catalog = FrozenJsonData.fromJson(catalogJson)
+ * catalog.assignToGlobal(jsBridge1, "catalog")
+ * catalog.assignToGlobal(jsBridge2, "catalog")
+ */
+class FrozenJsonData private constructor(val jsonString: String) {
+    companion object {
+        @JvmStatic
+        fun fromJson(jsonString: String) = FrozenJsonData(jsonString)
+
+        // Note: the JS value must be JSON-serializable
+        @JvmStatic
+        suspend fun fromJsValue(jsValue: JsValue): FrozenJsonData {
+            val jsonObjectWrapper: JsonObjectWrapper = jsValue.evaluate()
+            return FrozenJsonData(jsonObjectWrapper.jsonString)
+        }
+    }
+
+    fun assignToGlobal(jsBridge: JsBridge, globalName: String) {
+        val getDataJsValue = JsValue.createJsToJavaProxyFunction0(jsBridge) { JsonObjectWrapper(jsonString) }
+
+        jsBridge.evaluateUnsync("""
+            |(function(getData) {
+            |  var value;
+            |  function deepFreeze(o) {
+            |    if (o !== null && typeof o === "object" && !Object.isFrozen(o)) {
+            |      Object.freeze(o);
+            |      Object.getOwnPropertyNames(o).forEach(function(key) { deepFreeze(o[key]); });
+            |    }
+            |    return o;
+            |  }
+            |  Object.defineProperty(globalThis, ${JSONObject.quote(globalName)}, {
+            |    configurable: false,
+            |    enumerable: true,
+            |    get: function() {
+            |      if (getData) {
+            |        value = deepFreeze(getData());
+            |        getData = null;
+            |      }
+            |      return value;
+            |    }
+            |  });
+            |})($getDataJsValue);
+            """.trimMargin())
+
+        // The function is now only referenced by the getter
+        getDataJsValue.release()
+    }
+}
@@ -19,14 +19,20 @@
 package de.prosiebensat1digital.oasisjsbridge
 
 import android.app.Activity
+import android.content.ComponentCallbacks2
 import android.content.Context
 import android.os.Looper
 import androidx.annotation.VisibleForTesting
 import de.prosiebensat1digital.oasisjsbridge.JsBridgeError.*
 import de.prosiebensat1digital.oasisjsbridge.extensions.*
+import java.io.DataInputStream
+import java.io.DataOutputStream
+import java.io.EOFException
+import java.io.File
 import java.io.FileNotFoundException
 import java.io.InputStream
 import java.lang.reflect.Method as JavaMethod
+import java.nio.ByteBuffer
 import java.util.concurrent.CopyOnWriteArraySet
 import java.util.concurrent.Executors
 import java.util.concurrent.atomic.AtomicInteger
@@ -37,6 +43,7 @@ import kotlin.reflect.*
 import kotlin.reflect.full.createType
 import kotlin.reflect.full.declaredMemberFunctions
 import kotlinx.coroutines.*
+import org.json.JSONObject
 import timber.log.Timber
 import java.lang.reflect.Proxy
 
@@ -65,12 +72,156 @@ class JsBridge
 
     companion object {
         private var isLibraryLoaded = false
+        private val dedicatedCoreCounter = AtomicInteger(0)
+
+        // CPUs with the highest max frequency (e.g. the big cores of big.LITTLE devices)
+        private fun getFastestCpus(): List<Int> {
+            val cpuDirs = File("/sys/devices/system/cpu").listFiles { file -> file.name.matches(Regex("cpu[0-9]+")) }
+                ?: return emptyList()
+
+            val maxFrequencies = cpuDirs.associate { cpuDir ->
+                val maxFrequencyFile = File(cpuDir, "cpufreq/cpuinfo_max_freq")
+                val maxFrequency = if (maxFrequencyFile.canRead()) maxFrequencyFile.readText().trim().toLongOrNull() else null
+                cpuDir.name.removePrefix("cpu").toInt() to (maxFrequency ?: 0L)
+            }
+
+            val highestFrequency = maxFrequencies.values.maxOrNull() ?: return emptyList()
+            return maxFrequencies.filterValues { it == highestFrequency }.keys.sorted()
+        }
+
+        /**
+         * Create a new JsBridge and restore the global variables saved by JsBridge.hibernate().
+         *
+         * The file is read in the current thread and the global variables are restored before
+         * any other JS code is evaluated in the new JsBridge. An IllegalArgumentException is thrown
+         * if the file is not a valid snapshot (e.g. truncated).
+         */
+        @JvmStatic
+        fun resume(file: File, config: JsBridgeConfig, context: Context): JsBridge {
+            val data = DataInputStream(file.inputStream().buffered()).use { input ->
+                try {
+                    val flavor = input.readUTF()
+                    if (flavor != BuildConfig.FLAVOR) {
+                        throw IllegalArgumentException("Cannot resume a JsBridge hibernated with $flavor (current: ${BuildConfig.FLAVOR})")
+                    }
+
+                    // Check the size before allocating (corrupted file)
+                    val size = input.readInt()
+                    val remainingSize = file.length() - (2 + flavor.toByteArray().size + 4)
+                    if (size < 0 || size > remainingSize) {
+                        throw IllegalArgumentException("Invalid JsBridge snapshot: data size $size does not match the file size")
+                    }
+                    ByteArray(size).also { input.readFully(it) }
+                } catch (e: EOFException) {
+                    throw IllegalArgumentException("Invalid JsBridge snapshot: unexpected end of file", e)
+                }
+            }
+
+            val jsBridge = JsBridge(config, context)
+            jsBridge.launch {
+                // The file might have been tampered with: SharedArrayBuffers (native pointers) are rejected
+                val globalsJsValue = jsBridge.deserializeJsValue(data, allowSharedArrayBuffers = false)
+                jsBridge.jniEvaluateString(jsBridge.jniJsContextOrThrow(), "Object.assign(globalThis, $globalsJsValue)", null, false)
+                globalsJsValue.release()
+            }
+            return jsBridge
+        }
+
+        // Called by XMLHttpRequestExtension
+        // Parse the given UTF-8 JSON text into a tape which can be quickly converted to a JS value
+        // via jsonTapeToJsValue(). Can be called from any thread. Returns null if the JSON text
+        // is invalid.
+        internal fun parseJsonTape(json: ByteArray): ByteArray? = jniParseJsonTape(json)
+
+        @JvmStatic
+        private external fun jniParseJsonTape(json: ByteArray): ByteArray?
+
+        @JvmStatic
+        private external fun jniParseJsonTapeStream(inputStream: InputStream): Long
+
+        @JvmStatic
+        private external fun jniDeleteNativeJsonTape(tape: Long)
+
+        // Called by JsSourceMap (can be called from any thread)
+        internal fun decodeSourceMap(mappings: String): Long = jniDecodeSourceMap(mappings)
+        internal fun resolveSourceMapLocation(sourceMap: Long, line: Int, column: Int): IntArray? =
+            jniResolveSourceMapLocation(sourceMap, line, column)
+        internal fun deleteSourceMap(sourceMap: Long) = jniDeleteSourceMap(sourceMap)
+
+        // Called by JsModulePrefetcher (can be called from any thread)
+        internal fun scanModuleImports(source: String, moduleName: String): Array<String> =
+            jniScanModuleImports(source, moduleName)
+
+        @JvmStatic
+        private external fun jniDecodeSourceMap(mappings: String): Long
+
+        @JvmStatic
+        private external fun jniResolveSourceMapLocation(sourceMap: Long, line: Int, column: Int): IntArray?
+
+        @JvmStatic
+        private external fun jniDeleteSourceMap(sourceMap: Long)
+
+        @JvmStatic
+        private external fun jniScanModuleImports(source: String, moduleName: String): Array<String>
     }
 
     abstract class ErrorListener(val coroutineContext: CoroutineContext? = null) {
         abstract fun onError(error: JsBridgeError)
     }
 
+    /**
+     * Scheduling of the JS thread
+     *
+     * @param priority Linux nice value
+     * @param currentCpu CPU the JS thread is currently running on
+     * @param cpuAffinity CPUs the JS thread is allowed to run on
+     */
+    data class JsThreadPlacement(val priority: Int, val currentCpu: Int, val cpuAffinity: Set<Int>)
+
+    /**
+     * Execution profile of the JS engine (see startEngineProfiling())
+     *
+     * @param opcodeCounts number of executions per bytecode opcode (by decreasing count)
+     * @param functions most called JS functions (by decreasing call count)
+     * @param propertyGetCount number of property reads
+     * @param prototypeLookupCount number of prototype objects searched by the property reads
+     *   (i.e. lookup misses on the object itself)
+     */
+    data class EngineProfile(
+        val opcodeCounts: Map<String, Long>,
+        val functions: List<FunctionProfile>,
+        val propertyGetCount: Long,
+        val prototypeLookupCount: Long
+    )
+
+    /**
+     * Call count of a JS function. The file name and line number are null for functions without
+     * debug info.
+     */
+    data class FunctionProfile(val name: String, val fileName: String?, val lineNumber: Int?, val callCount: Long)
+
+    /**
+     * Cost of the JS context creation (see JsBridgeConfig.RuntimeConfig.builtIns)
+     *
+     * @param creationTimeNanos duration of the JS context creation
+     * @param baselineHeapSize number of bytes allocated by the JS engine for the new context
+     *   (approximated with Duktape)
+     */
+    data class ContextCreationStats(val creationTimeNanos: Long, val baselineHeapSize: Long)
+
+    /**
+     * Usage of the Java string pool (see JsBridgeConfig.RuntimeConfig.javaStringPoolSize)
+     *
+     * @param hits number of Java strings taken from the pool
+     * @param misses number of Java strings created and added to the pool
+     * @param evictions number of least recently used strings removed from the full pool
+     * @param size current number of pooled strings
+     */
+    data class JavaStringPoolStats(val hits: Long, val misses: Long, val evictions: Long, val size: Long) {
+        val hitRate: Double
+            get() = if (hits + misses == 0L) 0.0 else hits.toDouble() / (hits + misses)
+    }
+
     // State
     private enum class State(val intValue: Int) {
         Pending(0), AboutToStart(1), Starting(2), Started(3),
@@ -93,6 +244,11 @@ class JsBridge
     var customClassLoader: ClassLoader? = null
         private set
 
+    // Available once the JsBridge has been started
+    @Volatile
+    var contextCreationStats: ContextCreationStats? = null
+        private set
+
     private val errorListeners = CopyOnWriteArraySet<ErrorListener>()
 
     // Extensions
@@ -102,9 +258,18 @@ class JsBridge
     private var consoleExtension: ConsoleExtension? = null
     private var xhrExtension: XMLHttpRequestExtension? = null
     private var localStorageExtension: LocalStorageExtension? = null
+    private var compressionExtension: CompressionExtension? = null
+    private var typedArrayKernelsExtension: TypedArrayKernelsExtension? = null
+    private var workerExtension: WorkerExtension? = null
 
     private var internalCounter = AtomicInteger(0)
 
+    // Reusable buffer for JsValue.writeJsonTo() (only used in the JS thread)
+    private val jsonOutputBuffer: ByteBuffer by lazy { ByteBuffer.allocateDirect(64 * 1024) }
+
+    // Source maps of the evaluated files (see registerSourceMap())
+    private val sourceMaps = JsSourceMaps()
+
     // Initialize the JS interpreter
     // - create the JS context via JNI
     // - set up the interpreter with polyfills and helpers (e.g. support for setTimeout)
@@ -133,16 +298,29 @@ class JsBridge
                 }
 
                 try {
-                    val jniJsContext = createJniJsContext()
+                    val startTime = System.nanoTime()
+                    val jniJsContext = createJniJsContext(config.runtimeConfig.fastRelease, config.runtimeConfig.canBlock, builtInFlags(config))
+                    val creationTimeNanos = System.nanoTime() - startTime
 
                     if (this@JsBridge.jniJsContext != null) {
                         throw InternalError("Cannot create a second JNI context!")
                     }
                     this@JsBridge.jniJsContext = jniJsContext
+                    contextCreationStats = ContextCreationStats(creationTimeNanos, jniGetBaselineHeapSize(jniJsContext))
+
+                    if (config.runtimeConfig.javaStringPoolSize > 0) {
+                        jniEnableJavaStringPool(
+                            jniJsContext,
+                            config.runtimeConfig.javaStringPoolSize,
+                            config.runtimeConfig.javaStringPoolMaxLength
+                        )
+                    }
                 } catch (t: Throwable) {
                     throw StartError(t)
                 }
 
+                setUpJsThread(config.jsThreadConfig)
+
                 if (state.compareAndSet(State.Starting.intValue, State.Started.intValue)) {
                     Timber.d("JsBridge successfully started!")
                 }
@@ -161,6 +339,12 @@ class JsBridge
                 xhrExtension = XMLHttpRequestExtension(this@JsBridge, config.xhrConfig)
             if (config.localStorageConfig.enabled)
                 localStorageExtension = LocalStorageExtension(this@JsBridge, config.localStorageConfig, context.applicationContext)
+            if (config.compressionConfig.enabled)
+                compressionExtension = CompressionExtension(this@JsBridge, config.compressionConfig)
+            if (config.typedArrayKernelsConfig.enabled)
+                typedArrayKernelsExtension = TypedArrayKernelsExtension(this@JsBridge, config.typedArrayKernelsConfig)
+            if (config.workerConfig.enabled)
+                workerExtension = WorkerExtension(this@JsBridge, config.workerConfig, context.applicationContext)
             config.jvmConfig.customClassLoader?.let { customClassLoader = it }
         }
     }
@@ -235,6 +419,20 @@ class JsBridge
             xhrExtension?.release()
             xhrExtension = null
 
+            compressionExtension?.release()
+            compressionExtension = null
+
+            typedArrayKernelsExtension?.release()
+            typedArrayKernelsExtension = null
+
+            workerExtension?.release()
+            workerExtension = null
+
+            jsModulePrefetcher?.release()
+            jsModulePrefetcher = null
+
+            sourceMaps.release()
+
             errorListeners.clear()
             jsDispatcher.close()
 
@@ -245,6 +443,193 @@ class JsBridge
         }
     }
 
+    /**
+     * Hibernate the JsBridge: serialize the given global variables into the given file and release
+     * the JsBridge (including its JS runtime). Use JsBridge.resume() to create a new JsBridge with
+     * the saved global variables.
+     *
+     * Notes:
+     * - only data can be saved (structured clone with QuickJS, JSON with Duktape): functions, Java
+     *   proxies and SharedArrayBuffers are not supported
+     * - scripts, JS-to-Java proxies and other bindings need to be set up again after resuming
+     */
+    suspend fun hibernate(file: File, globalNames: List<String>) {
+        val data = withContext(coroutineContext) {
+            val globalsJs = globalNames.joinToString(", ", "({", "})") {
+                val quotedName = JSONObject.quote(it)
+                "$quotedName: globalThis[$quotedName]"
+            }
+            val globalsJsValue = JsValue(this@JsBridge, globalsJs)
+            globalsJsValue.codeEvaluationDeferred?.await()
+
+            try {
+                serializeJsValue(globalsJsValue, null, false)
+            } finally {
+                globalsJsValue.release()
+            }
+        }
+
+        withContext(Dispatchers.IO) {
+            DataOutputStream(file.outputStream().buffered()).use { output ->
+                output.writeUTF(BuildConfig.FLAVOR)
+                output.writeInt(data.size)
+                output.write(data)
+            }
+        }
+
+        release()
+    }
+
+    /**
+     * Reclaim memory, e.g. when receiving ComponentCallbacks2.onTrimMemory(level):
+     * - all levels: run the JS garbage collector and release the native caches (pooled Java
+     *   strings, memoized results of the @JsCacheable methods, enum conversion tables)
+     * - from TRIM_MEMORY_RUNNING_LOW: also compact the JS heap (Duktape) and return the free pages
+     *   of the native allocator to the system
+     *
+     * @return the number of reclaimed bytes of the JS heap (approximated with Duktape)
+     */
+    suspend fun onMemoryPressure(level: Int): Long = withContext(coroutineContext) {
+        val jniJsContext = jniJsContextOrThrow()
+        val aggressive = level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW
+        jniReclaimMemory(jniJsContext, aggressive)
+    }
+
+    /**
+     * Discard the memoized results of all the @JsCacheable methods, e.g. after a config change.
+     */
+    fun invalidateJavaMethodCaches() {
+        launch {
+            jniInvalidateJavaMethodCaches(jniJsContextOrThrow())
+        }
+    }
+
+    /**
+     * Return the usage of the Java string pool or null if it is disabled (see
+     * JsBridgeConfig.RuntimeConfig.javaStringPoolSize).
+     */
+    suspend fun getJavaStringPoolStats(): JavaStringPoolStats? = withContext(coroutineContext) {
+        val stats = jniGetJavaStringPoolStats(jniJsContextOrThrow()) ?: return@withContext null
+        JavaStringPoolStats(hits = stats[0], misses = stats[1], evictions = stats[2], size = stats[3])
+    }
+
+    /**
+     * Start counting the executed bytecode opcodes, the JS function calls and the property lookups
+     * until stopEngineProfiling(). Previous counts are discarded.
+     *
+     * Only available with the instrumented QuickJS interpreter (quickjsProfiling flavor, see
+     * BuildConfig.HAS_ENGINE_PROFILER). The instrumentation has a negligible cost while stopped.
+     *
+     * @throws UnsupportedOperationException with other flavors
+     */
+    suspend fun startEngineProfiling() {
+        if (!BuildConfig.HAS_ENGINE_PROFILER) {
+            throw UnsupportedOperationException("Engine profiling requires the quickjsProfiling flavor")
+        }
+
+        withContext(coroutineContext) {
+            jniStartEngineProfiling(jniJsContextOrThrow())
+        }
+    }
+
+    /**
+     * Stop the profiling started with startEngineProfiling() and return the counts.
+     *
+     * @param maxFunctions maximum number of (most called) functions in the report
+     * @throws UnsupportedOperationException with other flavors than quickjsProfiling
+     */
+    suspend fun stopEngineProfiling(maxFunctions: Int = 50): EngineProfile {
+        if (!BuildConfig.HAS_ENGINE_PROFILER) {
+            throw UnsupportedOperationException("Engine profiling requires the quickjsProfiling flavor")
+        }
+
+        val json = withContext(coroutineContext) {
+            jniStopEngineProfiling(jniJsContextOrThrow(), maxFunctions)
+        }
+
+        val jsonProfile = JSONObject(json)
+        val jsonOpcodes = jsonProfile.getJSONObject("opcodes")
+        val opcodeCounts = jsonOpcodes.keys().asSequence()
+            .map { it to jsonOpcodes.getLong(it) }
+            .sortedByDescending { it.second }
+            .toMap()
+
+        val jsonFunctions = jsonProfile.getJSONArray("functions")
+        val functions = (0 until jsonFunctions.length()).map { i ->
+            val jsonFunction = jsonFunctions.getJSONObject(i)
+            FunctionProfile(
+                name = jsonFunction.getString("name"),
+                fileName = if (jsonFunction.has("fileName")) jsonFunction.getString("fileName") else null,
+                lineNumber = if (jsonFunction.has("lineNumber")) jsonFunction.getInt("lineNumber") else null,
+                callCount = jsonFunction.getLong("callCount")
+            )
+        }
+
+        return EngineProfile(
+            opcodeCounts = opcodeCounts,
+            functions = functions,
+            propertyGetCount = jsonProfile.getLong("propertyGets"),
+            prototypeLookupCount = jsonProfile.getLong("prototypeLookups")
+        )
+    }
+
+    /**
+     * Get the actual scheduling of the JS thread (see JsBridgeConfig.jsThreadConfig)
+     */
+    suspend fun getJsThreadPlacement(): JsThreadPlacement = withContext(coroutineContext) {
+        val placement = jniGetJsThreadPlacement(jniJsContextOrThrow())
+        JsThreadPlacement(placement[0], placement[1], placement.drop(2).toSet())
+    }
+
+    /**
+     * Parse the UTF-8 JSON data of the given input stream into a new JS value.
+     *
+     * The stream is read and parsed chunk by chunk in an I/O thread into a compact native
+     * intermediate representation (the "tape", roughly as large as the JSON text) which is then
+     * converted into the JS value in the JS thread. Neither the JSON text nor the tape is copied
+     * into the Java heap, but the whole tape is kept in native memory until the JS value has been
+     * created.
+     *
+     * @throws IllegalArgumentException if the JSON data is invalid
+     */
+    suspend fun parseJson(inputStream: InputStream): JsValue {
+        val tape = withContext(Dispatchers.IO) {
+            jniParseJsonTapeStream(inputStream)
+        }
+
+        // The tape is owned by jniAssignNativeJsonTape() once called, and must be deleted otherwise
+        // (e.g. when cancelled or when the JsBridge has been released)
+        var isTapeConsumed = false
+        try {
+            return withContext(coroutineContext) {
+                val jsValue = JsValue(this@JsBridge)
+                val jniJsContext = jniJsContextOrThrow()
+                isTapeConsumed = true
+                jniAssignNativeJsonTape(jniJsContext, jsValue.associatedJsName, tape)
+                jsValue
+            }
+        } finally {
+            if (!isTapeConsumed) {
+                jniDeleteNativeJsonTape(tape)
+            }
+        }
+    }
+
+    /**
+     * Load a native library ("lib<libraryName>.so") and call its entry point which directly
+     * registers native functions into the JS context, without JNI overhead on each call.
+     *
+     * See jsbridge_native_extension.h for the C API.
+     */
+    fun registerNativeExtension(libraryName: String, entryPoint: String = "JsBridge_initNativeExtension") {
+        System.loadLibrary(libraryName)
+
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniRegisterNativeExtension(jniJsContext, System.mapLibraryName(libraryName), entryPoint)
+        }
+    }
+
     fun registerErrorListener(listener: ErrorListener) {
         errorListeners.add(listener)
     }
@@ -293,9 +678,24 @@ class JsBridge
     /**
      * Set a custom module loader which will return the content of the given module
      */
-    private var jsModuleLoaderFunc: ((moduleName: String) -> String)? = null
+    internal var jsModuleLoaderFunc: ((moduleName: String) -> String)? = null  // also used by WorkerExtension
+        private set
+    private var jsModulePrefetcher: JsModulePrefetcher? = null
     fun setJsModuleLoader(func: (moduleName: String) -> String) {
+        setJsModuleLoader(false, func)
+    }
+
+    /**
+     * Same as above. With prefetch = true, the module graph is loaded concurrently: the imports of
+     * each module (including the string literals given to import()) are scanned and loaded in I/O
+     * threads ahead of the JS engine, which only waits for the module it needs. Prefetched modules
+     * which have not been imported when the evaluation of the module is over are dropped. The
+     * loader function must then be thread-safe and must not wait for the JS thread.
+     */
+    fun setJsModuleLoader(prefetch: Boolean, func: (moduleName: String) -> String) {
         jsModuleLoaderFunc = func
+        jsModulePrefetcher?.release()
+        jsModulePrefetcher = if (prefetch) JsModulePrefetcher(this, func) else null
 
         launch {
             val jniJsContext = jniJsContextOrThrow()
@@ -314,15 +714,25 @@ class JsBridge
             val jniJsContext = jniJsContextOrThrow()
 
             try {
-                val (inputStream, jsFileName) = getInputStream(context, filename, useMaxJs)
-                val jsString = inputStream.bufferedReader().use { it.readText() }
-                jniEvaluateFileContent(jniJsContext, jsString, jsFileName, type == JsFileEvaluationType.Module)
-                Timber.d("-> $filename ($jsFileName) has been successfully evaluated!")
-            } catch (t: Throwable) {
-                throw JsFileEvaluationError(filename, t)
-            }
+                try {
+                    val (inputStream, jsFileName) = getInputStream(context, filename, useMaxJs)
+                    val jsString = inputStream.bufferedReader().use { it.readText() }
+                    if (type == JsFileEvaluationType.Module) {
+                        jsModulePrefetcher?.prefetchImports(jsString, jsFileName)
+                    }
+                    jniEvaluateFileContent(jniJsContext, jsString, jsFileName, type == JsFileEvaluationType.Module)
+                    Timber.d("-> $filename ($jsFileName) has been successfully evaluated!")
+                } catch (t: Throwable) {
+                    throw JsFileEvaluationError(filename, t)
+                }
 
-            processPromiseQueue()
+                processPromiseQueue()
+            } finally {
+                // Drop the prefetched modules which have not been imported
+                if (type == JsFileEvaluationType.Module) {
+                    jsModulePrefetcher?.evictPendingSources()
+                }
+            }
         }
     }
 
@@ -352,13 +762,23 @@ class JsBridge
             val jniJsContext = jniJsContextOrThrow()
 
             try {
-                jniEvaluateFileContent(jniJsContext, content, filename, type == JsFileEvaluationType.Module)
-                Timber.d("-> file content ($filename) has been successfully evaluated!")
-            } catch (t: Throwable) {
-                throw JsFileEvaluationError(filename, t)
-            }
+                try {
+                    if (type == JsFileEvaluationType.Module) {
+                        jsModulePrefetcher?.prefetchImports(content, filename)
+                    }
+                    jniEvaluateFileContent(jniJsContext, content, filename, type == JsFileEvaluationType.Module)
+                    Timber.d("-> file content ($filename) has been successfully evaluated!")
+                } catch (t: Throwable) {
+                    throw JsFileEvaluationError(filename, t)
+                }
 
-            processPromiseQueue()
+                processPromiseQueue()
+            } finally {
+                // Drop the prefetched modules which have not been imported
+                if (type == JsFileEvaluationType.Module) {
+                    jsModulePrefetcher?.evictPendingSources()
+                }
+            }
         }
     }
 
@@ -380,6 +800,34 @@ class JsBridge
         }
     }
 
+    /**
+     * Register the source map (revision 3 JSON) of an evaluated file or module, so that the stack
+     * traces of JsException map its frames to the original sources.
+     *
+     * The mappings are decoded once into a compact native index. Frames are only resolved when the
+     * stack trace of a JsException is actually read, and each location is only resolved once.
+     *
+     * Limitation: the stack traces of Duktape and QuickJS only contain line numbers (no columns), so
+     * a generated line is only mapped if all its segments map to the same original line. Files
+     * minified into a single line (or a few long lines) are not mapped: keep one generated line per
+     * original line (e.g. with a line-preserving minifier configuration).
+     *
+     * @param filename name of the generated file as given to evaluateFileContent(), evaluateLocalFile()
+     *   or returned by the module loader
+     * @throws IllegalArgumentException if the source map is invalid
+     */
+    suspend fun registerSourceMap(filename: String, sourceMapJson: String) {
+        // Decoded in the JS thread, where the native library is known to be loaded
+        val sourceMap = withContext(coroutineContext) {
+            try {
+                JsSourceMap.parse(sourceMapJson)
+            } catch (e: org.json.JSONException) {
+                throw IllegalArgumentException("Invalid source map for $filename", e)
+            }
+        }
+        sourceMaps.register(filename, sourceMap)
+    }
+
     /**
      * Evaluate the given JS code without return value.
      */
@@ -755,6 +1203,108 @@ class JsBridge
         }
     }
 
+    // Called by TypedArrayKernelsExtension
+    internal fun registerTypedArrayKernels(globalName: String) {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniRegisterTypedArrayKernels(jniJsContext, globalName)
+        }
+    }
+
+    internal fun transferJsValue(jsValue: JsValue, otherJsBridge: JsBridge, transferList: JsValue?): JsValue {
+        val codeEvaluationDeferred = jsValue.codeEvaluationDeferred
+        val transferListEvaluationDeferred = transferList?.codeEvaluationDeferred
+
+        // Serialize in the JS thread of this instance...
+        val serializedDeferred = async {
+            codeEvaluationDeferred?.await()
+            transferListEvaluationDeferred?.await()
+            serializeJsValue(jsValue, transferList)
+        }
+
+        // ...and deserialize in the JS thread of the other one
+        var isDeserializing = false
+        val otherJsValue = JsValue(otherJsBridge)
+        otherJsValue.codeEvaluationDeferred = otherJsBridge.async {
+            val data = serializedDeferred.await()
+            val otherJniJsContext = otherJsBridge.jniJsContext
+                ?: throw JsValueEvaluationError(otherJsValue.associatedJsName, customMessage = "Cannot transfer JS value because the target JS interpreter has been destroyed")
+            isDeserializing = true
+            otherJsBridge.jniDeserializeJsValue(otherJniJsContext, otherJsValue.associatedJsName, data, true)
+        }.apply {
+            invokeOnCompletion {
+                // Other instance released or cancelled before receiving the value: release the
+                // serialized data in the JS thread of this instance
+                if (!isDeserializing) {
+                    this@JsBridge.launch {
+                        val data = try {
+                            serializedDeferred.await()
+                        } catch (t: Throwable) {
+                            return@launch  // nothing has been serialized
+                        }
+                        releaseSerializedJsValue(data)
+                    }
+                }
+            }
+        }
+
+        return otherJsValue
+    }
+
+    // Called by JsValue.writeJsonTo()
+    internal suspend fun writeJsValueJson(jsValue: JsValue, sink: (ByteBuffer) -> Unit) {
+        val codeEvaluationDeferred = jsValue.codeEvaluationDeferred
+
+        withContext(coroutineContext) {
+            codeEvaluationDeferred?.await()
+
+            val jniJsContext = jniJsContextOrThrow()
+            jniWriteJson(jniJsContext, jsValue.associatedJsName, jsonOutputBuffer, JsonOutput(jsonOutputBuffer, sink))
+        }
+    }
+
+    // Called by WorkerExtension and JsValue.transferTo()
+    // Serialize the given JS value so that it can be deserialized in another JsBridge instance
+    // (SharedArrayBuffers are only allowed when deserialized in the same process)
+    internal fun serializeJsValue(jsValue: JsValue, transferList: JsValue?, allowSharedArrayBuffers: Boolean = true): ByteArray {
+        checkJsThread()
+
+        val jniJsContext = jniJsContextOrThrow()
+        return jniSerializeJsValue(jniJsContext, jsValue.associatedJsName, transferList?.associatedJsName, allowSharedArrayBuffers)
+    }
+
+    // Called by WorkerExtension and resume()
+    // SharedArrayBuffers must only be allowed for values serialized by the current process (they
+    // are referenced by native pointers)
+    internal fun deserializeJsValue(data: ByteArray, allowSharedArrayBuffers: Boolean = true): JsValue {
+        checkJsThread()
+
+        val jsValue = JsValue(this)
+        val jniJsContext = jniJsContextOrThrow()
+        jniDeserializeJsValue(jniJsContext, jsValue.associatedJsName, data, allowSharedArrayBuffers)
+        return jsValue
+    }
+
+    // Called by XMLHttpRequestExtension and parseJson()
+    // Create the JS value of a tape returned by parseJsonTape()
+    internal fun jsonTapeToJsValue(tape: ByteArray): JsValue {
+        checkJsThread()
+
+        val jsValue = JsValue(this)
+        val jniJsContext = jniJsContextOrThrow()
+        jniAssignJsonTape(jniJsContext, jsValue.associatedJsName, tape)
+        return jsValue
+    }
+
+    // Called by WorkerExtension
+    // Release a serialized value which won't be deserialized (e.g. references to SharedArrayBuffers)
+    internal fun releaseSerializedJsValue(data: ByteArray) {
+        checkJsThread()
+
+        val jniJsContext = jniJsContextOrThrow()
+        jniReleaseSerializedJsValue(jniJsContext, data)
+    }
+
     // Notify all registered error listeners
     internal fun notifyErrorListeners(t: Throwable) {
         val e = t as? JsBridgeError ?: InternalError(t)
@@ -773,7 +1323,7 @@ class JsBridge
 
     // Create the JNI/JS context and return a Deferred which is rejected with a
     // JsBridgeError in case of error
-    private fun createJniJsContext(): Long {
+    private fun createJniJsContext(fastRelease: Boolean, canBlock: Boolean, builtIns: Int): Long {
         checkJsThread()
 
         if (!isLibraryLoaded) {
@@ -790,14 +1340,62 @@ class JsBridge
             isLibraryLoaded = true
         }
 
-        return jniCreateContext()
+        return jniCreateContext(fastRelease, canBlock, builtIns)
+    }
+
+    // Requested built-ins + those needed by the bridge and by the enabled extensions, as
+    // JsBridgeContext flags
+    private fun builtInFlags(config: JsBridgeConfig): Int {
+        val builtIns = config.runtimeConfig.builtIns.toMutableSet()
+
+        // Deferred values and suspend functions are converted from/to JS promises (QuickJS)
+        builtIns += JsBridgeConfig.RuntimeConfig.BuiltIn.Promise
+
+        if (config.compressionConfig.enabled) {
+            builtIns += JsBridgeConfig.RuntimeConfig.BuiltIn.TypedArrays
+        }
+        if (config.typedArrayKernelsConfig.enabled || config.workerConfig.enabled) {
+            builtIns += JsBridgeConfig.RuntimeConfig.BuiltIn.TypedArrays
+        }
+
+        return builtIns.fold(0) { flags, builtIn -> flags or (1 shl builtIn.ordinal) }
+    }
+
+    // Apply the priority and CPU affinity of the JS thread (a failure is not fatal)
+    private fun setUpJsThread(config: JsBridgeConfig.JsThreadConfig) {
+        checkJsThread()
+
+        val jniJsContext = jniJsContextOrThrow()
+
+        config.priority?.let { priority ->
+            try {
+                jniSetJsThreadPriority(jniJsContext, priority)
+            } catch (t: Throwable) {
+                Timber.w(t, "Cannot set the priority of the JS thread")
+            }
+        }
+
+        val cpus = if (config.dedicatedCore) {
+            val fastestCpus = getFastestCpus()
+            if (fastestCpus.isEmpty()) null else setOf(fastestCpus[dedicatedCoreCounter.getAndIncrement() % fastestCpus.size])
+        } else {
+            config.cpuAffinity
+        }
+
+        cpus?.let {
+            try {
+                jniSetJsThreadAffinity(jniJsContext, it.toIntArray())
+            } catch (t: Throwable) {
+                Timber.w(t, "Cannot set the CPU affinity of the JS thread")
+            }
+        }
     }
 
     @Suppress("UNUSED")  // Called from JNI
     private fun callJsModuleLoader(moduleName: String): String {
         // Note: it is perfectly fine if the function throws an exception
         // (it will be properly caught by JNI and thrown as a JS exception)
-        return jsModuleLoaderFunc!!(moduleName)
+        return jsModulePrefetcher?.load(moduleName) ?: jsModuleLoaderFunc!!(moduleName)
     }
 
     @Throws
@@ -835,6 +1433,20 @@ class JsBridge
             throw JsToJavaRegistrationError(type, Throwable("${obj.javaClass.name} is not an instance of $type"))
         }
 
+        // Reflected once per process (see JsInterfaceDescriptors)
+        val methods = JsInterfaceDescriptors.getJsToJavaMethods(type.java, apiInterface, customClassLoader) {
+            reflectJsToJavaMethods(type, apiInterface)
+        }
+
+        try {
+            jniRegisterJavaObject(jniJsContext, jsValue.associatedJsName, obj, methods.toTypedArray())
+        } catch (t: Throwable) {
+            throw JsToJavaRegistrationError(type, t)
+        }
+    }
+
+    @Throws(JsToJavaRegistrationError::class)
+    private fun reflectJsToJavaMethods(type: KClass<*>, apiInterface: Class<*>): List<Method> {
         val methods = linkedMapOf<String, Method>()
 
         try {
@@ -862,11 +1474,7 @@ class JsBridge
             }
         }
 
-        try {
-            jniRegisterJavaObject(jniJsContext, jsValue.associatedJsName, obj, methods.values.toTypedArray())
-        } catch (t: Throwable) {
-            throw JsToJavaRegistrationError(type, t)
-        }
+        return methods.values.toList()
     }
 
     private fun findApiInterface(clazz: Class<*>): Class<*>? {
@@ -915,24 +1523,27 @@ class JsBridge
                 .takeIf { it != JavaToJsInterface::class }
         }
 
-        val methods = interfaces
-            // Collect all member functions of all interfaces
-            // -> Sequence<KFunction<*>>
-            .flatMap { it.declaredMemberFunctions.asSequence() }
-
-            // Group by name
-            // -> Map<methodName, List<Method>>
-            .groupBy({ it.name }, { Method(it, false, customClassLoader) })
-
-            // Map to unique value
-            // -> Map<methodName, Method>
-            .mapValues {  entry ->
-                entry.value.singleOrNull()
-                        ?: throw JavaToJsInterfaceRegistrationError(type, Throwable("${entry.key} is overloaded in $type"))
-            }
+        // Reflected once per process (see JsInterfaceDescriptors)
+        val methods = JsInterfaceDescriptors.getJavaToJsMethods(type.java, customClassLoader) {
+            interfaces
+                // Collect all member functions of all interfaces
+                // -> Sequence<KFunction<*>>
+                .flatMap { it.declaredMemberFunctions.asSequence() }
+
+                // Group by name
+                // -> Map<methodName, List<Method>>
+                .groupBy({ it.name }, { Method(it, false, customClassLoader) })
+
+                // Map to unique value
+                // -> Map<methodName, Method>
+                .mapValues {  entry ->
+                    entry.value.singleOrNull()
+                            ?: throw JavaToJsInterfaceRegistrationError(type, Throwable("${entry.key} is overloaded in $type"))
+                }
 
-            // => Sequence<Method>
-            .values
+                // => List<Method>
+                .values.toList()
+        }
 
         if (waitForRegistration) {
             // Synchronous registration
@@ -1093,6 +1704,9 @@ class JsBridge
         notifyErrorListeners(e)
     }
 
+    @Suppress("UNUSED")  // Called from JNI
+    private fun getJsSourceMaps(): JsSourceMaps? = if (sourceMaps.isEmpty()) null else sourceMaps
+
     private fun launchInJsThread(block: suspend () -> Unit) {
         launch {
             block()
@@ -1129,12 +1743,17 @@ class JsBridge
 
 
     // JNI functions
-    private external fun jniCreateContext(): Long
+    private external fun jniCreateContext(fastRelease: Boolean, canBlock: Boolean, builtIns: Int): Long
     private external fun jniStartDebugger(context: Long, port: Int)
     private external fun jniCancelDebug(context: Long)
     private external fun jniDeleteContext(context: Long)
     private external fun jniEnableModuleLoader(context: Long)
     private external fun jniGetCurrentScriptOrModuleName(context: Long, level: Int): String
+    private external fun jniRegisterTypedArrayKernels(context: Long, globalName: String)
+    private external fun jniRegisterNativeExtension(context: Long, libraryName: String, entryPoint: String)
+    private external fun jniSetJsThreadPriority(context: Long, priority: Int)
+    private external fun jniSetJsThreadAffinity(context: Long, cpus: IntArray)
+    private external fun jniGetJsThreadPlacement(context: Long): IntArray
     private external fun jniEvaluateString(context: Long, js: String, type: Parameter?, awaitJsPromise: Boolean): Any?
     private external fun jniEvaluateFileContent(context: Long, js: String, filename: String, asModule: Boolean)
     private external fun jniRegisterJavaLambda(context: Long, name: String, obj: Any, method: Any)
@@ -1147,10 +1766,23 @@ class JsBridge
     private external fun jniAssignJsValue(context: Long, globalName: String, jsCode: String)
     private external fun jniDeleteJsValue(context: Long, globalName: String)
     private external fun jniCopyJsValue(context: Long, globalNameTo: String, globalNameFrom: String)
+    private external fun jniSerializeJsValue(context: Long, globalName: String, transferListGlobalName: String?, allowSharedArrayBuffers: Boolean): ByteArray
+    private external fun jniDeserializeJsValue(context: Long, globalName: String, data: ByteArray, allowSharedArrayBuffers: Boolean)
+    private external fun jniReleaseSerializedJsValue(context: Long, data: ByteArray)
+    private external fun jniAssignJsonTape(context: Long, globalName: String, tape: ByteArray)
+    private external fun jniAssignNativeJsonTape(context: Long, globalName: String, tape: Long)
+    private external fun jniWriteJson(context: Long, globalName: String, buffer: ByteBuffer, output: JsonOutput)
     private external fun jniNewJsFunction(context: Long, globalName: String, functionArgs: Array<String>, jsCode: String)
     private external fun jniConvertJavaValueToJs(context: Long, globalName: String, value: Any?, parameter: Parameter)
     private external fun jniCompleteJsPromise(context: Long, id: String, isFulfilled: Boolean, value: Any)
     private external fun jniProcessPromiseQueue(context: Long)
+    private external fun jniReclaimMemory(context: Long, aggressive: Boolean): Long
+    private external fun jniGetBaselineHeapSize(context: Long): Long
+    private external fun jniInvalidateJavaMethodCaches(context: Long)
+    private external fun jniEnableJavaStringPool(context: Long, maxEntries: Int, maxLength: Int)
+    private external fun jniGetJavaStringPoolStats(context: Long): LongArray?
+    private external fun jniStartEngineProfiling(context: Long)
+    private external fun jniStopEngineProfiling(context: Long, maxFunctions: Int): String
 
     @Suppress("UNUSED_PARAMETER")
     private fun handleCoroutineException(context: CoroutineContext, t: Throwable) {
@@ -1,6 +1,8 @@
 package de.prosiebensat1digital.oasisjsbridge
 
 import android.util.Log
+import java.io.File
+import java.util.zip.Deflater
 import okhttp3.OkHttpClient
 
 class JsBridgeConfig
@@ -13,7 +15,8 @@ private constructor() {
         fun bareConfig() = JsBridgeConfig()
 
         /**
-         * Creates an instance of JsBridgeConfig and enables all extensions.
+         * Creates an instance of JsBridgeConfig and enables all extensions (except compression,
+         * typed array kernels and workers which must be explicitly enabled).
          * @param localStorageNamespace arbitrary string for separation of local storage between
          * multiple JsBridge instances. If you use the same namespace for multiple instances of
          * JsBridge there might be collisions if identical keys are used to store values.
@@ -37,6 +40,11 @@ private constructor() {
     val consoleConfig = ConsoleConfig()
     val jsDebuggerConfig = JsDebuggerConfig()
     val localStorageConfig = LocalStorageConfig()
+    val compressionConfig = CompressionConfig()
+    val typedArrayKernelsConfig = TypedArrayKernelsConfig()
+    val workerConfig = WorkerConfig()
+    val runtimeConfig = RuntimeConfig()
+    val jsThreadConfig = JsThreadConfig()
     val jvmConfig = JvmConfig()
 
     class SetTimeoutExtensionConfig {
@@ -47,6 +55,16 @@ private constructor() {
         var enabled: Boolean = false
         var okHttpClient: OkHttpClient? = null
         var userAgent: String? = null
+
+        // Directory of the on-disk HTTP cache (ETag, Last-Modified, max-age...), shared by all the
+        // JsBridge instances using the same directory. null = no cache (unless the given
+        // okHttpClient has its own cache).
+        var cacheDirectory: File? = null
+        var cacheMaxSize: Long = 10L * 1024 * 1024
+
+        // Identical GET requests which are sent while a previous one is still in progress (with
+        // the same okHttpClient) share its response instead of hitting the network again
+        var deduplicateRequests: Boolean = false
     }
 
     class PromiseConfig {
@@ -77,6 +95,102 @@ private constructor() {
         var namespace: String = ""
     }
 
+    class CompressionConfig {
+        var enabled: Boolean = false
+
+        // Default compression level (0-9) when not given by JS
+        var level: Int = Deflater.DEFAULT_COMPRESSION
+
+        // Inputs with at least this size (in bytes) are (de)compressed outside of the JS thread
+        var asyncThreshold: Int = 64 * 1024
+
+        // Decompressing a larger output (in bytes) fails, e.g. for "zip bombs"
+        var maxDecompressedSize: Int = 64 * 1024 * 1024
+    }
+
+    class TypedArrayKernelsConfig {
+        var enabled: Boolean = false
+    }
+
+    class WorkerConfig {
+        var enabled: Boolean = false
+
+        // Returns the content of the module given to "new Worker(moduleName)". When not set, the
+        // module loader of the JsBridge (see JsBridge.setJsModuleLoader()) is used.
+        var moduleLoader: ((moduleName: String) -> String)? = null
+
+        // Creates the config of the JsBridge instance running each worker
+        var workerJsBridgeConfig: () -> JsBridgeConfig = {
+            bareConfig().apply {
+                setTimeoutConfig.enabled = true
+                promiseConfig.enabled = true
+                consoleConfig.enabled = true
+            }
+        }
+
+        // Maximum number of workers running at the same time
+        var maxWorkers: Int = 4
+    }
+
+    class RuntimeConfig {
+        // Discard the whole JS heap on release instead of finalizing each JS value (QuickJS only).
+        // Speeds up the release of large JsBridge instances at the cost of 16 bytes per allocation.
+        var fastRelease: Boolean = false
+
+        // Optional built-in JS objects installed in the context. Base objects (Object, Function,
+        // Array, Error, Number, String, Symbol, Math, JSON...) are always available, as well as the
+        // built-ins needed by the bridge itself (QuickJS Promise, for Deferred values and suspend
+        // functions) and by the enabled extensions. Smaller sets speed up the context creation and
+        // reduce its baseline memory (QuickJS), see JsBridge.contextCreationStats.
+        // With Duktape, the built-ins which are not selected are only removed from the global
+        // object: they can still be reached via existing values (e.g. /x/.constructor) so that
+        // this must not be used as a sandbox.
+        var builtIns: Set<BuiltIn> = BuiltIn.ALL
+
+        // Allow Atomics.wait() to block the JS thread (QuickJS only). Only set for the JsBridge
+        // instances running workers: in the main JsBridge, Atomics.wait() throws instead of stalling
+        // all the pending calls.
+        internal var canBlock: Boolean = false
+
+        // Maximum number of pooled Java strings (0 = no pool). JS strings up to
+        // javaStringPoolMaxLength bytes converted to Java (e.g. enum-like values, keys or event
+        // names) are then only created once in the JVM, which saves allocations and GC work when
+        // the same strings keep crossing the bridge. See JsBridge.getJavaStringPoolStats().
+        var javaStringPoolSize: Int = 0
+        var javaStringPoolMaxLength: Int = 64
+
+        // Must match the BuiltIn flags of JsBridgeContext (JNI)
+        enum class BuiltIn {
+            Date,
+            RegExp,
+            Eval,  // global eval() function
+            Proxy,  // Proxy and Reflect with Duktape (Reflect is a base object with QuickJS)
+            MapSet,  // Map, Set, WeakMap, WeakSet (QuickJS only)
+            TypedArrays,  // ArrayBuffer, typed arrays and DataView (needed for byte arrays)
+            Promise,  // native Promise (always installed with QuickJS), polyfill via promiseConfig (Duktape)
+            StringNormalize;  // String.prototype.normalize() (QuickJS only)
+
+            companion object {
+                @JvmField
+                val ALL: Set<BuiltIn> = values().toSet()
+
+                @JvmField
+                val MINIMAL: Set<BuiltIn> = emptySet()
+            }
+        }
+    }
+
+    class JsThreadConfig {
+        // Linux nice value of the JS thread (-20..19, e.g. Process.THREAD_PRIORITY_DISPLAY),
+        // null = default priority
+        var priority: Int? = null
+        // CPUs the JS thread is allowed to run on (e.g. the big cores), null = all CPUs
+        var cpuAffinity: Set<Int>? = null
+        // Pin the JS thread to one of the fastest cores (highest max frequency), overriding
+        // cpuAffinity. JsBridge instances with a dedicated core are spread over the fastest cores.
+        var dedicatedCore: Boolean = false
+    }
+
     class JvmConfig {
         var customClassLoader: ClassLoader? = null
     }
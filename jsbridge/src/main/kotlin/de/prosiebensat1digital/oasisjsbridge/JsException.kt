@@ -18,10 +18,26 @@
  */
 package de.prosiebensat1digital.oasisjsbridge
 
+import java.io.PrintStream
+import java.io.PrintWriter
 import timber.log.Timber
 
 @Suppress("UNUSED")  // Called from JNI
-class JsException(val jsonValue: String? = null, detailedMessage: String, jsStackTrace: String?, cause: Throwable?) : RuntimeException(detailedMessage, cause) {
+class JsException internal constructor(
+    val jsonValue: String?,
+    detailedMessage: String,
+    jsStackTrace: String?,
+    cause: Throwable?,
+    sourceMaps: JsSourceMaps?
+) : RuntimeException(detailedMessage, cause) {
+
+    constructor(jsonValue: String? = null, detailedMessage: String, jsStackTrace: String?, cause: Throwable?)
+        : this(jsonValue, detailedMessage, jsStackTrace, cause, null)
+
+    // Source maps used to resolve the first jsStackTraceSize elements of the stack trace when it
+    // is accessed for the first time (null when already resolved)
+    private var pendingSourceMaps: JsSourceMaps? = null
+    private var jsStackTraceSize = 0
 
     init {
         Timber.v("JsException() - detailedMessage = $detailedMessage")
@@ -29,10 +45,45 @@ class JsException(val jsonValue: String? = null, detailedMessage: String, jsStac
         Timber.v("JsException() - cause = $cause")
 
         // Parses `StackTraceElement`s from `jsStackTrace` and prepend them to the Java stack trace
-        stackTrace = jsStackTrace.orEmpty().split('\n')
+        val jsStackTraceElements = jsStackTrace.orEmpty().split('\n')
             .mapNotNull(::toStackTraceElement)
+        stackTrace = jsStackTraceElements
             .plus(stackTrace)
             .toTypedArray()
+
+        if (sourceMaps != null && jsStackTraceElements.any { sourceMaps.hasSourceMap(it.fileName) }) {
+            jsStackTraceSize = jsStackTraceElements.size
+            pendingSourceMaps = sourceMaps
+        }
+    }
+
+    override fun getStackTrace(): Array<StackTraceElement> {
+        resolveJsStackTrace()
+        return super.getStackTrace()
+    }
+
+    override fun printStackTrace(s: PrintStream) {
+        resolveJsStackTrace()
+        super.printStackTrace(s)
+    }
+
+    override fun printStackTrace(s: PrintWriter) {
+        resolveJsStackTrace()
+        super.printStackTrace(s)
+    }
+
+    // Map the JS stack trace elements to their original locations. This is only done on demand
+    // because most exceptions are handled without reading their stack trace.
+    @Synchronized
+    private fun resolveJsStackTrace() {
+        val sourceMaps = pendingSourceMaps ?: return
+        pendingSourceMaps = null
+
+        val elements = super.getStackTrace()
+        for (i in 0 until minOf(jsStackTraceSize, elements.size)) {
+            elements[i] = sourceMaps.resolve(elements[i])
+        }
+        stackTrace = elements
     }
 
     companion object {
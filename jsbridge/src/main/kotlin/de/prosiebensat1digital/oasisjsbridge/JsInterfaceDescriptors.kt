@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.util.concurrent.ConcurrentHashMap
+
+// Process-wide cache of the reflected methods of the registered interfaces, shared by all the
+// JsBridge instances (and threads).
+//
+// Reflecting an interface (especially with Kotlin reflection) is much slower than registering it
+// and the resulting Method and Parameter instances are immutable, so each interface is only
+// reflected once per class loader. The native type of each Parameter is also only resolved once
+// (see JavaTypeProvider::getJavaTypeId()). Reflection errors are not cached.
+//
+// The interfaces are expected to be static APIs: the cached classes are never unloaded.
+internal object JsInterfaceDescriptors {
+    private data class Key(val type: Class<*>, val apiInterface: Class<*>?, val customClassLoader: ClassLoader?)
+
+    private val jsToJavaMethods = ConcurrentHashMap<Key, List<Method>>()
+    private val javaToJsMethods = ConcurrentHashMap<Key, List<Method>>()
+
+    // Methods of a Java/Kotlin object registered via JsValue.createJsToJavaProxy() (apiInterface:
+    // the JsToJavaInterface implemented by the object class)
+    fun getJsToJavaMethods(type: Class<*>, apiInterface: Class<*>, customClassLoader: ClassLoader?, reflect: () -> List<Method>): List<Method> {
+        return getOrReflect(jsToJavaMethods, Key(type, apiInterface, customClassLoader), reflect)
+    }
+
+    // Methods of a JS object registered via JsValue.createJavaToJsProxy()
+    fun getJavaToJsMethods(type: Class<*>, customClassLoader: ClassLoader?, reflect: () -> List<Method>): List<Method> {
+        return getOrReflect(javaToJsMethods, Key(type, null, customClassLoader), reflect)
+    }
+
+    private fun getOrReflect(cache: ConcurrentHashMap<Key, List<Method>>, key: Key, reflect: () -> List<Method>): List<Method> {
+        cache[key]?.let { return it }
+
+        // Concurrent reflections of the same interface are harmless: the first result is kept
+        val methods = reflect()
+        return cache.putIfAbsent(key, methods) ?: methods
+    }
+}
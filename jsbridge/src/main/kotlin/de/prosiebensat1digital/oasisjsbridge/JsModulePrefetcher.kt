@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.runBlocking
+
+// Loads the modules of a module graph concurrently, ahead of the (synchronous) module loader of the
+// JS engine. The imports of each loaded module (including the string literals given to import())
+// are scanned in an I/O thread and loaded in turn, so that the JS thread only compiles, links and
+// evaluates the modules instead of waiting for each source one after the other.
+//
+// Prefetched sources which have not been requested by the JS engine when the evaluation of a module
+// is over (e.g. modules only imported dynamically in some code paths) are evicted.
+internal class JsModulePrefetcher(
+    private val scope: CoroutineScope,
+    private val loader: (moduleName: String) -> String
+) {
+    private val lock = Any()
+
+    // Sources which are being loaded or have not been requested by the JS engine yet
+    private val pendingSources = HashMap<String, Deferred<String>>()  // guarded by lock
+
+    // Modules already requested by the JS engine (which keeps them)
+    private val requestedModuleNames = HashSet<String>()  // guarded by lock
+
+    private var isReleased = false  // guarded by lock
+
+    // Start loading the modules imported by the given module source (must be called after the JNI
+    // library has been loaded)
+    fun prefetchImports(source: String, moduleName: String) {
+        JsBridge.scanModuleImports(source, moduleName).forEach(::prefetch)
+    }
+
+    // Start loading the given (normalized) module and its imports
+    fun prefetch(moduleName: String) = synchronized(lock) {
+        if (isReleased || requestedModuleNames.contains(moduleName) || pendingSources.containsKey(moduleName)) {
+            return
+        }
+
+        pendingSources[moduleName] = scope.async(Dispatchers.IO) {
+            loader(moduleName).also { source ->
+                // Not needed anymore if evicted in the meantime
+                if (isActive) prefetchImports(source, moduleName)
+            }
+        }
+    }
+
+    // Called by the module loader of the JS engine (in the JS thread). Only waits for the requested
+    // module, the other ones keep loading in the meantime.
+    fun load(moduleName: String): String {
+        val deferredSource = synchronized(lock) {
+            requestedModuleNames.add(moduleName)
+            pendingSources.remove(moduleName)
+        }
+
+        if (deferredSource == null) {
+            val source = loader(moduleName)
+            scope.launch(Dispatchers.IO) { prefetchImports(source, moduleName) }
+            return source
+        }
+
+        return runBlocking { deferredSource.await() }
+    }
+
+    // Called (in the JS thread) when the evaluation of a module is over: drop the sources which have
+    // not been requested by the JS engine
+    fun evictPendingSources() {
+        val evictedSources = synchronized(lock) {
+            pendingSources.values.toList().also { pendingSources.clear() }
+        }
+        evictedSources.forEach { it.cancel() }
+    }
+
+    fun release() {
+        synchronized(lock) {
+            isReleased = true
+        }
+        evictPendingSources()
+    }
+}
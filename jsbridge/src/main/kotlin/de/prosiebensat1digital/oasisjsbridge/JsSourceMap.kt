@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.util.concurrent.ConcurrentHashMap
+import org.json.JSONObject
+
+// Source map (revision 3) of an evaluated JS file. The mappings are decoded into a native index
+// and each generated line is only resolved once.
+//
+// Stack traces have no column numbers: lines whose segments map to several original lines (e.g.
+// a bundle minified into a single line) cannot be resolved and are left unmapped.
+//
+// The native index must be deleted via close(); lines which have not been resolved yet are not
+// mapped anymore afterwards.
+internal class JsSourceMap private constructor(
+    private val sources: List<String>,
+    private val names: List<String>,
+    private var nativeSourceMap: Long  // 0 once closed, guarded by this
+) {
+    data class Location(val source: String, val lineNumber: Int, val name: String?)
+
+    private val resolvedLines = ConcurrentHashMap<Int, Any>()
+
+    companion object {
+        // Cached as a ConcurrentHashMap value for unmapped lines
+        private val UNMAPPED = Any()
+
+        // Throws IllegalArgumentException (or JSONException) if the source map is invalid
+        fun parse(json: String): JsSourceMap {
+            val jsonSourceMap = JSONObject(json)
+            if (jsonSourceMap.optInt("version") != 3) {
+                throw IllegalArgumentException("Unsupported source map version: ${jsonSourceMap.opt("version")}")
+            }
+            if (jsonSourceMap.has("sections")) {
+                throw IllegalArgumentException("Indexed source maps are not supported")
+            }
+
+            val sourceRoot = jsonSourceMap.optString("sourceRoot").let {
+                if (it.isEmpty() || it.endsWith('/')) it else "$it/"
+            }
+            val jsonSources = jsonSourceMap.getJSONArray("sources")
+            val sources = (0 until jsonSources.length()).map { sourceRoot + jsonSources.getString(it) }
+            val jsonNames = jsonSourceMap.optJSONArray("names")
+            val names = (0 until (jsonNames?.length() ?: 0)).map { jsonNames!!.getString(it) }
+
+            val nativeSourceMap = JsBridge.decodeSourceMap(jsonSourceMap.getString("mappings"))
+            return JsSourceMap(sources, names, nativeSourceMap)
+        }
+    }
+
+    // Resolve the given 1-based line number of the generated file
+    fun resolve(lineNumber: Int): Location? {
+        val location = resolvedLines.getOrPut(lineNumber) {
+            val mapping = synchronized(this) {
+                if (nativeSourceMap == 0L) return null
+                JsBridge.resolveSourceMapLocation(nativeSourceMap, lineNumber - 1, -1)
+            }
+            val source = mapping?.let { sources.getOrNull(it[0]) }
+            if (mapping == null || source == null) {
+                UNMAPPED
+            } else {
+                Location(source, mapping[1] + 1, names.getOrNull(mapping[3]))
+            }
+        }
+        return location as? Location
+    }
+
+    // Delete the native index (cannot be done in finalize() as it might run while a resolution
+    // is still using it)
+    fun close() = synchronized(this) {
+        if (nativeSourceMap != 0L) {
+            JsBridge.deleteSourceMap(nativeSourceMap)
+            nativeSourceMap = 0L
+        }
+    }
+}
+
+// Source maps registered for a JsBridge, by (generated) file name
+internal class JsSourceMaps {
+    private val sourceMaps = ConcurrentHashMap<String, JsSourceMap>()
+
+    fun register(fileName: String, sourceMap: JsSourceMap) {
+        sourceMaps.put(fileName, sourceMap)?.close()
+    }
+
+    fun release() {
+        sourceMaps.values.forEach(JsSourceMap::close)
+        sourceMaps.clear()
+    }
+
+    fun isEmpty() = sourceMaps.isEmpty()
+
+    fun hasSourceMap(fileName: String?) = fileName != null && sourceMaps.containsKey(fileName)
+
+    // Map the given JS stack trace element to its original location
+    fun resolve(element: StackTraceElement): StackTraceElement {
+        val sourceMap = sourceMaps[element.fileName ?: return element] ?: return element
+        val location = sourceMap.resolve(element.lineNumber) ?: return element
+        return StackTraceElement(element.className, location.name ?: element.methodName, location.source, location.lineNumber)
+    }
+}
@@ -17,3 +17,18 @@ package de.prosiebensat1digital.oasisjsbridge
 
 interface JsToJavaInterface
 
+/**
+ * Marks a method of a JsToJavaInterface as cacheable: its results are memoized natively, keyed by
+ * the JS arguments, and repeated calls from JS are answered without calling the Java method.
+ *
+ * Only use it for pure methods (e.g. config lookups, feature flags, formatting). Only calls with
+ * primitive arguments (null, undefined, boolean, number, string) returning a primitive value are
+ * cached. The caches can be cleared with JsBridge.invalidateJavaMethodCaches().
+ *
+ * @param maxEntries maximum number of cached results (the least recently used one is evicted)
+ * @param ttlMs time-to-live of a cached result in milliseconds (0: until invalidated)
+ */
+@Target(AnnotationTarget.FUNCTION)
+@Retention(AnnotationRetention.RUNTIME)
+annotation class JsCacheable(val maxEntries: Int = 64, val ttlMs: Long = 0L)
+
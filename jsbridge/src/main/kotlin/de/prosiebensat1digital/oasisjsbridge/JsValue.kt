@@ -17,7 +17,11 @@ package de.prosiebensat1digital.oasisjsbridge
 
 import de.prosiebensat1digital.oasisjsbridge.JsBridgeError.*
 import kotlinx.coroutines.*
+import java.io.FileOutputStream
+import java.io.OutputStream
+import java.io.Writer
 import java.lang.ref.WeakReference
+import java.nio.channels.Channels
 import java.util.concurrent.atomic.AtomicInteger
 import kotlin.reflect.typeOf
 import kotlin.coroutines.CoroutineContext
@@ -250,6 +254,54 @@ internal constructor(
         jsBridge?.copyJsValue(globalName, this@JsValue)
     }
 
+    /**
+     * Copy this JS value into another JsBridge instance (structured clone with QuickJS, JSON with
+     * Duktape) and return the new JsValue of the other instance.
+     *
+     * The value is serialized in the JS thread of this instance and deserialized in the JS thread
+     * of the other one, without converting it to Java objects. ArrayBuffers given in the transfer
+     * list (JS array) are detached from this instance.
+     */
+    fun transferTo(otherJsBridge: JsBridge, transferList: JsValue? = null): JsValue {
+        val jsBridge = jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot transfer JS value because the JS interpreter has been destroyed")
+
+        return jsBridge.transferJsValue(this@JsValue, otherJsBridge, transferList)
+    }
+
+    /**
+     * Write the JSON representation of the JS value (same as JSON.stringify()) as UTF-8 into the
+     * given output stream, which is not closed.
+     *
+     * The JSON string is never built as a whole: it is serialized in chunks into a reusable
+     * native buffer which is written into the output stream from the JS thread.
+     */
+    suspend fun writeJsonTo(outputStream: OutputStream) {
+        val jsBridge = jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot write JS value because the JS interpreter has been destroyed")
+
+        // A FileChannel directly writes the direct buffer
+        val channel = (outputStream as? FileOutputStream)?.channel ?: Channels.newChannel(outputStream)
+        jsBridge.writeJsValueJson(this@JsValue) { buffer ->
+            while (buffer.hasRemaining()) {
+                channel.write(buffer)
+            }
+        }
+    }
+
+    /**
+     * Same as writeJsonTo(OutputStream) but for a Writer, which is not closed.
+     */
+    suspend fun writeJsonTo(writer: Writer) {
+        val jsBridge = jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot write JS value because the JS interpreter has been destroyed")
+
+        jsBridge.writeJsValueJson(this@JsValue) { buffer ->
+            // Chunks only contain complete UTF-8 sequences
+            writer.append(Charsets.UTF_8.decode(buffer))
+        }
+    }
+
     @OptIn(ExperimentalStdlibApi::class)
     suspend inline fun <reified T: Any?> evaluate(): T {
         val jsBridge = jsBridge
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.nio.ByteBuffer
+
+// Receives the JSON chunks written by the native JsonWriter into the given direct buffer
+// (see JsValue.writeJsonTo())
+internal class JsonOutput(private val buffer: ByteBuffer, private val sink: (ByteBuffer) -> Unit) {
+    @Suppress("UNUSED")  // Called from JNI
+    fun write(length: Int) {
+        buffer.clear()
+        buffer.limit(length)
+        sink(buffer)
+    }
+}
@@ -42,6 +42,15 @@ internal class Method {
     @Suppress("UNUSED")  // Called from JNI
     val isVarArgs: Boolean
 
+    // Result cache of @JsCacheable methods (0: not cacheable)
+    @Suppress("UNUSED")  // Called from JNI
+    val cacheMaxEntries: Int
+        get() = javaMethod?.getAnnotation(JsCacheable::class.java)?.maxEntries?.coerceAtLeast(0) ?: 0
+
+    @Suppress("UNUSED")  // Called from JNI
+    val cacheTtlMs: Long
+        get() = javaMethod?.getAnnotation(JsCacheable::class.java)?.ttlMs ?: 0L
+
     // KFunction with full reflection information
     constructor(kotlinFunction: KFunction<*>, isLambda: Boolean, customClassLoader: ClassLoader?) {
         this.name = kotlinFunction.name
@@ -68,6 +68,20 @@ internal open class Parameter private constructor(
         return javaClass?.name
     }
 
+    // Native JavaTypeId, resolved once by JNI (0: not resolved yet)
+    @Volatile
+    private var javaTypeId = 0
+
+    @Suppress("UNUSED")  // Called from JNI
+    fun getJavaTypeId(): Int {
+        return javaTypeId
+    }
+
+    @Suppress("UNUSED")  // Called from JNI
+    fun setJavaTypeId(id: Int) {
+        javaTypeId = id
+    }
+
     @Suppress("UNUSED")  // Called from JNI
     fun isNullable(): Boolean {
         return kotlinType?.isMarkedNullable == true
@@ -118,13 +132,17 @@ internal open class Parameter private constructor(
     // - if the parameter is an Array, return the array componet
     @Suppress("UNUSED")  // Called from JNI
     fun getGenericParameter(): Parameter? {
+        return genericParameter
+    }
+
+    private val genericParameter: Parameter? by lazy {
         val javaComponentType = javaClass?.componentType
         if (javaComponentType?.isPrimitive == true) {
             // Primitives (for arrays) are always given by the Java component type
-            return Parameter(javaComponentType, customClassLoader)
+            return@lazy Parameter(javaComponentType, customClassLoader)
         }
 
-        return if (kotlinType == null) {
+        if (kotlinType == null) {
             if (javaComponentType == null) {
                 // No type information => using generic Object type
                 Parameter(Any::class.java, customClassLoader)
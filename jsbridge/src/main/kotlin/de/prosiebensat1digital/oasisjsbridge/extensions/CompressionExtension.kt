@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.extensions
+
+import de.prosiebensat1digital.oasisjsbridge.*
+import java.io.ByteArrayInputStream
+import java.io.ByteArrayOutputStream
+import java.io.InputStream
+import java.util.zip.*
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+
+// Native gzip/deflate (de)compression for JS code, backed by the zlib implementation of the
+// platform (java.util.zip).
+//
+// Payloads are exchanged as Uint8Array (ArrayBuffer and typed arrays are copied in bulk when
+// converted to ByteArray). Inputs larger than config.asyncThreshold are processed in a background
+// thread and the JS promise is completed in the JS thread. Decompressed outputs are limited to
+// config.maxDecompressedSize bytes.
+internal class CompressionExtension(
+    private val jsBridge: JsBridge,
+    val config: JsBridgeConfig.CompressionConfig
+) {
+    init {
+        // Register CompressionExtension_process_java() and CompressionExtension_processAsync_java()
+        JsValue.createJsToJavaProxyFunction4(jsBridge, ::javaProcess)
+            .assignToGlobal("CompressionExtension_process_java")
+        JsValue.createJsToJavaProxyFunction4(jsBridge, ::javaProcessAsync)
+            .assignToGlobal("CompressionExtension_processAsync_java")
+
+        // Evaluate JS file
+        jsBridge.evaluateUnsync(compressionJsCode)
+    }
+
+    fun release() {
+        jsBridge.evaluateUnsync("""delete globalThis["CompressionExtension_process_java"]""")
+        jsBridge.evaluateUnsync("""delete globalThis["CompressionExtension_processAsync_java"]""")
+        jsBridge.evaluateUnsync("""delete globalThis["compression"]""")
+    }
+
+    private fun javaProcess(operation: String, format: String, level: Int?, data: ByteArray): ByteArray {
+        return process(operation, format, level ?: config.level, data)
+    }
+
+    private fun javaProcessAsync(operation: String, format: String, level: Int?, data: ByteArray): Deferred<ByteArray> {
+        if (data.size < config.asyncThreshold) {
+            return try {
+                CompletableDeferred(process(operation, format, level ?: config.level, data))
+            } catch (t: Throwable) {
+                CompletableDeferred<ByteArray>().apply { completeExceptionally(t) }
+            }
+        }
+
+        return jsBridge.async(Dispatchers.Default) {
+            process(operation, format, level ?: config.level, data)
+        }
+    }
+
+    private fun process(operation: String, format: String, level: Int, data: ByteArray): ByteArray {
+        return when (operation) {
+            "compress" -> compress(format, level, data)
+            "decompress" -> decompress(format, data)
+            else -> throw IllegalArgumentException("Unsupported compression operation: $operation")
+        }
+    }
+
+    private fun compress(format: String, level: Int, data: ByteArray): ByteArray {
+        val deflater = when (format) {
+            "gzip", "deflate-raw" -> Deflater(level, true)
+            "deflate" -> Deflater(level, false)
+            else -> throw IllegalArgumentException("Unsupported compression format: $format")
+        }
+
+        try {
+            val outputStream = ByteArrayOutputStream(data.size / 2 + 64)
+
+            if (format == "gzip") {
+                // GZIPOutputStream does not allow setting the compression level so we write the
+                // gzip header and trailer around the raw deflate stream ourselves
+                outputStream.write(GZIP_HEADER)
+                DeflaterOutputStream(outputStream, deflater, BUFFER_SIZE).apply {
+                    write(data)
+                    finish()
+                }
+
+                val crc = CRC32().apply { update(data) }.value
+                writeIntLE(outputStream, crc.toInt())
+                writeIntLE(outputStream, data.size)
+            } else {
+                DeflaterOutputStream(outputStream, deflater, BUFFER_SIZE).apply {
+                    write(data)
+                    finish()
+                }
+            }
+
+            return outputStream.toByteArray()
+        } finally {
+            deflater.end()
+        }
+    }
+
+    private fun decompress(format: String, data: ByteArray): ByteArray {
+        val inputStream = ByteArrayInputStream(data)
+
+        return when (format) {
+            "gzip" -> GZIPInputStream(inputStream, BUFFER_SIZE).use { readAll(it, data.size) }
+            "deflate", "deflate-raw" -> {
+                val inflater = Inflater(format == "deflate-raw")
+                try {
+                    InflaterInputStream(inputStream, inflater, BUFFER_SIZE).use { readAll(it, data.size) }
+                } finally {
+                    inflater.end()
+                }
+            }
+            else -> throw IllegalArgumentException("Unsupported compression format: $format")
+        }
+    }
+
+    private fun readAll(inputStream: InputStream, compressedSize: Int): ByteArray {
+        val maxSize = config.maxDecompressedSize
+        val outputStream = ByteArrayOutputStream(minOf(compressedSize.toLong() * 4, maxSize.toLong()).toInt())
+        val buffer = ByteArray(BUFFER_SIZE)
+        while (true) {
+            val readCount = inputStream.read(buffer)
+            if (readCount < 0) break
+
+            if (readCount > maxSize - outputStream.size()) {
+                throw IllegalArgumentException("Decompressed data exceeds the maximum size of $maxSize bytes")
+            }
+            outputStream.write(buffer, 0, readCount)
+        }
+        return outputStream.toByteArray()
+    }
+
+    private fun writeIntLE(outputStream: ByteArrayOutputStream, i: Int) {
+        outputStream.write(i and 0xff)
+        outputStream.write((i shr 8) and 0xff)
+        outputStream.write((i shr 16) and 0xff)
+        outputStream.write((i shr 24) and 0xff)
+    }
+
+    companion object {
+        private const val BUFFER_SIZE = 16 * 1024
+
+        // Magic number, CM = deflate, FLG = 0, MTIME = 0, XFL = 0, OS = unknown
+        private val GZIP_HEADER = byteArrayOf(0x1f, 0x8b.toByte(), 8, 0, 0, 0, 0, 0, 0, 0xff.toByte())
+    }
+}
+
+const val compressionJsCode: String = """
+(function() {
+  var processJava = CompressionExtension_process_java;
+  var processAsyncJava = CompressionExtension_processAsync_java;
+
+  function checkFormat(format) {
+    if (format !== "gzip" && format !== "deflate" && format !== "deflate-raw") {
+      throw new TypeError("Unsupported compression format: " + format);
+    }
+    return format;
+  }
+
+  function toUint8Array(data) {
+    if (data instanceof Uint8Array) return data;
+    if (data instanceof ArrayBuffer) return new Uint8Array(data);
+    if (ArrayBuffer.isView(data)) return new Uint8Array(data.buffer, data.byteOffset, data.byteLength);
+    if (Array.isArray(data)) return new Uint8Array(data);
+    throw new TypeError("Expected a Uint8Array, an ArrayBuffer or an Array");
+  }
+
+  function fromJava(bytes) {
+    // Java byte arrays are converted to Uint8Arrays (bulk copy)
+    return bytes instanceof Uint8Array ? bytes : new Uint8Array(bytes);
+  }
+
+  function concat(chunks, length) {
+    if (chunks.length === 1) return chunks[0];
+
+    var ret = new Uint8Array(length);
+    var offset = 0;
+    for (var i = 0; i < chunks.length; i++) {
+      ret.set(chunks[i], offset);
+      offset += chunks[i].length;
+    }
+    return ret;
+  }
+
+  function process(operation, format, data, level) {
+    return fromJava(processJava(operation, checkFormat(format), level === undefined ? null : level, toUint8Array(data)));
+  }
+
+  function processAsync(operation, format, data, level) {
+    try {
+      return processAsyncJava(operation, checkFormat(format), level === undefined ? null : level, toUint8Array(data)).then(fromJava);
+    } catch (e) {
+      return Promise.reject(e);
+    }
+  }
+
+  // Buffering (not streaming) API: chunks are collected with write() and (de)compressed in one go
+  // on close()
+  function createBufferedClass(operation) {
+    var BufferedClass = function(format) {
+      this._format = checkFormat(format);
+      this._chunks = [];
+      this._length = 0;
+      this._closed = false;
+    };
+
+    BufferedClass.prototype.write = function(chunk) {
+      if (this._closed) throw new TypeError("Cannot write after close()");
+      var bytes = toUint8Array(chunk);
+      this._chunks.push(bytes);
+      this._length += bytes.length;
+    };
+
+    BufferedClass.prototype.close = function() {
+      if (this._closed) return Promise.reject(new TypeError("Already closed"));
+      this._closed = true;
+
+      var data = concat(this._chunks, this._length);
+      this._chunks = [];
+      return processAsync(operation, this._format, data);
+    };
+
+    return BufferedClass;
+  }
+
+  globalThis.compression = {
+    compress: function(format, data, level) { return processAsync("compress", format, data, level); },
+    decompress: function(format, data) { return processAsync("decompress", format, data); },
+    compressSync: function(format, data, level) { return process("compress", format, data, level); },
+    decompressSync: function(format, data) { return process("decompress", format, data); },
+    gzip: function(data, level) { return processAsync("compress", "gzip", data, level); },
+    gunzip: function(data) { return processAsync("decompress", "gzip", data); },
+    BufferedCompressor: createBufferedClass("compress"),
+    BufferedDecompressor: createBufferedClass("decompress")
+  };
+})();
+"""
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.extensions
+
+import de.prosiebensat1digital.oasisjsbridge.JsBridge
+import de.prosiebensat1digital.oasisjsbridge.JsBridgeConfig
+
+// Native kernels for Float64Array, Float32Array and Int32Array (see TypedArrayKernels.cpp).
+//
+// The native functions are directly registered in the JS context (no JNI call per invocation) and
+// wrapped by a small JS API which resolves the element type of the given typed arrays.
+internal class TypedArrayKernelsExtension(
+    private val jsBridge: JsBridge,
+    val config: JsBridgeConfig.TypedArrayKernelsConfig
+) {
+    init {
+        jsBridge.registerTypedArrayKernels("TypedArrayKernelsExtension_native")
+
+        // Evaluate JS file
+        jsBridge.evaluateUnsync(typedArrayKernelsJsCode)
+    }
+
+    fun release() {
+        jsBridge.evaluateUnsync("""delete globalThis["TypedArrayKernelsExtension_native"]""")
+        jsBridge.evaluateUnsync("""delete globalThis["TypedArrayKernels"]""")
+    }
+}
+
+const val typedArrayKernelsJsCode: String = """
+(function() {
+  var native = TypedArrayKernelsExtension_native;
+
+  // Must match TypedArrayKernels::ElementType
+  function elementType(array) {
+    if (array instanceof Float64Array) return 0;
+    if (array instanceof Float32Array) return 1;
+    if (array instanceof Int32Array) return 2;
+    throw new TypeError("Expected a Float64Array, a Float32Array or an Int32Array");
+  }
+
+  globalThis.TypedArrayKernels = {
+    sum: function(array) { return native.sum(elementType(array), array); },
+    min: function(array) { return native.min(elementType(array), array); },
+    max: function(array) { return native.max(elementType(array), array); },
+    dot: function(a, b) {
+      var type = elementType(a);
+      if (elementType(b) !== type) throw new TypeError("dot() expects two typed arrays of the same type");
+      return native.dot(type, a, b);
+    },
+    // In place
+    scale: function(array, factor) {
+      native.scale(elementType(array), array, factor);
+      return array;
+    },
+    // Returns an Int32Array with binCount bins, values outside of [min, max] are ignored
+    histogram: function(array, binCount, min, max) {
+      var bins = new Int32Array(binCount);
+      native.histogram(elementType(array), array, bins, min, max);
+      return bins;
+    },
+    // In place, same order as TypedArray.prototype.sort()
+    sort: function(array) {
+      native.sort(elementType(array), array);
+      return array;
+    }
+  };
+})();
+"""
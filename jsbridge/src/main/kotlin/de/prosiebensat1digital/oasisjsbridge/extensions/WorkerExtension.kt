@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.extensions
+
+import android.content.Context
+import de.prosiebensat1digital.oasisjsbridge.*
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
+import kotlinx.coroutines.launch
+import timber.log.Timber
+
+// Support for Worker: each worker is a separate JsBridge instance (with its own JS runtime and JS
+// thread) evaluating the given module.
+//
+// Messages are serialized in the JS thread of the sender (structured clone via JS_WriteObject with
+// QuickJS, JSON with Duktape) and deserialized in the JS thread of the receiver. ArrayBuffers given
+// in the transfer list are detached from the sender while SharedArrayBuffers (QuickJS) share the
+// same memory in both contexts.
+internal class WorkerExtension(
+    private val jsBridge: JsBridge,
+    val config: JsBridgeConfig.WorkerConfig,
+    private val context: Context
+) {
+    private val workers = ConcurrentHashMap<Int, Worker>()
+    private val workerCounter = AtomicInteger(0)
+
+    // Set up by workerJsCode
+    private var dispatchMessage: ((id: Int, message: JsValue) -> Unit)? = null
+    private var dispatchError: ((id: Int, message: String) -> Unit)? = null
+    private var removeWorker: ((id: Int) -> Unit)? = null
+
+    init {
+        // Register WorkerExtension_*_java() helpers
+        JsValue.createJsToJavaProxyFunction3(jsBridge, ::javaSetUp)
+            .assignToGlobal("WorkerExtension_setUp_java")
+        JsValue.createJsToJavaProxyFunction1(jsBridge, ::javaCreate)
+            .assignToGlobal("WorkerExtension_create_java")
+        JsValue.createJsToJavaProxyFunction3(jsBridge, ::javaPostMessage)
+            .assignToGlobal("WorkerExtension_postMessage_java")
+        JsValue.createJsToJavaProxyFunction1(jsBridge, ::javaTerminate)
+            .assignToGlobal("WorkerExtension_terminate_java")
+
+        // Evaluate JS file
+        jsBridge.evaluateUnsync(workerJsCode)
+    }
+
+    fun release() {
+        jsBridge.evaluateUnsync("""delete globalThis["WorkerExtension_create_java"]""")
+        jsBridge.evaluateUnsync("""delete globalThis["WorkerExtension_postMessage_java"]""")
+        jsBridge.evaluateUnsync("""delete globalThis["WorkerExtension_terminate_java"]""")
+
+        workers.values.forEach { it.workerBridge.release() }
+        workers.clear()
+        dispatchMessage = null
+        dispatchError = null
+        removeWorker = null
+    }
+
+    private fun javaSetUp(
+        dispatchMessage: (id: Int, message: JsValue) -> Unit,
+        dispatchError: (id: Int, message: String) -> Unit,
+        removeWorker: (id: Int) -> Unit
+    ) {
+        this.dispatchMessage = dispatchMessage
+        this.dispatchError = dispatchError
+        this.removeWorker = removeWorker
+    }
+
+    private fun javaCreate(moduleName: String): Int {
+        if (workers.size >= config.maxWorkers) {
+            throw IllegalStateException("Cannot create more than ${config.maxWorkers} workers")
+        }
+
+        val moduleLoader = config.moduleLoader ?: jsBridge.jsModuleLoaderFunc
+            ?: throw IllegalStateException("Cannot create worker $moduleName: no module loader has been set")
+
+        val id = workerCounter.incrementAndGet()
+        val worker = Worker(id, moduleName, JsBridge(workerJsBridgeConfig(), context))
+        workers[id] = worker
+        worker.start(moduleLoader)
+
+        return id
+    }
+
+    // Atomics.wait() may only block the worker threads
+    private fun workerJsBridgeConfig() = config.workerJsBridgeConfig().apply {
+        runtimeConfig.canBlock = true
+    }
+
+    private fun javaPostMessage(id: Int, message: JsValue, transferList: JsValue?) {
+        try {
+            // Messages posted to a terminated worker are dropped
+            val worker = workers[id] ?: return
+            worker.postMessage(jsBridge.serializeJsValue(message, transferList))
+        } finally {
+            message.release()
+        }
+    }
+
+    private fun javaTerminate(id: Int) {
+        workers.remove(id)?.workerBridge?.release()
+    }
+
+    private inner class Worker(val id: Int, val moduleName: String, val workerBridge: JsBridge) {
+        // Set up by workerScopeJsCode
+        private var dispatchWorkerMessage: ((message: JsValue) -> Unit)? = null
+
+        fun start(moduleLoader: (moduleName: String) -> String) {
+            workerBridge.registerErrorListener(object : JsBridge.ErrorListener() {
+                override fun onError(error: JsBridgeError) {
+                    Timber.w("Error in worker $id ($moduleName): $error")
+                    jsBridge.launch {
+                        dispatchError?.invoke(id, error.message ?: error.toString())
+                    }
+                }
+            })
+
+            JsValue.createJsToJavaProxyFunction1(workerBridge) { func: (message: JsValue) -> Unit ->
+                dispatchWorkerMessage = func
+            }.assignToGlobal("WorkerExtension_setUp_java")
+            JsValue.createJsToJavaProxyFunction2(workerBridge, ::javaPostMessageToParent)
+                .assignToGlobal("WorkerExtension_postMessage_java")
+            JsValue.createJsToJavaProxyFunction0(workerBridge, ::javaClose)
+                .assignToGlobal("WorkerExtension_close_java")
+            workerBridge.evaluateUnsync(workerScopeJsCode)
+
+            // Load and evaluate the module in the worker thread
+            workerBridge.setJsModuleLoader(func = moduleLoader)
+            workerBridge.launch {
+                val type = if (BuildConfig.FLAVOR == "duktape") JsBridge.JsFileEvaluationType.Global else JsBridge.JsFileEvaluationType.Module
+                workerBridge.evaluateFileContent(moduleLoader(moduleName), moduleName, type)
+            }
+        }
+
+        // Called in the JS thread of the parent
+        fun postMessage(data: ByteArray) {
+            var isDeserializing = false
+            workerBridge.launch {
+                isDeserializing = true
+                val message = workerBridge.deserializeJsValue(data)
+                dispatchWorkerMessage?.invoke(message)
+                message.release()
+            }.invokeOnCompletion {
+                // Worker terminated or released before receiving the message
+                if (!isDeserializing) {
+                    jsBridge.launch { jsBridge.releaseSerializedJsValue(data) }
+                }
+            }
+        }
+
+        // Called in the JS thread of the worker (close() in the worker scope)
+        private fun javaClose() {
+            jsBridge.launch {
+                // Also remove the Worker object from the parent context
+                removeWorker?.invoke(id)
+                javaTerminate(id)
+            }
+        }
+
+        // Called in the JS thread of the worker
+        private fun javaPostMessageToParent(message: JsValue, transferList: JsValue?) {
+            val data = try {
+                workerBridge.serializeJsValue(message, transferList)
+            } finally {
+                message.release()
+            }
+
+            jsBridge.launch {
+                if (!workers.containsKey(id)) {
+                    jsBridge.releaseSerializedJsValue(data)
+                    return@launch
+                }
+
+                val parentMessage = jsBridge.deserializeJsValue(data)
+                dispatchMessage?.invoke(id, parentMessage)
+                parentMessage.release()
+            }
+        }
+    }
+}
+
+// Evaluated in the parent context
+const val workerJsCode: String = """
+(function() {
+  var createJava = WorkerExtension_create_java;
+  var postMessageJava = WorkerExtension_postMessage_java;
+  var terminateJava = WorkerExtension_terminate_java;
+  var workers = {};
+
+  function checkTransferList(transfer) {
+    if (transfer === undefined || transfer === null) return null;
+    if (!Array.isArray(transfer)) throw new TypeError("The transfer list must be an array");
+    for (var i = 0; i < transfer.length; i++) {
+      if (!(transfer[i] instanceof ArrayBuffer)) throw new TypeError("Only ArrayBuffers can be transferred");
+    }
+    return transfer;
+  }
+
+  WorkerExtension_setUp_java(function(id, message) {
+    var worker = workers[id];
+    if (worker && typeof worker.onmessage === "function") worker.onmessage({ data: message });
+  }, function(id, errorMessage) {
+    var worker = workers[id];
+    if (worker && typeof worker.onerror === "function") worker.onerror({ message: errorMessage });
+  }, function(id) {
+    delete workers[id];
+  });
+  delete globalThis.WorkerExtension_setUp_java;
+
+  var Worker = function(moduleName) {
+    this._id = createJava(String(moduleName));
+    this.onmessage = null;
+    this.onerror = null;
+    workers[this._id] = this;
+  };
+
+  Worker.prototype.postMessage = function(message, transfer) {
+    postMessageJava(this._id, message, checkTransferList(transfer));
+  };
+
+  Worker.prototype.terminate = function() {
+    delete workers[this._id];
+    terminateJava(this._id);
+  };
+
+  globalThis.Worker = Worker;
+})();
+"""
+
+// Evaluated in the worker context
+const val workerScopeJsCode: String = """
+(function() {
+  var postMessageJava = WorkerExtension_postMessage_java;
+  var closeJava = WorkerExtension_close_java;
+
+  function checkTransferList(transfer) {
+    if (transfer === undefined || transfer === null) return null;
+    if (!Array.isArray(transfer)) throw new TypeError("The transfer list must be an array");
+    for (var i = 0; i < transfer.length; i++) {
+      if (!(transfer[i] instanceof ArrayBuffer)) throw new TypeError("Only ArrayBuffers can be transferred");
+    }
+    return transfer;
+  }
+
+  WorkerExtension_setUp_java(function(message) {
+    if (typeof globalThis.onmessage === "function") globalThis.onmessage({ data: message });
+  });
+  delete globalThis.WorkerExtension_setUp_java;
+
+  globalThis.self = globalThis;
+  globalThis.onmessage = null;
+  globalThis.postMessage = function(message, transfer) {
+    postMessageJava(message, checkTransferList(transfer));
+  };
+  globalThis.close = function() {
+    closeJava();
+  };
+})();
+"""
@@ -16,27 +16,66 @@
 package de.prosiebensat1digital.oasisjsbridge.extensions
 
 import de.prosiebensat1digital.oasisjsbridge.*
+import java.io.File
 import java.net.SocketTimeoutException
+import java.nio.charset.Charset
 import java.util.*
 import java.util.concurrent.TimeUnit
+import kotlinx.coroutines.CompletableDeferred
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import kotlinx.coroutines.withTimeoutOrNull
 import okhttp3.*
 import okhttp3.HttpUrl.Companion.toHttpUrlOrNull
 import okhttp3.MediaType.Companion.toMediaTypeOrNull
 import okhttp3.RequestBody.Companion.toRequestBody
 import timber.log.Timber
 
+// (responseInfo, responseText, error, jsonResponse)
+private typealias XhrCallback = (JsonObjectWrapper, String?, String, JsValue?) -> Unit
+
 internal class XMLHttpRequestExtension(
     private val jsBridge: JsBridge,
     val config: JsBridgeConfig.XMLHttpRequestConfig
 ) {
-    private var okHttpClient = config.okHttpClient ?: OkHttpClient.Builder().build()
+    companion object {
+        // OkHttp caches must not share a directory: one instance per directory for all JsBridges
+        private val sharedCaches = mutableMapOf<File, Cache>()
+
+        // Single-flight: identical GET requests (same URL + headers) which are in progress, per
+        // OkHttpClient (interceptors, cookie jars or authenticators of other clients might lead
+        // to different responses)
+        private val inFlightRequests = WeakHashMap<OkHttpClient, MutableMap<String, CompletableDeferred<XhrResponse>>>()
+
+        private fun getSharedCache(directory: File, maxSize: Long): Cache = synchronized(sharedCaches) {
+            sharedCaches.getOrPut(directory.absoluteFile) { Cache(directory, maxSize) }
+        }
+    }
+
+    private class XhrResponse(val info: JsonObjectWrapper, private val body: ByteArray?, private val charset: Charset) {
+        val text: String? by lazy {
+            body?.let { String(it, charset).removePrefix("\uFEFF") }
+        }
+
+        // JSON response parsed outside of the JS thread (only once for de-duplicated requests)
+        val jsonTape: ByteArray? by lazy {
+            if (body == null || charset != Charsets.UTF_8) null
+            else JsBridge.parseJsonTape(body)
+        }
+    }
+
+    // Client given in the config (shared by the JsBridge instances using it)
+    private val baseOkHttpClient = config.okHttpClient ?: OkHttpClient.Builder().build()
+
+    private val okHttpClient = baseOkHttpClient.let { client ->
+        val cacheDirectory = config.cacheDirectory ?: return@let client
+        client.newBuilder().cache(getSharedCache(cacheDirectory, config.cacheMaxSize)).build()
+    }
 
     init {
         // Register XMLHttpRequestJavaHelper_send()
-        JsValue.createJsToJavaProxyFunction6(jsBridge, ::javaSend)
+        JsValue.createJsToJavaProxyFunction7(jsBridge, ::javaSend)
             .assignToGlobal("XMLHttpRequestExtension_send_java")
 
         // Evaluate JS file
@@ -53,100 +92,44 @@ internal class XMLHttpRequestExtension(
         headers: JsonObjectWrapper,
         timeoutMs: Long,
         data: String?,
-        cb: (JsonObjectWrapper, String, String) -> Unit
+        responseType: String,
+        cb: XhrCallback
     ) {
-        Timber.v("javaSend($httpMethod, $url, $headers, $timeoutMs)")
+        Timber.v("javaSend($httpMethod, $url, $headers, $timeoutMs, $responseType)")
+
+        val isJsonResponse = responseType == "json"
+
+        val request = try {
+            createRequest(httpMethod, url, headers, data)
+        } catch (t: Throwable) {
+            Timber.d("XHR error ($httpMethod $url): $t")
+            jsBridge.launch {
+                complete(cb, null, null, t.message ?: "unknown XHR error")
+            }
+            return
+        }
 
         jsBridge.launch(Dispatchers.IO) {
             // Load URL and evaluate JS string
-            var responseInfo: JsonObjectWrapper? = null
+            var response: XhrResponse? = null
+            var jsonTape: ByteArray? = null
             var errorString: String? = null
-            var responseText: String? = null
             try {
-                // Validate HTTP method
-                when (httpMethod.lowercase(Locale.ROOT)) {
-                    "get", "post", "put", "delete", "patch" -> Unit
-                    else -> throw Throwable("Unsupported http method: $httpMethod")
-                }
-
-                val requestHeadersBuilder = Headers.Builder()
-
-                // Add each request header (given as [key, value] arrays)
-                val headersPayload = headers.toPayload() as? PayloadArray
-                if (headersPayload != null) {
-                    for (i in 0 until headersPayload.count) {
-                        val keyValue = headersPayload.getArray(i)
-                        val key = keyValue?.getString(0)
-                        val value = keyValue?.getString(1)
-                        if (key != null && value != null) {
-                            requestHeadersBuilder.add(key, value)
-                        } else {
-                            Timber.w("Invalid header keyValue: $keyValue")
-                        }
-                    }
-                }
-
-                // Add user agent header if not set
-                if (requestHeadersBuilder["user-agent"] == null) {
-                    config.userAgent?.let { requestHeadersBuilder.add("User-Agent", it) }
-                }
-                val requestHeaders = requestHeadersBuilder.build()
-
-                // Request body
-                val contentType = requestHeaders["content-type"] ?: ""
-                val requestBody = when {
-                    /* in specific case when we want to send an empty post/put request,
-                     we should instead send request with body with no data.
-                     Otherwise, OkHttp will throw an exception:
-                     "Method post/put must have a request body */
-                    data == null && httpMethod.lowercase(Locale.ROOT) in listOf("post", "put") -> {
-                        "".toRequestBody(contentType.toMediaTypeOrNull())
-                    }
-                    else -> {
-                        data?.toRequestBody(contentType.toMediaTypeOrNull())
-                    }
-                }
-
                 Timber.d("Performing XHR request (query: $url)...")
 
-                // Send request via OkHttp
-                val httpUrl = url.toHttpUrlOrNull() ?: throw Throwable("Cannot parse URL: $url")
-                val request = Request.Builder()
-                    .url(httpUrl)
-                    .headers(requestHeaders)
-                    .method(httpMethod.uppercase(Locale.ROOT), requestBody)
-                    .build()
-                val response = okHttpClient
-                    .newBuilder()
-                    .callTimeout(timeoutMs, TimeUnit.MILLISECONDS)
-                    .build()
-                    .newCall(request)
-                    .execute()
-
-                // Convert header mutlimap (key -> [value1, value2, ...]) into a list of [key, value] arrays
-                val headerKeyValues = response
-                    .headers
-                    .toMultimap()
-                    .flatMap { (key, values) ->
-                        values
-                            .map { value ->
-                                arrayOf(
-                                    key,
-                                    value.replace("""([^\])"""", """$1\"""")
-                                )
-                            }
-                    }
-
-                responseInfo = JsonObjectWrapper(
-                    "statusCode" to response.code,
-                    "statusText" to response.message,
-                    "responseHeaders" to headerKeyValues.toTypedArray()
-                )
-                responseText = response.body?.string()
+                response = if (config.deduplicateRequests && request.method == "GET") {
+                    executeShared(request, timeoutMs)
+                } else {
+                    execute(request, timeoutMs)
+                }
 
                 Timber.d("Successfully fetched XHR response (query: $url)")
-                Timber.v("-> responseInfo = $responseInfo")
-                Timber.v("-> request headers = $requestHeaders")
+                Timber.v("-> responseInfo = ${response.info}")
+                Timber.v("-> request headers = ${request.headers}")
+
+                if (isJsonResponse) {
+                    jsonTape = response.jsonTape
+                }
             } catch (e: SocketTimeoutException) {
                 Timber.d("XHR timeout ($httpMethod $url): $e")
                 errorString = "timeout"
@@ -155,14 +138,169 @@ internal class XMLHttpRequestExtension(
                 errorString = t.message ?: "unknown XHR error"
             }
 
-            cb(responseInfo ?: JsonObjectWrapper(), responseText ?: "", errorString ?: "")
+            complete(cb, response, jsonTape, errorString)
+        }
+    }
 
-            withContext(jsBridge.coroutineContext) {
-                jsBridge.processPromiseQueue()
+    // The response text is null when the parsed JSON response is given (only if the JSON tape
+    // could be created, otherwise the JSON response is parsed via JSON.parse())
+    private suspend fun complete(cb: XhrCallback, response: XhrResponse?, jsonTape: ByteArray?, errorString: String?) {
+        withContext(jsBridge.coroutineContext) {
+            val jsonValue = jsonTape?.let {
+                try {
+                    jsBridge.jsonTapeToJsValue(it)
+                } catch (t: Throwable) {
+                    Timber.w("Could not convert XHR JSON response: $t")
+                    null
+                }
             }
+
+            val responseText = if (jsonValue != null) null else response?.text ?: ""
+            cb(response?.info ?: JsonObjectWrapper(), responseText, errorString ?: "", jsonValue)
+            jsonValue?.release()
+
+            jsBridge.processPromiseQueue()
         }
     }
 
+    private fun createRequest(httpMethod: String, url: String, headers: JsonObjectWrapper, data: String?): Request {
+        // Validate HTTP method
+        when (httpMethod.lowercase(Locale.ROOT)) {
+            "get", "post", "put", "delete", "patch" -> Unit
+            else -> throw Throwable("Unsupported http method: $httpMethod")
+        }
+
+        val requestHeadersBuilder = Headers.Builder()
+
+        // Add each request header (given as [key, value] arrays)
+        val headersPayload = headers.toPayload() as? PayloadArray
+        if (headersPayload != null) {
+            for (i in 0 until headersPayload.count) {
+                val keyValue = headersPayload.getArray(i)
+                val key = keyValue?.getString(0)
+                val value = keyValue?.getString(1)
+                if (key != null && value != null) {
+                    requestHeadersBuilder.add(key, value)
+                } else {
+                    Timber.w("Invalid header keyValue: $keyValue")
+                }
+            }
+        }
+
+        // Add user agent header if not set
+        if (requestHeadersBuilder["user-agent"] == null) {
+            config.userAgent?.let { requestHeadersBuilder.add("User-Agent", it) }
+        }
+        val requestHeaders = requestHeadersBuilder.build()
+
+        // Request body
+        val contentType = requestHeaders["content-type"] ?: ""
+        val requestBody = when {
+            /* in specific case when we want to send an empty post/put request,
+             we should instead send request with body with no data.
+             Otherwise, OkHttp will throw an exception:
+             "Method post/put must have a request body */
+            data == null && httpMethod.lowercase(Locale.ROOT) in listOf("post", "put") -> {
+                "".toRequestBody(contentType.toMediaTypeOrNull())
+            }
+            else -> {
+                data?.toRequestBody(contentType.toMediaTypeOrNull())
+            }
+        }
+
+        val httpUrl = url.toHttpUrlOrNull() ?: throw Throwable("Cannot parse URL: $url")
+        return Request.Builder()
+            .url(httpUrl)
+            .headers(requestHeaders)
+            .method(httpMethod.uppercase(Locale.ROOT), requestBody)
+            .build()
+    }
+
+    // Execute the request or wait for the response of an identical request which is already in
+    // progress (possibly from another JsBridge instance)
+    private suspend fun executeShared(request: Request, timeoutMs: Long): XhrResponse {
+        // The cache directory is part of the key because it is not part of the base client
+        val key = "${config.cacheDirectory?.absolutePath}\n${request.url}\n${request.headers}"
+
+        var isOwner = false
+        val deferred = synchronized(inFlightRequests) {
+            inFlightRequests.getOrPut(baseOkHttpClient) { mutableMapOf() }.getOrPut(key) {
+                isOwner = true
+                CompletableDeferred()
+            }
+        }
+
+        if (!isOwner) {
+            Timber.d("Waiting for identical XHR request in progress (query: ${request.url})")
+            if (timeoutMs <= 0L) {
+                return deferred.await()
+            }
+            return withTimeoutOrNull(timeoutMs) { deferred.await() }
+                ?: throw SocketTimeoutException("timeout")
+        }
+
+        try {
+            return execute(request, timeoutMs).also { deferred.complete(it) }
+        } catch (t: Throwable) {
+            deferred.completeExceptionally(t)
+            throw t
+        } finally {
+            synchronized(inFlightRequests) {
+                val clientRequests = inFlightRequests[baseOkHttpClient]
+                clientRequests?.remove(key)
+                if (clientRequests?.isEmpty() == true) {
+                    inFlightRequests.remove(baseOkHttpClient)
+                }
+            }
+        }
+    }
+
+    private fun execute(request: Request, timeoutMs: Long): XhrResponse {
+        // Send request via OkHttp
+        return okHttpClient
+            .newBuilder()
+            .callTimeout(timeoutMs, TimeUnit.MILLISECONDS)
+            .build()
+            .newCall(request)
+            .execute()
+            .use(::toXhrResponse)
+    }
+
+    private fun toXhrResponse(response: Response): XhrResponse {
+        // Convert header mutlimap (key -> [value1, value2, ...]) into a list of [key, value] arrays
+        val headerKeyValues = response
+            .headers
+            .toMultimap()
+            .flatMap { (key, values) ->
+                values
+                    .map { value ->
+                        arrayOf(
+                            key,
+                            value.replace("""([^\])"""", """$1\"""")
+                        )
+                    }
+            }
+
+        val responseInfo = JsonObjectWrapper(
+            "statusCode" to response.code,
+            "statusText" to response.message,
+            "responseHeaders" to headerKeyValues.toTypedArray()
+        )
+        val body = response.body?.bytes()
+        return XhrResponse(responseInfo, body, getResponseCharset(body, response.body?.contentType()))
+    }
+
+    // Same as OkHttp ResponseBody.string(): BOM, then Content-Type charset, then UTF-8
+    private fun getResponseCharset(body: ByteArray?, contentType: MediaType?): Charset {
+        fun startsWith(vararg bom: Int) = body != null && body.size >= bom.size && bom.indices.all { body[it] == bom[it].toByte() }
+
+        return when {
+            startsWith(0xEF, 0xBB, 0xBF) -> Charsets.UTF_8
+            startsWith(0xFE, 0xFF) -> Charsets.UTF_16BE
+            startsWith(0xFF, 0xFE) -> Charsets.UTF_16LE
+            else -> contentType?.charset(Charsets.UTF_8) ?: Charsets.UTF_8
+        }
+    }
 }
 
 /*
@@ -296,8 +434,8 @@ XMLHttpRequest.prototype.send = function(data) {
   }
 
   var that = this;
-  sendJava(this._httpMethod, this._url, this._requestHeaders, this.timeout, data || null, function(responseInfo, responseText, error) {
-    that._send_java_callback(responseInfo, responseText, error);
+  sendJava(this._httpMethod, this._url, this._requestHeaders, this.timeout, data || null, this.responseType || "", function(responseInfo, responseText, error, jsonResponse) {
+    that._send_java_callback(responseInfo, responseText, error, jsonResponse);
   });
 };
 
@@ -311,7 +449,8 @@ XMLHttpRequest.prototype.abort = function() {
 }
 
 // responseInfo: {statusCode, statusText, responseHeaders}
-XMLHttpRequest.prototype._send_java_callback = function(responseInfo, responseText, error) {
+// responseText: null if the JSON response has already been parsed (jsonResponse)
+XMLHttpRequest.prototype._send_java_callback = function(responseInfo, responseText, error, jsonResponse) {
   //console.log("XMLHttpRequest._send_java_callback");
   //console.log("- responseInfo =", JSON.stringify(responseInfo));
   //console.log("- responseText =", responseText);
@@ -349,7 +488,7 @@ XMLHttpRequest.prototype._send_java_callback = function(responseInfo, responseTe
   if (error) {
     this.responseText = error;
   } else {
-    this.responseText = responseText;
+    this.responseText = responseText === null ? "" : responseText;
 
     switch (this.responseType) {
       case "":
@@ -364,6 +503,10 @@ XMLHttpRequest.prototype._send_java_callback = function(responseInfo, responseTe
         this.responseXML = this.responseText;
         break;
       case "json":
+        if (responseText === null) {
+            this.response = jsonResponse;
+            break;
+        }
         try {
             this.response = JSON.parse(responseText);
         }